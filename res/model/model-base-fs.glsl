@@ -1,62 +1,28 @@
 #version 400
 #extension GL_ARB_shading_language_include : require
 #include "/model-globals.glsl"
+#include "/model-blocks.glsl"
 
 
-uniform vec3 worldCameraPosition;
-uniform vec3 worldLightPosition;
-uniform bool wireframeEnabled;
-uniform vec4 wireframeLineColor;
-uniform mat3 normalMatrix;
+// Texture, defined in model-textures-bound-fs.glsl or model-textures-bindless-fs.glsl
+#define DIFFUSE_TEXTURE 0u
+#define AMBIENT_TEXTURE 1u
+#define SPECULAR_TEXTURE 2u
+#define NORMAL_TEXTURE 3u
+#define TANGENT_TEXTURE 4u
 
-
-// Texture
-uniform sampler2D diffuseTexture;
-uniform sampler2D ambientTexture;
-uniform sampler2D specularTexture;
-uniform sampler2D normalTexture;
-uniform sampler2D tangentTexture;
-uniform bool diffuseTexBool;
-uniform bool ambientTexBool;
-uniform bool specularTexBool;
-uniform bool normalTexBool;
-uniform bool tangentTexBool;
-
-// Procedual Bump mapping
-uniform bool procedualBumpMap;
-uniform float A;
-uniform float k;
-
-
-// Shading type
-uniform bool blinnPhong;
-uniform bool toonShading;
-
-
-// Blinn-Phong Shading
-uniform vec4 ambientColor;
-uniform vec4 specularColor;
-uniform vec4 diffuseColor;
-uniform float specularExponent;
-uniform float diffuseIntensity;
-uniform float ambientIntensity;
-uniform float specularIntensity;
+vec4 materialTexture(uint materialIndex, uint slot, vec2 texCoord);
 
 // Skybox and reflections/refractions
 uniform samplerCube skybox;
-uniform bool reflectionBool;
-uniform bool onlyReflection;
-uniform bool ambientReflection;
-uniform bool refractionBool;
-uniform float refractionRatio;
 
 in fragmentData
 {
 	vec3 position;
 	vec3 normal;
 	vec2 texCoord;
-	vec3 tangent;
-	noperspective vec3 edgeDistance;
+	vec4 tangent;
+	flat uint materialIndex;
 } fragment;
 
 out vec4 fragColor;
@@ -128,9 +94,9 @@ vec4 calculateModel(vec3 lightDirection, vec3 viewDirection, vec3 normal){
 	vec4 ambientTextureColor = vec4(1,1,1,1);
 	vec4 specularTextureColor = vec4(1,1,1,1);
 	
-	if(diffuseTexBool)	diffuseTextureColor = texture(diffuseTexture, fragment.texCoord);
-	if(ambientTexBool)	ambientTextureColor = texture(ambientTexture, fragment.texCoord);
-	if(specularTexBool) specularTextureColor = texture(specularTexture, fragment.texCoord);
+	if(diffuseTexBool && hasTexture(fragment.materialIndex, DIFFUSE_TEXTURE_BIT))	diffuseTextureColor = materialTexture(fragment.materialIndex, DIFFUSE_TEXTURE, fragment.texCoord);
+	if(ambientTexBool && hasTexture(fragment.materialIndex, AMBIENT_TEXTURE_BIT))	ambientTextureColor = materialTexture(fragment.materialIndex, AMBIENT_TEXTURE, fragment.texCoord);
+	if(specularTexBool && hasTexture(fragment.materialIndex, SPECULAR_TEXTURE_BIT)) specularTextureColor = materialTexture(fragment.materialIndex, SPECULAR_TEXTURE, fragment.texCoord);
 
 	if(ambientReflection) {
 		result = diffuse*diffuseTextureColor + specular*specularTextureColor + reflectionColor;
@@ -166,30 +132,23 @@ void main()
 {	
 	vec4 result = vec4(0.5,0.5,0.5,1.0);
 
-	if (wireframeEnabled)
-	{
-		float smallestDistance = min(min(fragment.edgeDistance[0],fragment.edgeDistance[1]),fragment.edgeDistance[2]);
-		float edgeIntensity = exp2(-1.0*smallestDistance*smallestDistance);
-		result.rgb = mix(result.rgb,wireframeLineColor.rgb,edgeIntensity*wireframeLineColor.a);
-		fragColor = result;
-	}
-
 	vec3 normal = normalize(fragment.normal);
 	vec3 lightDirection = normalize(worldLightPosition - fragment.position);
 	vec3 viewDirection = normalize(worldCameraPosition - fragment.position);
 
-	vec3 tangent = normalize(fragment.tangent);
-	vec3 bitangent = cross(tangent, fragment.normal);
+	// per-vertex tangent, with the sign of the bitangent in w
+	vec3 tangent = normalize(fragment.tangent.xyz);
+	vec3 bitangent = fragment.tangent.w * cross(fragment.normal, tangent);
 
 	// Normal Texture
-	if(normalTexBool) {
-		normal = texture(normalTexture, fragment.texCoord).rgb;
+	if(normalTexBool && hasTexture(fragment.materialIndex, NORMAL_TEXTURE_BIT)) {
+		normal = materialTexture(fragment.materialIndex, NORMAL_TEXTURE, fragment.texCoord).rgb;
 		normal = normalize(normal * 2.0 - 1.0);
 	// Tangent Texture
 	} 
-	if (tangentTexBool) {
-		normal = normalize(texture(normalTexture, fragment.texCoord).rgb * 2 - 1);
-		vec3 texNormal = texture(tangentTexture, fragment.texCoord).rgb * 2 - 1;
+	if (tangentTexBool && hasTexture(fragment.materialIndex, TANGENT_TEXTURE_BIT)) {
+		normal = normalize(materialTexture(fragment.materialIndex, NORMAL_TEXTURE, fragment.texCoord).rgb * 2 - 1);
+		vec3 texNormal = materialTexture(fragment.materialIndex, TANGENT_TEXTURE, fragment.texCoord).rgb * 2 - 1;
 		vec3 newNormal;
 		mat3 TBN = mat3(tangent, bitangent, normal);
 		newNormal = TBN * texNormal;
@@ -1,26 +1,19 @@
 #version 400
 #extension GL_ARB_shading_language_include : require
 #include "/model-globals.glsl"
+#include "/model-blocks.glsl"
 
+// the previous pipeline, which recomputes the tangent per face -- only used to compare frame times with the default programs
 layout(triangles) in;
 layout(triangle_strip, max_vertices = 3) out;
 
-uniform vec2 viewportSize;
-uniform sampler2D tangentTexture;
-uniform sampler2D normalTexture;
-uniform mat4 modelViewProjectionMatrix;
-uniform mat4 modelViewMatrix;
-uniform mat4 viewMatrix;
-uniform mat4 modelLightMatrix;
-uniform mat3 normalMatrix;
-uniform vec3 worldCameraPosition;
-uniform vec3 worldLightPosition;
-
-in vertexData
+in fragmentData
 {
 	vec3 position;
 	vec3 normal;
 	vec2 texCoord;
+	vec4 tangent;
+	flat uint materialIndex;
 } vertices[];
 
 out fragmentData
@@ -28,10 +21,13 @@ out fragmentData
 	vec3 position;
 	vec3 normal;
 	vec2 texCoord;
-	vec3 tangent;
-	noperspective vec3 edgeDistance;
+	vec4 tangent;
+	flat uint materialIndex;
 } fragment;
 
+// passed through unchanged, so that the depth pre-pass matches exactly
+invariant gl_Position;
+
 
 vec3 calculateTangent(vec3 edge1, vec3 edge2, vec2 deltaUV1, vec2 deltaUV2){
 	float f = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
@@ -44,22 +40,6 @@ vec3 calculateTangent(vec3 edge1, vec3 edge2, vec2 deltaUV1, vec2 deltaUV2){
 
 void main(void)
 {
-	vec2 p[3];
-	vec2 v[3];
-
-	vec3 tangent1; 
-	vec3 tangent2; 
-	vec3 tangent3; 
-	vec3 bitangent;
-
-
-	for (int i=0;i<3;i++)
-		p[i] = 0.5 * viewportSize *  gl_in[i].gl_Position.xy/gl_in[i].gl_Position.w;
-
-	v[0] = p[2]-p[1];
-	v[1] = p[2]-p[0];
-	v[2] = p[1]-p[0];
-
 	vec3 v0 = vertices[0].position;
 	vec3 v1 = vertices[1].position;
 	vec3 v2 = vertices[2].position;
@@ -68,10 +48,8 @@ void main(void)
 	vec2 st1 = vertices[1].texCoord;
 	vec2 st2 = vertices[2].texCoord;
 
-	tangent1 = calculateTangent(v1 - v0, v2 - v0, st1 - st0, st2 - st0);
-
-	float area = abs(v[1].x*v[2].y - v[1].y * v[2].x);	
-
+	// a sign of -1 gives the bitangent cross(tangent, normal) used with per-face tangents
+	vec4 tangent = vec4(calculateTangent(v1 - v0, v2 - v0, st1 - st0, st2 - st0), -1.0);
 
 	for (int i=0;i<3;i++)
 	{
@@ -79,13 +57,11 @@ void main(void)
 		fragment.position = vertices[i].position;
 		fragment.normal = vertices[i].normal;
 		fragment.texCoord = vertices[i].texCoord;
-		fragment.tangent = tangent1;
-		vec3 ed = vec3(0.0);
-		ed[i] = area / length(v[i]);
-		fragment.edgeDistance = ed;
+		fragment.tangent = tangent;
+		fragment.materialIndex = vertices[i].materialIndex;
 
 		EmitVertex();
 	}
 
 	EndPrimitive();
-}
\ No newline at end of file
+}
@@ -1,31 +1,41 @@
 #version 400
 #extension GL_ARB_shading_language_include : require
 #include "/model-globals.glsl"
+#include "/model-blocks.glsl"
 
-uniform mat4 modelViewProjectionMatrix;
 uniform mat4 transformation;
+uniform uint groupMaterialIndex;
 uniform float explotion;
 
-in vec3 position;
-in vec3 normal;
-in vec2 texCoord;
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+layout(location = 2) in vec2 texCoord;
+layout(location = 3) in vec4 tangent;
 
 
-out vertexData
+out fragmentData
 {
 	vec3 position;
 	vec3 normal;
 	vec2 texCoord;
+	vec4 tangent;
+	flat uint materialIndex;
 } vertex;
 
+// the depth pre-pass computes the same positions in another program
+invariant gl_Position;
+
 void main()
 {
-	vec4 pos = modelViewProjectionMatrix*transformation*vec4(position,1.0);
+	vec3 modelPosition = decodePosition(position);
+	vec4 pos = modelViewProjectionMatrix*transformation*vec4(modelPosition,1.0);
 
-	vertex.position = position; 
+	vertex.position = modelPosition;
 	vertex.normal = normal;
 	vertex.texCoord = texCoord;
+	vertex.tangent = tangent;
+	vertex.materialIndex = groupMaterialIndex;
 
 	
 	gl_Position = pos;
-}
\ No newline at end of file
+}
@@ -0,0 +1,16 @@
+#version 430
+#extension GL_ARB_shading_language_include : require
+#extension GL_ARB_shader_draw_parameters : require
+#include "/model-globals.glsl"
+#include "/model-blocks.glsl"
+#include "/model-groups.glsl"
+
+// depth-only version of model-batch-vs.glsl, reading the tightly packed positions
+layout(location = 0) in vec3 position;
+
+invariant gl_Position;
+
+void main()
+{
+	gl_Position = groupPosition(groups[gl_BaseInstanceARB], decodePosition(position));
+}
@@ -0,0 +1,42 @@
+#version 430
+#extension GL_ARB_shading_language_include : require
+#extension GL_ARB_shader_draw_parameters : require
+#include "/model-globals.glsl"
+#include "/model-blocks.glsl"
+#include "/model-groups.glsl"
+
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 normal;
+layout(location = 2) in vec2 texCoord;
+layout(location = 3) in vec4 tangent;
+
+
+out fragmentData
+{
+	vec3 position;
+	vec3 normal;
+	vec2 texCoord;
+	vec4 tangent;
+	flat uint materialIndex;
+} vertex;
+
+// the depth pre-pass computes the same positions in another program
+invariant gl_Position;
+
+void main()
+{
+	// the base instance of each command is the index of its group data, which survives the compaction of culled commands
+	GroupData group = groups[gl_BaseInstanceARB];
+
+	// explosion based on camera positon, as in the per-group path
+	vec3 modelPosition = decodePosition(position);
+	vec4 pos = groupPosition(group, modelPosition);
+
+	vertex.position = modelPosition;
+	vertex.normal = normal;
+	vertex.texCoord = texCoord;
+	vertex.tangent = tangent;
+	vertex.materialIndex = group.materialIndex;
+
+	gl_Position = pos;
+}
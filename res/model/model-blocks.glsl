@@ -0,0 +1,79 @@
+// per-frame state, written once per frame into a single uniform buffer (std140, mirrored by ModelRenderer::FrameUniforms)
+// -- with LEGACY_UNIFORMS, the same values are plain uniforms set one by one, which the uniform buffer benchmark compares
+#ifdef LEGACY_UNIFORMS
+#define FRAME_UNIFORM uniform
+#else
+#define FRAME_UNIFORM
+layout(std140) uniform frameBlock
+{
+#endif
+	FRAME_UNIFORM mat4 modelViewProjectionMatrix;
+	FRAME_UNIFORM mat4 modelViewMatrix;
+	FRAME_UNIFORM mat4 viewMatrix;
+	FRAME_UNIFORM mat4 modelLightMatrix;
+	FRAME_UNIFORM mat3 normalMatrix;
+	FRAME_UNIFORM vec3 worldCameraPosition;
+	FRAME_UNIFORM float explosion;
+	FRAME_UNIFORM vec3 worldLightPosition;
+	FRAME_UNIFORM float refractionRatio;
+	FRAME_UNIFORM vec3 centerModel;
+	FRAME_UNIFORM float specularExponent;
+	FRAME_UNIFORM vec3 positionOffset;
+	FRAME_UNIFORM vec3 positionScale;
+	FRAME_UNIFORM vec4 wireframeLineColor;
+	FRAME_UNIFORM vec4 ambientColor;
+	FRAME_UNIFORM vec4 diffuseColor;
+	FRAME_UNIFORM vec4 specularColor;
+	FRAME_UNIFORM vec2 viewportSize;
+	FRAME_UNIFORM float ambientIntensity;
+	FRAME_UNIFORM float diffuseIntensity;
+	FRAME_UNIFORM float specularIntensity;
+	FRAME_UNIFORM float A;
+	FRAME_UNIFORM float k;
+	FRAME_UNIFORM bool blinnPhong;
+	FRAME_UNIFORM bool toonShading;
+	FRAME_UNIFORM bool procedualBumpMap;
+	FRAME_UNIFORM bool reflectionBool;
+	FRAME_UNIFORM bool onlyReflection;
+	FRAME_UNIFORM bool ambientReflection;
+	FRAME_UNIFORM bool refractionBool;
+	FRAME_UNIFORM bool cameraExplosion;
+	FRAME_UNIFORM bool diffuseTexBool;
+	FRAME_UNIFORM bool ambientTexBool;
+	FRAME_UNIFORM bool specularTexBool;
+	FRAME_UNIFORM bool normalTexBool;
+	FRAME_UNIFORM bool tangentTexBool;
+#ifndef LEGACY_UNIFORMS
+};
+#endif
+
+// packed vertices store their positions normalized to the bounds of the model, for others this is the identity
+vec3 decodePosition(vec3 position)
+{
+	return positionOffset + position * positionScale;
+}
+
+// per-material state, written when the model's materials change (mirrored by ModelRenderer::MaterialData)
+#define MAXIMUM_MATERIAL_COUNT 1024
+
+#define DIFFUSE_TEXTURE_BIT 1u
+#define AMBIENT_TEXTURE_BIT 2u
+#define SPECULAR_TEXTURE_BIT 4u
+#define NORMAL_TEXTURE_BIT 8u
+#define TANGENT_TEXTURE_BIT 16u
+
+struct MaterialData
+{
+	uint textureMask;
+};
+
+layout(std140) uniform materialBlock
+{
+	MaterialData materials[MAXIMUM_MATERIAL_COUNT];
+};
+
+// materials beyond the block's capacity are treated as having all textures
+bool hasTexture(uint materialIndex, uint textureBit)
+{
+	return materialIndex >= MAXIMUM_MATERIAL_COUNT || (materials[materialIndex].textureMask & textureBit) != 0u;
+}
@@ -0,0 +1,170 @@
+#version 430
+#extension GL_ARB_shading_language_include : require
+#include "/model-globals.glsl"
+#include "/model-blocks.glsl"
+#include "/model-groups.glsl"
+
+layout(local_size_x = 64) in;
+
+// layout of GL_DRAW_INDIRECT_BUFFER entries, mirrored by ModelRenderer::DrawCommand
+struct DrawCommand
+{
+	uint count;
+	uint instanceCount;
+	uint firstIndex;
+	uint baseVertex;
+	uint baseInstance;
+};
+
+// commands of all groups, with an instance count of zero for disabled groups
+layout(std430, binding = 2) readonly buffer sourceCommandBuffer
+{
+	DrawCommand sourceCommands[];
+};
+
+layout(std430, binding = 3) writeonly buffer culledCommandBuffer
+{
+	DrawCommand culledCommands[];
+};
+
+// number of commands written per batch, reset to zero before every dispatch
+layout(std430, binding = 4) buffer drawCountBuffer
+{
+	uint drawCounts[];
+};
+
+// index ranges of the levels of detail of all commands, the first one of each command is the full group (mirrored by ModelRenderer::LodData)
+struct LodData
+{
+	uint firstIndex;
+	uint count;
+	float error;
+};
+
+layout(std430, binding = 5) readonly buffer lodBuffer
+{
+	LodData lods[];
+};
+
+uniform uint commandCount;
+
+// with compaction, the visible commands of each batch are moved to its front and counted, otherwise culled ones get no instance
+uniform bool compactCommands;
+
+// maximum depth pyramid of the previous frame and the matrix it was rendered with
+uniform bool occlusionCulling;
+uniform sampler2D depthPyramid;
+uniform vec2 depthPyramidSize;
+uniform mat4 previousModelViewProjectionMatrix;
+
+// pixels per model unit at a distance of one divided by the largest error in pixels, zero always selects the full groups
+uniform float lodScale;
+
+// a box is outside if it is completely on the negative side of any clip plane, -w <= x,y,z <= w
+bool insideFrustum(vec3 center, vec3 extent)
+{
+	mat4 m = transpose(modelViewProjectionMatrix);
+	vec4 planes[6] = vec4[](m[3] + m[0], m[3] - m[0], m[3] + m[1], m[3] - m[1], m[3] + m[2], m[3] - m[2]);
+
+	for (int i = 0; i < 6; i++)
+	{
+		if (dot(planes[i].xyz, center) + planes[i].w + dot(abs(planes[i].xyz), extent) < 0.0)
+			return false;
+	}
+
+	return true;
+}
+
+// a box is occluded if its nearest depth is behind the farthest depth of the pyramid texels covering its screen rectangle
+bool occluded(vec3 center, vec3 extent)
+{
+	vec3 minimum = vec3(1.0);
+	vec3 maximum = vec3(0.0);
+
+	for (int i = 0; i < 8; i++)
+	{
+		vec3 corner = center + extent * vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0, (i & 4) != 0 ? 1.0 : -1.0);
+		vec4 clip = previousModelViewProjectionMatrix * vec4(corner, 1.0);
+
+		// boxes crossing the near plane cannot be projected, and are close enough to be drawn anyway
+		if (clip.w <= 0.0)
+			return false;
+
+		vec3 window = clamp(clip.xyz / clip.w * 0.5 + 0.5, 0.0, 1.0);
+		minimum = min(minimum, window);
+		maximum = max(maximum, window);
+	}
+
+	// the pixels covered by the rectangle, and the level at which they fall into at most two by two texels
+	ivec2 pixelSize = ivec2(depthPyramidSize);
+	ivec2 firstPixel = clamp(ivec2(floor(minimum.xy * depthPyramidSize)), ivec2(0), pixelSize - 1);
+	ivec2 lastPixel = clamp(ivec2(floor(maximum.xy * depthPyramidSize)), ivec2(0), pixelSize - 1);
+	ivec2 span = lastPixel - firstPixel + 1;
+	int level = min(int(ceil(log2(float(max(span.x, span.y))))), textureQueryLevels(depthPyramid) - 1);
+
+	// the levels are not powers of two, a texel covers the pixels p >> level, and the last texel of an odd-sized level
+	// also covers the last pixels, so normalized coordinates could select a neighboring texel
+	ivec2 levelSize = textureSize(depthPyramid, level);
+	ivec2 first = min(firstPixel >> level, levelSize - 1);
+	ivec2 last = min(lastPixel >> level, levelSize - 1);
+
+	float depth = texelFetch(depthPyramid, first, level).r;
+	depth = max(depth, texelFetch(depthPyramid, ivec2(last.x, first.y), level).r);
+	depth = max(depth, texelFetch(depthPyramid, ivec2(first.x, last.y), level).r);
+	depth = max(depth, texelFetch(depthPyramid, last, level).r);
+
+	return minimum.z > depth;
+}
+
+// the coarsest level whose scaled error is at most the distance of the camera to the box, as in ModelRenderer::selectLods()
+uint selectLod(GroupData group, vec3 center, vec3 extent)
+{
+	float distance = length(max(abs(worldCameraPosition - center) - extent, vec3(0.0)));
+	uint level = 0u;
+
+	if (lodScale <= 0.0)
+		return level;
+
+	// the errors increase with the level
+	for (uint l = 1u; l < group.lodCount && lods[group.firstLod + l].error * lodScale <= distance; l++)
+		level = l;
+
+	return level;
+}
+
+void main()
+{
+	uint c = gl_GlobalInvocationID.x;
+
+	if (c >= commandCount)
+		return;
+
+	DrawCommand command = sourceCommands[c];
+	GroupData group = groups[c];
+
+	// the box moves with the explosion, like the vertices in the batch vertex shader
+	vec3 offset = (group.centerMass.xyz - centerModel) * explosionScale(group.centerMass.xyz);
+	vec3 center = (group.maxBounds.xyz + group.minBounds.xyz) * 0.5 + offset;
+	vec3 extent = (group.maxBounds.xyz - group.minBounds.xyz) * 0.5;
+
+	bool visible = command.instanceCount > 0u && insideFrustum(center, extent);
+
+	if (visible && occlusionCulling)
+		visible = !occluded(center, extent);
+
+	// the source commands may still hold the levels selected on the CPU
+	LodData lod = lods[group.firstLod + selectLod(group, center, extent)];
+	command.firstIndex = lod.firstIndex;
+	command.count = lod.count;
+
+	if (compactCommands)
+	{
+		if (visible)
+			culledCommands[group.batchFirstCommand + atomicAdd(drawCounts[group.batchIndex], 1u)] = command;
+	}
+	else
+	{
+		command.instanceCount = visible ? 1u : 0u;
+		culledCommands[c] = command;
+	}
+}
@@ -0,0 +1,6 @@
+#version 400
+
+// programs that only write depth or only test against it, like the depth pre-pass and occlusion query proxies
+void main()
+{
+}
@@ -0,0 +1,39 @@
+#version 430
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+// the first level is reduced from the depth texture, every other one from the previous level of the pyramid
+uniform bool firstLevel;
+uniform sampler2D depthTexture;
+layout(r32f, binding = 0) readonly uniform image2D sourceLevel;
+layout(r32f, binding = 1) writeonly uniform image2D targetLevel;
+
+void main()
+{
+	ivec2 target = ivec2(gl_GlobalInvocationID.xy);
+	ivec2 targetSize = imageSize(targetLevel);
+
+	if (any(greaterThanEqual(target, targetSize)))
+		return;
+
+	if (firstLevel)
+	{
+		imageStore(targetLevel, target, vec4(texelFetch(depthTexture, target, 0).r));
+		return;
+	}
+
+	// texels of odd-sized levels are covered by three source texels at the last row or column, so they are included as well
+	ivec2 sourceSize = imageSize(sourceLevel);
+	ivec2 first = target * 2;
+	ivec2 last = min(first + ivec2(1) + ivec2(equal(target, targetSize - 1)) * (sourceSize & 1), sourceSize - 1);
+
+	float depth = 0.0;
+
+	for (int y = first.y; y <= last.y; y++)
+	{
+		for (int x = first.x; x <= last.x; x++)
+			depth = max(depth, imageLoad(sourceLevel, ivec2(x, y)).r);
+	}
+
+	imageStore(targetLevel, target, vec4(depth));
+}
@@ -0,0 +1,40 @@
+// per-command group data in draw command order (std430, mirrored by ModelRenderer::GroupData)
+struct GroupData
+{
+	vec4 centerMass;
+	vec4 minBounds;
+	vec4 maxBounds;
+	uint materialIndex;
+	uint batchIndex;
+	uint batchFirstCommand;
+	// levels of detail in the LOD buffer of the culling compute shader, including the full group
+	uint lodCount;
+	uint firstLod;
+};
+
+layout(std430, binding = 0) readonly buffer groupBuffer
+{
+	GroupData groups[];
+};
+
+// distance by which a group is moved away from the center of the model, based on the camera position if enabled
+float explosionScale(vec3 centerMass)
+{
+	float c_explode = 0.0;
+	if (cameraExplosion) {
+		float cameraDistance = distance(normalize(worldCameraPosition), normalize(centerMass));
+		c_explode = -log(cameraDistance);
+		if (c_explode > cameraDistance * 3) {
+			c_explode = c_explode * 5;
+		}
+	}
+
+	return c_explode + explosion;
+}
+
+// clip space position of a vertex of a group, used by every program drawing batches so that their depths match exactly
+vec4 groupPosition(GroupData group, vec3 position)
+{
+	vec3 dir = group.centerMass.xyz - centerModel;
+	return modelViewProjectionMatrix*vec4(position + dir * explosionScale(group.centerMass.xyz),1.0);
+}
@@ -0,0 +1,11 @@
+#version 400
+
+// transforms the unit box to the bounding box of a group, including its explosion offset
+uniform mat4 modelViewProjectionMatrix;
+
+layout(location = 0) in vec3 position;
+
+void main()
+{
+	gl_Position = modelViewProjectionMatrix * vec4(position, 1.0);
+}
@@ -0,0 +1,16 @@
+#version 400
+#extension GL_ARB_shading_language_include : require
+#include "/model-globals.glsl"
+#include "/model-blocks.glsl"
+
+// depth-only version of model-base-vs.glsl, reading the tightly packed positions
+uniform mat4 transformation;
+
+layout(location = 0) in vec3 position;
+
+invariant gl_Position;
+
+void main()
+{
+	gl_Position = modelViewProjectionMatrix*transformation*vec4(decodePosition(position),1.0);
+}
@@ -0,0 +1,27 @@
+#version 430
+#extension GL_ARB_shading_language_include : require
+#extension GL_ARB_bindless_texture : require
+#include "/model-globals.glsl"
+
+// Material textures accessed through bindless handles, so that no textures are bound per draw
+
+struct MaterialTextures
+{
+	uvec2 handles[5];
+};
+
+layout(std430, binding = 1) readonly buffer materialTextureBuffer
+{
+	MaterialTextures materialTextures[];
+};
+
+vec4 materialTexture(uint materialIndex, uint slot, vec2 texCoord)
+{
+	uvec2 handle = materialTextures[materialIndex].handles[slot];
+
+	// materials without the texture have no handle
+	if (handle == uvec2(0u))
+		return vec4(0.0, 0.0, 0.0, 1.0);
+
+	return texture(sampler2D(handle), texCoord);
+}
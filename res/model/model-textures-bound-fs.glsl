@@ -0,0 +1,20 @@
+#version 400
+#extension GL_ARB_shading_language_include : require
+#include "/model-globals.glsl"
+
+// Material textures bound to fixed texture units by ModelRenderer, used when bindless textures are not supported
+
+uniform sampler2D diffuseTexture;
+uniform sampler2D ambientTexture;
+uniform sampler2D specularTexture;
+uniform sampler2D normalTexture;
+uniform sampler2D tangentTexture;
+
+vec4 materialTexture(uint materialIndex, uint slot, vec2 texCoord)
+{
+	if (slot == 0u) return texture(diffuseTexture, texCoord);
+	if (slot == 1u) return texture(ambientTexture, texCoord);
+	if (slot == 2u) return texture(specularTexture, texCoord);
+	if (slot == 3u) return texture(normalTexture, texCoord);
+	return texture(tangentTexture, texCoord);
+}
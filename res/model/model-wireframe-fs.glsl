@@ -0,0 +1,12 @@
+#version 400
+#extension GL_ARB_shading_language_include : require
+#include "/model-globals.glsl"
+#include "/model-blocks.glsl"
+
+// the edges of the model, drawn as lines over the shaded triangles
+out vec4 fragColor;
+
+void main()
+{
+	fragColor = wireframeLineColor;
+}
@@ -21,49 +21,6 @@ using namespace globjects;
 
 BoundingBoxRenderer::BoundingBoxRenderer(Viewer* viewer) : Renderer(viewer)
 {
-	static std::array<vec3, 8> vertices {{
-		// front
-		{-1.0, -1.0, 1.0 },
-		{ 1.0, -1.0, 1.0 },
-		{ 1.0, 1.0, 1.0 },
-		{ -1.0, 1.0, 1.0 },
-		// back
-		{ -1.0, -1.0, -1.0 },
-		{ 1.0, -1.0, -1.0 },
-		{ 1.0, 1.0, -1.0 },
-		{ -1.0, 1.0, -1.0 }
-	}};
-
-	
-	static std::array< std::array<GLushort, 4>, 6> indices{ {
-		// front
-		{0,1,2,3},
-		// top
-		{1,5,6,2},
-		// back
-		{7,6,5,4},
-		// bottom
-		{4,0,3,7},
-		// left
-		{4,5,1,0},
-		// right
-		{3,2,6,7}
-	}};
-
-	m_indices->setData(indices, GL_STATIC_DRAW);
-	m_vertices->setData(vertices, GL_STATIC_DRAW);
-
-	m_size = static_cast<GLsizei>(indices.size()*indices.front().size());
-	m_vao->bindElementBuffer(m_indices.get());
-
-	auto vertexBinding = m_vao->binding(0);
-	vertexBinding->setAttribute(0);
-	vertexBinding->setBuffer(m_vertices.get(), 0, sizeof(vec3));
-	vertexBinding->setFormat(3, GL_FLOAT);
-	m_vao->enable(0);
-
-	m_vao->unbind();
-
 	createShaderProgram("boundingbox", {
 		{ GL_VERTEX_SHADER,"./res/boundingbox/boundingbox-vs.glsl" },
 		{ GL_TESS_CONTROL_SHADER, "./res/boundingbox/boundingbox-tcs.glsl" },
@@ -103,14 +60,14 @@ void BoundingBoxRenderer::display()
 	program->setUniform("modelView", modelViewTransform);
 	program->setUniform("lineColor", lineColor);
 
-	m_vao->bind();
+	m_box.bind();
 	glPatchParameteri(GL_PATCH_VERTICES, 4);
 
 	program->use();
-	m_vao->drawElements(GL_PATCHES, m_size, GL_UNSIGNED_SHORT, nullptr);
+	m_box.drawPatches();
 	program->release();
 
-	m_vao->unbind();
+	m_box.unbind();
 
 	glDisable(GL_BLEND);
 	glDisable(GL_SAMPLE_ALPHA_TO_COVERAGE);
@@ -1,5 +1,6 @@
 #pragma once
 #include "Renderer.h"
+#include "BoxGeometry.h"
 #include <memory>
 
 #include <glm/glm.hpp>
@@ -27,11 +28,7 @@ namespace minity
 		virtual void display();
 
 	private:
-		
-		std::unique_ptr<globjects::VertexArray> m_vao = std::make_unique<globjects::VertexArray>();
-		std::unique_ptr<globjects::Buffer> m_vertices = std::make_unique<globjects::Buffer>();
-		std::unique_ptr<globjects::Buffer> m_indices = std::make_unique<globjects::Buffer>();
-		gl::GLsizei m_size;
+		BoxGeometry m_box;
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "BoxGeometry.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+
+using namespace minity;
+using namespace gl;
+using namespace glm;
+using namespace globjects;
+
+namespace
+{
+	const std::size_t quadIndexCount = 24;
+	const std::size_t triangleIndexCount = 36;
+}
+
+BoxGeometry::BoxGeometry()
+{
+	static std::array<vec3, 8> vertices {{
+		// front
+		{-1.0, -1.0, 1.0 },
+		{ 1.0, -1.0, 1.0 },
+		{ 1.0, 1.0, 1.0 },
+		{ -1.0, 1.0, 1.0 },
+		// back
+		{ -1.0, -1.0, -1.0 },
+		{ 1.0, -1.0, -1.0 },
+		{ 1.0, 1.0, -1.0 },
+		{ -1.0, 1.0, -1.0 }
+	}};
+
+	static std::array< std::array<GLushort, 4>, 6> quads{ {
+		// front
+		{0,1,2,3},
+		// top
+		{1,5,6,2},
+		// back
+		{7,6,5,4},
+		// bottom
+		{4,0,3,7},
+		// left
+		{4,5,1,0},
+		// right
+		{3,2,6,7}
+	}};
+
+	// the quads followed by the same faces split into two triangles each
+	std::array<GLushort, quadIndexCount + triangleIndexCount> indices;
+
+	for (std::size_t i = 0; i < quads.size(); i++)
+	{
+		const std::array<GLushort, 4>& quad = quads[i];
+		std::copy(quad.begin(), quad.end(), indices.begin() + i * 4);
+
+		const std::array<GLushort, 6> triangles = { quad[0], quad[1], quad[2], quad[0], quad[2], quad[3] };
+		std::copy(triangles.begin(), triangles.end(), indices.begin() + quadIndexCount + i * 6);
+	}
+
+	m_indices->setData(indices, GL_STATIC_DRAW);
+	m_vertices->setData(vertices, GL_STATIC_DRAW);
+
+	m_vao->bindElementBuffer(m_indices.get());
+
+	auto vertexBinding = m_vao->binding(0);
+	vertexBinding->setAttribute(0);
+	vertexBinding->setBuffer(m_vertices.get(), 0, sizeof(vec3));
+	vertexBinding->setFormat(3, GL_FLOAT);
+	m_vao->enable(0);
+
+	m_vao->unbind();
+}
+
+void BoxGeometry::bind() const
+{
+	m_vao->bind();
+}
+
+void BoxGeometry::unbind() const
+{
+	m_vao->unbind();
+}
+
+void BoxGeometry::drawPatches() const
+{
+	m_vao->drawElements(GL_PATCHES, GLsizei(quadIndexCount), GL_UNSIGNED_SHORT, nullptr);
+}
+
+void BoxGeometry::drawTriangles() const
+{
+	m_vao->drawElements(GL_TRIANGLES, GLsizei(triangleIndexCount), GL_UNSIGNED_SHORT, reinterpret_cast<const void*>(sizeof(GLushort) * quadIndexCount));
+}
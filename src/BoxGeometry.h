@@ -0,0 +1,33 @@
+#pragma once
+
+#include <glbinding/gl/gl.h>
+#include <globjects/VertexArray.h>
+#include <globjects/VertexAttributeBinding.h>
+#include <globjects/Buffer.h>
+
+#include <memory>
+
+namespace minity
+{
+	// Cube from -1 to 1 along every axis with its vertex positions at attribute 0. The faces are stored both as quad
+	// patches, for the tessellated bounding box outline, and as triangles, for proxy draws like occlusion queries.
+	class BoxGeometry
+	{
+	public:
+		BoxGeometry();
+
+		void bind() const;
+		void unbind() const;
+
+		// the box has to be bound, and the patch size set to four vertices
+		void drawPatches() const;
+		// the box has to be bound
+		void drawTriangles() const;
+
+	private:
+		std::unique_ptr<globjects::VertexArray> m_vao = std::make_unique<globjects::VertexArray>();
+		std::unique_ptr<globjects::Buffer> m_vertices = std::make_unique<globjects::Buffer>();
+		std::unique_ptr<globjects::Buffer> m_indices = std::make_unique<globjects::Buffer>();
+	};
+
+}
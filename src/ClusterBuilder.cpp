@@ -0,0 +1,228 @@
+#include "ClusterBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+
+using namespace minity;
+using namespace glm;
+
+namespace
+{
+	// clusters whose normals spread further than this cosine from the axis are never culled by their cone
+	const float minimumConeSpread = 0.1f;
+}
+
+void ClusterBuilder::build(std::vector<Group>& groups, std::vector<uint>& indices, const std::vector<Vertex>& vertices, std::vector<Cluster>& clusters, ThreadPool& pool)
+{
+	std::vector< std::vector<Cluster> > groupClusters(groups.size());
+
+	pool.parallelFor(groups.size(), [&](std::size_t g)
+	{
+		groupClusters[g] = buildClusters(indices.data() + groups[g].startIndex, groups[g].endIndex - groups[g].startIndex, vertices);
+	});
+
+	clusters.clear();
+
+	for (std::size_t g = 0; g < groups.size(); g++)
+	{
+		groups[g].firstCluster = uint(clusters.size());
+		groups[g].clusterCount = uint(groupClusters[g].size());
+
+		for (Cluster& cluster : groupClusters[g])
+		{
+			cluster.startIndex += groups[g].startIndex;
+			cluster.endIndex += groups[g].startIndex;
+			clusters.push_back(cluster);
+		}
+	}
+}
+
+std::vector<Cluster> ClusterBuilder::buildClusters(uint* indices, std::size_t indexCount, const std::vector<Vertex>& vertices)
+{
+	const std::size_t triangleCount = indexCount / 3;
+	std::vector<Cluster> clusters;
+
+	if (triangleCount == 0)
+		return clusters;
+
+	// local vertex numbers, which keep the arrays below as small as the group
+	std::unordered_map<uint, uint> localVertices;
+	std::vector<uint> corners(triangleCount * 3);
+
+	for (std::size_t c = 0; c < corners.size(); c++)
+		corners[c] = localVertices.emplace(indices[c], uint(localVertices.size())).first->second;
+
+	const std::size_t vertexCount = localVertices.size();
+
+	// triangles adjacent to each vertex, as a compressed sparse row table
+	std::vector<uint> offsets(vertexCount + 1, 0);
+
+	for (uint v : corners)
+		offsets[v + 1]++;
+
+	std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+	std::vector<uint> adjacency(corners.size());
+	std::vector<uint> cursors(offsets.begin(), offsets.end() - 1);
+
+	for (std::size_t c = 0; c < corners.size(); c++)
+		adjacency[cursors[corners[c]]++] = uint(c / 3);
+
+	std::vector<vec3> centroids(triangleCount);
+
+	for (std::size_t t = 0; t < triangleCount; t++)
+		centroids[t] = (vertices[indices[t * 3 + 0]].position + vertices[indices[t * 3 + 1]].position + vertices[indices[t * 3 + 2]].position) / 3.0f;
+
+	// the cluster a vertex was last added to, so that the vertices of the current cluster need not be cleared
+	std::vector<uint> vertexCluster(vertexCount, std::numeric_limits<uint>::max());
+	std::vector<unsigned char> emitted(triangleCount, 0);
+	std::vector<uint> ordered;
+	ordered.reserve(triangleCount * 3);
+
+	std::vector<uint> candidates;
+	std::size_t cursor = 0;
+
+	while (ordered.size() < triangleCount * 3)
+	{
+		const uint clusterIndex = uint(clusters.size());
+		Cluster cluster;
+		cluster.startIndex = uint(ordered.size());
+
+		uint clusterVertexCount = 0;
+		uint clusterTriangleCount = 0;
+		vec3 centroidSum(0.0f);
+		candidates.clear();
+
+		// each cluster starts at the first triangle left in the input order, which keeps the order of optimized meshes
+		while (emitted[cursor])
+			cursor++;
+
+		uint next = uint(cursor);
+
+		for (;;)
+		{
+			emitted[next] = 1;
+			clusterTriangleCount++;
+			centroidSum += centroids[next];
+
+			for (int c = 0; c < 3; c++)
+			{
+				const uint v = corners[next * 3 + c];
+				ordered.push_back(indices[next * 3 + c]);
+
+				if (vertexCluster[v] != clusterIndex)
+				{
+					vertexCluster[v] = clusterIndex;
+					clusterVertexCount++;
+
+					for (uint a = offsets[v]; a < offsets[v + 1]; a++)
+					{
+						if (!emitted[adjacency[a]])
+							candidates.push_back(adjacency[a]);
+					}
+				}
+			}
+
+			if (clusterTriangleCount >= maximumTriangleCount)
+				break;
+
+			// the adjacent triangle with the fewest new vertices that still fits, and the closest one among those
+			const vec3 center = centroidSum / float(clusterTriangleCount);
+			uint bestNewVertices = 4;
+			float bestDistance = std::numeric_limits<float>::max();
+			std::size_t kept = 0;
+
+			for (std::size_t i = 0; i < candidates.size(); i++)
+			{
+				const uint t = candidates[i];
+
+				if (emitted[t])
+					continue;
+
+				candidates[kept++] = t;
+
+				uint newVertices = 0;
+
+				for (int c = 0; c < 3; c++)
+					newVertices += vertexCluster[corners[t * 3 + c]] != clusterIndex ? 1 : 0;
+
+				if (clusterVertexCount + newVertices > maximumVertexCount)
+					continue;
+
+				const vec3 offset = centroids[t] - center;
+				const float distance = dot(offset, offset);
+
+				if (newVertices < bestNewVertices || (newVertices == bestNewVertices && distance < bestDistance))
+				{
+					bestNewVertices = newVertices;
+					bestDistance = distance;
+					next = t;
+				}
+			}
+
+			candidates.resize(kept);
+
+			if (bestNewVertices > 3)
+				break;
+		}
+
+		cluster.endIndex = uint(ordered.size());
+		clusters.push_back(cluster);
+	}
+
+	std::copy(ordered.begin(), ordered.end(), indices);
+
+	for (Cluster& cluster : clusters)
+		computeBounds(cluster, indices, vertices);
+
+	return clusters;
+}
+
+void ClusterBuilder::computeBounds(Cluster& cluster, const uint* indices, const std::vector<Vertex>& vertices)
+{
+	cluster.minBounds = vec3(std::numeric_limits<float>::max());
+	cluster.maxBounds = vec3(-std::numeric_limits<float>::max());
+
+	std::vector<vec3> normals;
+	vec3 normalSum(0.0f);
+
+	for (uint i = cluster.startIndex; i + 2 < cluster.endIndex; i += 3)
+	{
+		const vec3& p0 = vertices[indices[i + 0]].position;
+		const vec3& p1 = vertices[indices[i + 1]].position;
+		const vec3& p2 = vertices[indices[i + 2]].position;
+
+		cluster.minBounds = min(cluster.minBounds, min(p0, min(p1, p2)));
+		cluster.maxBounds = max(cluster.maxBounds, max(p0, max(p1, p2)));
+
+		// degenerate triangles are never drawn, and do not widen the cone
+		const vec3 normal = cross(p1 - p0, p2 - p0);
+		const float l = length(normal);
+
+		if (l > 0.0f)
+		{
+			normals.push_back(normal / l);
+			normalSum += normal / l;
+		}
+	}
+
+	cluster.coneAxis = vec3(0.0f, 0.0f, 1.0f);
+	cluster.coneCutoff = 1.0f;
+
+	if (normals.empty() || length(normalSum) <= 0.0f)
+		return;
+
+	const vec3 axis = normalize(normalSum);
+	float minimumDot = 1.0f;
+
+	for (const vec3& normal : normals)
+		minimumDot = std::min(minimumDot, dot(axis, normal));
+
+	cluster.coneAxis = axis;
+
+	if (minimumDot > minimumConeSpread)
+		cluster.coneCutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Model.h"
+#include "ThreadPool.h"
+
+#include <vector>
+
+namespace minity
+{
+	// Splits each group into clusters of adjacent triangles, which are made contiguous in the index buffer so that
+	// any subset of them can be drawn as a few index ranges. Triangles only move within their group, so the index
+	// ranges of the groups stay valid.
+	class ClusterBuilder
+	{
+	public:
+		// limits of a cluster, a cluster is closed early when no adjacent triangle fits anymore
+		static const glm::uint maximumVertexCount = 96;
+		static const glm::uint maximumTriangleCount = 124;
+
+		// replaces the clusters with those of all groups, and sets the cluster ranges of the groups
+		static void build(std::vector<Group>& groups, std::vector<glm::uint>& indices, const std::vector<Vertex>& vertices, std::vector<Cluster>& clusters, ThreadPool& pool);
+
+		// clusters one triangle list in place by greedily growing each cluster with the adjacent triangle that adds the
+		// fewest vertices and is closest to its center -- the index ranges of the clusters are relative to the list
+		static std::vector<Cluster> buildClusters(glm::uint* indices, std::size_t indexCount, const std::vector<Vertex>& vertices);
+
+		// bounds and normal cone of the triangles of a cluster
+		static void computeBounds(Cluster& cluster, const glm::uint* indices, const std::vector<Vertex>& vertices);
+	};
+
+}
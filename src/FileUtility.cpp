@@ -0,0 +1,39 @@
+#include "FileUtility.h"
+
+#include <cstring>
+#include <filesystem>
+
+using namespace minity;
+
+std::uint64_t FileUtility::hash(const char* data, std::size_t size)
+{
+	const std::uint64_t prime = 0x9E3779B97F4A7C15ull;
+	std::uint64_t h = std::uint64_t(size) ^ prime;
+	std::size_t i = 0;
+
+	for (; i + 8 <= size; i += 8)
+	{
+		std::uint64_t word;
+		memcpy(&word, data + i, 8);
+		h = (h ^ word) * prime;
+		h ^= h >> 29;
+	}
+
+	std::uint64_t tail = 0;
+	memcpy(&tail, data + i, size - i);
+	h = (h ^ tail) * prime;
+	h ^= h >> 32;
+
+	return h;
+}
+
+std::int64_t FileUtility::fileTime(const std::string& filename)
+{
+	std::error_code error;
+	auto time = std::filesystem::last_write_time(filename, error);
+
+	if (error)
+		return 0;
+
+	return std::int64_t(time.time_since_epoch().count());
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace minity
+{
+	// Helpers shared by the mesh and texture caches to detect modified source files
+	class FileUtility
+	{
+	public:
+		// multiply-xorshift hash over 64 bit words -- it is only used to detect modified files, not for security
+		static std::uint64_t hash(const char* data, std::size_t size);
+
+		// last write time of a file in ticks of the file clock, 0 if it cannot be determined
+		static std::int64_t fileTime(const std::string& filename);
+	};
+
+}
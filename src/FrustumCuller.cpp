@@ -0,0 +1,151 @@
+#include "FrustumCuller.h"
+#include "Model.h"
+
+#include <array>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MINITY_FRUSTUM_SSE
+#include <emmintrin.h>
+#endif
+
+using namespace minity;
+using namespace glm;
+
+void FrustumCuller::setGroups(const std::vector<Group>& groups)
+{
+	m_groupCount = groups.size();
+
+	for (auto* v : { &m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ, &m_massX, &m_massY, &m_massZ })
+		v->resize(m_groupCount);
+
+	for (std::size_t i = 0; i < m_groupCount; i++)
+	{
+		const Group& group = groups[i];
+		const vec3 center = (group.maxBounds + group.minBounds) * 0.5f;
+		const vec3 extent = (group.maxBounds - group.minBounds) * 0.5f;
+
+		m_centerX[i] = center.x;
+		m_centerY[i] = center.y;
+		m_centerZ[i] = center.z;
+		m_extentX[i] = extent.x;
+		m_extentY[i] = extent.y;
+		m_extentZ[i] = extent.z;
+		m_massX[i] = group.centerMass.x;
+		m_massY[i] = group.centerMass.y;
+		m_massZ[i] = group.centerMass.z;
+	}
+}
+
+void FrustumCuller::setClusters(const std::vector<Group>& groups, const std::vector<Cluster>& clusters)
+{
+	m_groupCount = clusters.size();
+
+	for (auto* v : { &m_centerX, &m_centerY, &m_centerZ, &m_extentX, &m_extentY, &m_extentZ, &m_massX, &m_massY, &m_massZ })
+		v->resize(m_groupCount);
+
+	for (const Group& group : groups)
+	{
+		for (std::size_t i = group.firstCluster; i < std::size_t(group.firstCluster) + group.clusterCount; i++)
+		{
+			const Cluster& cluster = clusters[i];
+			const vec3 center = (cluster.maxBounds + cluster.minBounds) * 0.5f;
+			const vec3 extent = (cluster.maxBounds - cluster.minBounds) * 0.5f;
+
+			m_centerX[i] = center.x;
+			m_centerY[i] = center.y;
+			m_centerZ[i] = center.z;
+			m_extentX[i] = extent.x;
+			m_extentY[i] = extent.y;
+			m_extentZ[i] = extent.z;
+			m_massX[i] = group.centerMass.x;
+			m_massY[i] = group.centerMass.y;
+			m_massZ[i] = group.centerMass.z;
+		}
+	}
+}
+
+std::size_t FrustumCuller::groupCount() const
+{
+	return m_groupCount;
+}
+
+std::size_t FrustumCuller::cull(const mat4& modelViewProjection, const vec3& explosionCenter, const std::vector<float>& explosionScales, std::vector<unsigned char>& visible) const
+{
+	visible.resize(m_groupCount);
+
+	// planes of the clip volume in model space, -w <= x,y,z <= w, which do not need to be normalized for a sign test
+	const vec4 row0(modelViewProjection[0][0], modelViewProjection[1][0], modelViewProjection[2][0], modelViewProjection[3][0]);
+	const vec4 row1(modelViewProjection[0][1], modelViewProjection[1][1], modelViewProjection[2][1], modelViewProjection[3][1]);
+	const vec4 row2(modelViewProjection[0][2], modelViewProjection[1][2], modelViewProjection[2][2], modelViewProjection[3][2]);
+	const vec4 row3(modelViewProjection[0][3], modelViewProjection[1][3], modelViewProjection[2][3], modelViewProjection[3][3]);
+	const std::array<vec4, 6> planes = { row3 + row0, row3 - row0, row3 + row1, row3 - row1, row3 + row2, row3 - row2 };
+
+	// a box is outside if it is completely on the negative side of any plane
+	auto testBox = [&](std::size_t i)
+	{
+		const float scale = explosionScales.empty() ? 0.0f : explosionScales[i];
+		const vec3 mass(m_massX[i], m_massY[i], m_massZ[i]);
+		const vec3 center = vec3(m_centerX[i], m_centerY[i], m_centerZ[i]) + (mass - explosionCenter) * scale;
+		const vec3 extent(m_extentX[i], m_extentY[i], m_extentZ[i]);
+
+		for (const vec4& plane : planes)
+		{
+			if (dot(vec3(plane), center) + plane.w + dot(abs(vec3(plane)), extent) < 0.0f)
+				return false;
+		}
+
+		return true;
+	};
+
+	std::size_t i = 0;
+
+#ifdef MINITY_FRUSTUM_SSE
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 explosionCenterX = _mm_set1_ps(explosionCenter.x);
+	const __m128 explosionCenterY = _mm_set1_ps(explosionCenter.y);
+	const __m128 explosionCenterZ = _mm_set1_ps(explosionCenter.z);
+
+	for (; i + 4 <= m_groupCount; i += 4)
+	{
+		const __m128 scale = explosionScales.empty() ? zero : _mm_loadu_ps(&explosionScales[i]);
+		const __m128 centerX = _mm_add_ps(_mm_loadu_ps(&m_centerX[i]), _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_massX[i]), explosionCenterX), scale));
+		const __m128 centerY = _mm_add_ps(_mm_loadu_ps(&m_centerY[i]), _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_massY[i]), explosionCenterY), scale));
+		const __m128 centerZ = _mm_add_ps(_mm_loadu_ps(&m_centerZ[i]), _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&m_massZ[i]), explosionCenterZ), scale));
+		const __m128 extentX = _mm_loadu_ps(&m_extentX[i]);
+		const __m128 extentY = _mm_loadu_ps(&m_extentY[i]);
+		const __m128 extentZ = _mm_loadu_ps(&m_extentZ[i]);
+
+		__m128 outside = zero;
+
+		for (const vec4& plane : planes)
+		{
+			const vec3 absolute = abs(vec3(plane));
+
+			__m128 distance = _mm_set1_ps(plane.w);
+			distance = _mm_add_ps(distance, _mm_mul_ps(centerX, _mm_set1_ps(plane.x)));
+			distance = _mm_add_ps(distance, _mm_mul_ps(centerY, _mm_set1_ps(plane.y)));
+			distance = _mm_add_ps(distance, _mm_mul_ps(centerZ, _mm_set1_ps(plane.z)));
+			distance = _mm_add_ps(distance, _mm_mul_ps(extentX, _mm_set1_ps(absolute.x)));
+			distance = _mm_add_ps(distance, _mm_mul_ps(extentY, _mm_set1_ps(absolute.y)));
+			distance = _mm_add_ps(distance, _mm_mul_ps(extentZ, _mm_set1_ps(absolute.z)));
+
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, zero));
+		}
+
+		const int mask = _mm_movemask_ps(outside);
+
+		for (std::size_t j = 0; j < 4; j++)
+			visible[i + j] = (mask & (1 << j)) ? 0 : 1;
+	}
+#endif
+
+	for (; i < m_groupCount; i++)
+		visible[i] = testBox(i) ? 1 : 0;
+
+	std::size_t culledCount = 0;
+
+	for (unsigned char v : visible)
+		culledCount += v ? 0 : 1;
+
+	return culledCount;
+}
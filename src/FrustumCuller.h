@@ -0,0 +1,37 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace minity
+{
+	struct Group;
+	struct Cluster;
+
+	// Tests the bounding boxes of the model groups against the view frustum. The boxes are kept as separate
+	// arrays per component, so that four of them are tested against a plane at once with SSE where available.
+	class FrustumCuller
+	{
+	public:
+		void setGroups(const std::vector<Group>& groups);
+		// tests the clusters of the groups instead, whose boxes move with the center of mass of their group -- the
+		// indices of cull() are cluster indices then
+		void setClusters(const std::vector<Group>& groups, const std::vector<Cluster>& clusters);
+		std::size_t groupCount() const;
+
+		// sets visible[i] to 1 if the box of group i may intersect the frustum of the model-view-projection matrix and
+		// to 0 otherwise, and returns the number of invisible groups -- every box is first moved by explosionScales[i]
+		// times the offset of its group's center of mass from the explosion center, like in the shaders
+		std::size_t cull(const glm::mat4& modelViewProjection, const glm::vec3& explosionCenter, const std::vector<float>& explosionScales, std::vector<unsigned char>& visible) const;
+
+	private:
+		// one entry per group or cluster without padding, the SSE path tests four boxes at a time and the rest one by one
+		std::size_t m_groupCount = 0;
+		std::vector<float> m_centerX, m_centerY, m_centerZ;
+		std::vector<float> m_extentX, m_extentY, m_extentZ;
+		std::vector<float> m_massX, m_massY, m_massZ;
+	};
+
+}
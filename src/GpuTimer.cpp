@@ -0,0 +1,68 @@
+#include "GpuTimer.h"
+
+using namespace minity;
+using namespace gl;
+using namespace globjects;
+
+GpuTimer::GpuTimer()
+{
+	for (auto& query : m_queries)
+		query = Query::create();
+}
+
+void GpuTimer::begin()
+{
+	collect(m_current);
+
+	// the query of this slot is still in flight, reusing it would wait for its result
+	m_active = !m_pending[m_current];
+
+	if (m_active)
+		m_queries[m_current]->begin(GL_TIME_ELAPSED);
+}
+
+void GpuTimer::end()
+{
+	if (!m_active)
+		return;
+
+	m_queries[m_current]->end(GL_TIME_ELAPSED);
+	m_pending[m_current] = true;
+	m_current = (m_current + 1) % queryCount;
+	m_active = false;
+}
+
+double GpuTimer::smoothedTime() const
+{
+	return m_smoothedTime;
+}
+
+double GpuTimer::meanTime() const
+{
+	return m_sampleCount > 0 ? m_timeSum / double(m_sampleCount) : 0.0;
+}
+
+std::size_t GpuTimer::sampleCount() const
+{
+	return m_sampleCount;
+}
+
+void GpuTimer::reset()
+{
+	m_timeSum = 0.0;
+	m_sampleCount = 0;
+}
+
+void GpuTimer::collect(std::size_t index)
+{
+	if (!m_pending[index] || !m_queries[index]->resultAvailable())
+		return;
+
+	const GLuint64 nanoseconds = m_queries[index]->get64(GL_QUERY_RESULT);
+	const double milliseconds = double(nanoseconds) / 1000000.0;
+
+	m_pending[index] = false;
+	m_smoothedTime = m_smoothedTime > 0.0 ? m_smoothedTime * 0.95 + milliseconds * 0.05 : milliseconds;
+	m_timeSum += milliseconds;
+	m_sampleCount++;
+}
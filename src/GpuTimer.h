@@ -0,0 +1,43 @@
+#pragma once
+
+#include <globjects/Query.h>
+
+#include <array>
+#include <cstddef>
+#include <memory>
+
+namespace minity
+{
+	// Measures the GPU time between begin() and end() with timer queries. Each result is read a few frames later, once
+	// it is available, so that measuring never stalls the pipeline -- frames without a free query are not measured.
+	class GpuTimer
+	{
+	public:
+		GpuTimer();
+
+		void begin();
+		void end();
+
+		// time in milliseconds, smoothed over recent frames
+		double smoothedTime() const;
+
+		// mean time in milliseconds and number of results since the last reset
+		double meanTime() const;
+		std::size_t sampleCount() const;
+		void reset();
+
+	private:
+		void collect(std::size_t index);
+
+		static const std::size_t queryCount = 4;
+		std::array<std::unique_ptr<globjects::Query>, queryCount> m_queries;
+		std::array<bool, queryCount> m_pending{};
+		std::size_t m_current = 0;
+		bool m_active = false;
+
+		double m_smoothedTime = 0.0;
+		double m_timeSum = 0.0;
+		std::size_t m_sampleCount = 0;
+	};
+
+}
@@ -0,0 +1,137 @@
+#include "IndexPacker.h"
+#include "StripBuilder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+using namespace minity;
+using namespace glm;
+
+namespace
+{
+	// the 32 bit indices start at the first multiple of their size after the 16 bit ones
+	std::size_t longIndexOffset(std::size_t shortIndexCount)
+	{
+		return (shortIndexCount * sizeof(std::uint16_t) + sizeof(uint) - 1) / sizeof(uint) * sizeof(uint);
+	}
+}
+
+void IndexPacker::sort(std::vector<Group>& groups, std::vector<uint>& indices, std::vector<Cluster>& clusters)
+{
+	for (Group& group : groups)
+	{
+		uint minimum = std::numeric_limits<uint>::max();
+		uint maximum = 0;
+
+		for (uint l = 0; l <= group.lods.size(); l++)
+		{
+			const uint start = group.lodStartIndex(l);
+
+			for (uint i = start; i < start + group.lodIndexCount(l); i++)
+			{
+				minimum = std::min(minimum, indices[i]);
+				maximum = std::max(maximum, indices[i]);
+			}
+		}
+
+		if (minimum > maximum)
+			minimum = maximum = 0;
+
+		group.baseVertex = minimum;
+		group.shortIndices = maximum - minimum < maximumShortRange;
+	}
+
+	std::vector<uint> sorted;
+	sorted.reserve(indices.size());
+
+	for (bool shortIndices : { true, false })
+	{
+		for (Group& group : groups)
+		{
+			if (group.shortIndices != shortIndices)
+				continue;
+
+			const uint start = uint(sorted.size());
+			sorted.insert(sorted.end(), indices.begin() + group.startIndex, indices.begin() + group.endIndex);
+
+			// the clusters partition the full group, so they move along with it
+			for (uint c = group.firstCluster; c < group.firstCluster + group.clusterCount; c++)
+			{
+				clusters[c].startIndex = clusters[c].startIndex - group.startIndex + start;
+				clusters[c].endIndex = clusters[c].endIndex - group.startIndex + start;
+			}
+
+			group.endIndex = start + (group.endIndex - group.startIndex);
+			group.startIndex = start;
+
+			for (GroupLod& lod : group.lods)
+			{
+				const uint lodStart = uint(sorted.size());
+				sorted.insert(sorted.end(), indices.begin() + lod.startIndex, indices.begin() + lod.endIndex);
+				lod.endIndex = lodStart + (lod.endIndex - lod.startIndex);
+				lod.startIndex = lodStart;
+			}
+		}
+	}
+
+	indices.swap(sorted);
+}
+
+std::size_t IndexPacker::shortIndexCount(const std::vector<Group>& groups)
+{
+	std::size_t count = 0;
+
+	for (const Group& group : groups)
+	{
+		if (!group.shortIndices)
+			continue;
+
+		for (uint l = 0; l <= group.lods.size(); l++)
+			count += group.lodIndexCount(l);
+	}
+
+	return count;
+}
+
+std::vector<std::uint8_t> IndexPacker::pack(const std::vector<Group>& groups, const uint* indices, std::size_t indexCount, std::size_t shortIndexCount)
+{
+	std::vector<std::uint8_t> buffer(longIndexOffset(shortIndexCount) + (indexCount - shortIndexCount) * sizeof(uint), 0);
+
+	for (const Group& group : groups)
+	{
+		for (uint l = 0; l <= group.lods.size(); l++)
+		{
+			const uint start = group.lodStartIndex(l);
+			const uint end = start + group.lodIndexCount(l);
+			std::uint8_t* destination = buffer.data() + offset(group, start, shortIndexCount);
+
+			if (group.shortIndices)
+			{
+				for (uint i = start; i < end; i++, destination += sizeof(std::uint16_t))
+				{
+					const std::uint16_t index = indices[i] == StripBuilder::restartIndex ? std::uint16_t(0xFFFF) : std::uint16_t(indices[i] - group.baseVertex);
+					std::memcpy(destination, &index, sizeof(index));
+				}
+			}
+			else
+			{
+				for (uint i = start; i < end; i++, destination += sizeof(uint))
+				{
+					const uint index = indices[i] == StripBuilder::restartIndex ? indices[i] : indices[i] - group.baseVertex;
+					std::memcpy(destination, &index, sizeof(index));
+				}
+			}
+		}
+	}
+
+	return buffer;
+}
+
+std::size_t IndexPacker::offset(const Group& group, uint index, std::size_t shortIndexCount)
+{
+	if (group.shortIndices)
+		return std::size_t(index) * sizeof(std::uint16_t);
+
+	return longIndexOffset(shortIndexCount) + (std::size_t(index) - shortIndexCount) * sizeof(uint);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Model.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace minity
+{
+	// Uploads the indices of each group relative to the smallest vertex it uses, which the draw calls add back as the base
+	// vertex, and in 16 instead of 32 bits if the group spans fewer than 65535 vertices. The groups with 16 bit indices
+	// come first in the index buffer, followed by the others at the next multiple of 4 bytes, so that the offset of an
+	// index only depends on its position and the type of its group.
+	class IndexPacker
+	{
+	public:
+		// 0xFFFF is left free as a primitive restart index
+		static const glm::uint maximumShortRange = 0xFFFF;
+
+		// sets the base vertex and index type of each group, and moves the groups with 16 bit indices to the front of the
+		// index array, each followed by its levels of detail
+		static void sort(std::vector<Group>& groups, std::vector<glm::uint>& indices, std::vector<Cluster>& clusters);
+
+		// number of 16 bit indices of sorted groups
+		static std::size_t shortIndexCount(const std::vector<Group>& groups);
+
+		// contents of the index buffer for the sorted groups, which keeps the restart index of StripBuilder as the
+		// largest value of each type
+		static std::vector<std::uint8_t> pack(const std::vector<Group>& groups, const glm::uint* indices, std::size_t indexCount, std::size_t shortIndexCount);
+
+		// offset in bytes of the index at the given position of a group in the packed buffer
+		static std::size_t offset(const Group& group, glm::uint index, std::size_t shortIndexCount);
+	};
+
+}
@@ -0,0 +1,204 @@
+#include "LoadReport.h"
+#include "MemoryUsage.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <globjects/globjects.h>
+#include <globjects/logging.h>
+
+using namespace minity;
+
+namespace
+{
+	std::string escapeJson(const std::string& text)
+	{
+		std::string escaped;
+
+		for (char c : text)
+		{
+			// control characters are not allowed in JSON strings
+			if (static_cast<unsigned char>(c) < 0x20)
+			{
+				static const char digits[] = "0123456789abcdef";
+				escaped += "\\u00";
+				escaped += digits[c >> 4];
+				escaped += digits[c & 0xf];
+				continue;
+			}
+
+			if (c == '"' || c == '\\')
+				escaped += '\\';
+
+			escaped += c;
+		}
+
+		return escaped;
+	}
+}
+
+const char* LoadReport::phaseName(Phase phase)
+{
+	static const char* names[phaseCount] = { "file I/O", "tokenizing", "triangulation", "material parsing", "normal generation", "tangent generation", "mesh optimization", "cluster building", "LOD generation", "vertex welding", "bounds", "texture decode", "upload" };
+	return names[std::size_t(phase)];
+}
+
+LoadReport::Timer::Timer(LoadReport* report, Phase phase) : m_report(report), m_phase(phase)
+{
+	if (m_report)
+		m_startTime = std::chrono::steady_clock::now();
+}
+
+LoadReport::Timer::~Timer()
+{
+	stop();
+}
+
+void LoadReport::Timer::stop()
+{
+	if (m_report)
+	{
+		const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - m_startTime;
+		m_report->addTime(m_phase, duration.count());
+		m_report = nullptr;
+	}
+}
+
+LoadReport::LoadReport(const std::string& filename) : m_filename(filename), m_startTime(std::chrono::steady_clock::now())
+{
+
+}
+
+void LoadReport::addTime(Phase phase, double milliseconds)
+{
+	m_times[std::size_t(phase)] += milliseconds;
+}
+
+double LoadReport::time(Phase phase) const
+{
+	return m_times[std::size_t(phase)];
+}
+
+void LoadReport::addBytesRead(std::uint64_t bytes)
+{
+	m_bytesRead += bytes;
+}
+
+void LoadReport::setCacheUsed(bool cacheUsed)
+{
+	m_cacheUsed = cacheUsed;
+}
+
+void LoadReport::setCounts(std::size_t vertexCount, std::size_t indexCount, std::size_t groupCount, std::size_t materialCount, std::size_t textureCount)
+{
+	m_vertexCount = vertexCount;
+	m_indexCount = indexCount;
+	m_groupCount = groupCount;
+	m_materialCount = materialCount;
+	m_textureCount = textureCount;
+}
+
+void LoadReport::setVertexSize(std::size_t vertexSize)
+{
+	m_vertexSize = vertexSize;
+}
+
+void LoadReport::setQuantizationError(float positionError, float directionError, float texCoordError)
+{
+	m_quantized = true;
+	m_positionError = positionError;
+	m_directionError = directionError;
+	m_texCoordError = texCoordError;
+}
+
+void LoadReport::setAcmr(double before, double after)
+{
+	m_optimized = true;
+	m_acmrBefore = before;
+	m_acmrAfter = after;
+}
+
+void LoadReport::finish()
+{
+	const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - m_startTime;
+	m_totalTime = duration.count();
+	m_peakMemory = MemoryUsage::peakResidentSize();
+}
+
+void LoadReport::print() const
+{
+	std::stringstream report;
+	report << std::fixed << std::setprecision(1);
+	report << "Load report for " << m_filename << (m_cacheUsed ? " (from mesh cache)" : "") << std::endl;
+
+	for (std::size_t i = 0; i < phaseCount; i++)
+		report << "  " << std::left << std::setw(20) << phaseName(Phase(i)) << std::right << std::setw(10) << m_times[i] << " ms" << std::endl;
+
+	report << "  " << std::left << std::setw(20) << "total" << std::right << std::setw(10) << m_totalTime << " ms" << std::endl;
+	report << "  bytes read:        " << m_bytesRead << std::endl;
+	report << "  peak memory:       " << m_peakMemory / (1 << 20) << " MB" << std::endl;
+	report << "  vertices:          " << m_vertexCount << std::endl;
+	report << "  indices:           " << m_indexCount << std::endl;
+	report << "  groups:            " << m_groupCount << std::endl;
+	report << "  materials:         " << m_materialCount << std::endl;
+	report << "  textures:          " << m_textureCount << std::endl;
+	report << "  vertex size:       " << m_vertexSize << " bytes" << std::endl;
+
+	if (m_optimized)
+		report << "  ACMR:              " << std::setprecision(3) << m_acmrBefore << " before, " << m_acmrAfter << " after optimization" << std::setprecision(1) << std::endl;
+
+	if (m_quantized)
+		report << "  quantization error: position " << std::setprecision(6) << m_positionError << ", normal " << m_directionError << " degrees, texcoord " << m_texCoordError << std::setprecision(1) << std::endl;
+
+	report << "  dedup ratio:       " << std::setprecision(2) << (m_vertexCount > 0 ? double(m_indexCount) / double(m_vertexCount) : 0.0) << " indices per vertex";
+
+	globjects::debug() << report.str();
+}
+
+bool LoadReport::writeJson(const std::string& filename) const
+{
+	std::ofstream os(filename);
+
+	if (!os.is_open())
+		return false;
+
+	os << std::fixed << std::setprecision(3);
+	os << "{" << std::endl;
+	os << "  \"file\": \"" << escapeJson(m_filename) << "\"," << std::endl;
+	os << "  \"cacheUsed\": " << (m_cacheUsed ? "true" : "false") << "," << std::endl;
+	os << "  \"phaseMilliseconds\": {" << std::endl;
+
+	for (std::size_t i = 0; i < phaseCount; i++)
+		os << "    \"" << phaseName(Phase(i)) << "\": " << m_times[i] << (i + 1 < phaseCount ? "," : "") << std::endl;
+
+	os << "  }," << std::endl;
+	os << "  \"totalMilliseconds\": " << m_totalTime << "," << std::endl;
+	os << "  \"bytesRead\": " << m_bytesRead << "," << std::endl;
+	os << "  \"peakMemory\": " << m_peakMemory << "," << std::endl;
+	os << "  \"vertexCount\": " << m_vertexCount << "," << std::endl;
+	os << "  \"indexCount\": " << m_indexCount << "," << std::endl;
+	os << "  \"groupCount\": " << m_groupCount << "," << std::endl;
+	os << "  \"materialCount\": " << m_materialCount << "," << std::endl;
+	os << "  \"textureCount\": " << m_textureCount << "," << std::endl;
+	os << "  \"vertexSize\": " << m_vertexSize << "," << std::endl;
+
+	if (m_optimized)
+	{
+		os << "  \"acmrBefore\": " << m_acmrBefore << "," << std::endl;
+		os << "  \"acmrAfter\": " << m_acmrAfter << "," << std::endl;
+	}
+
+	if (m_quantized)
+	{
+		os << std::setprecision(6);
+		os << "  \"positionError\": " << m_positionError << "," << std::endl;
+		os << "  \"normalErrorDegrees\": " << m_directionError << "," << std::endl;
+		os << "  \"texCoordError\": " << m_texCoordError << "," << std::endl;
+		os << std::setprecision(3);
+	}
+
+	os << "  \"dedupRatio\": " << (m_vertexCount > 0 ? double(m_indexCount) / double(m_vertexCount) : 0.0) << std::endl;
+	os << "}" << std::endl;
+
+	return os.good();
+}
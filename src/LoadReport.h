@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace minity
+{
+	// Time per loading phase, bytes read, peak memory and mesh statistics of one Model::load call.
+	// All measurements go through pointers that are null when no report was requested, so that they cost nothing then.
+	class LoadReport
+	{
+	public:
+		enum class Phase
+		{
+			FileIO,
+			Tokenizing,
+			Triangulation,
+			MaterialParsing,
+			NormalGeneration,
+			TangentGeneration,
+			MeshOptimization,
+			ClusterBuilding,
+			LodGeneration,
+			VertexWelding,
+			Bounds,
+			TextureDecode,
+			Upload
+		};
+
+		static const std::size_t phaseCount = 13;
+		static const char* phaseName(Phase phase);
+
+		// adds the time from construction to destruction to a phase of the report, if there is one
+		class Timer
+		{
+		public:
+			Timer(LoadReport* report, Phase phase);
+			~Timer();
+
+			Timer(const Timer&) = delete;
+			Timer& operator=(const Timer&) = delete;
+
+			// adds the time so far, for phases that end before the scope does
+			void stop();
+
+		private:
+			LoadReport* m_report;
+			Phase m_phase;
+			std::chrono::steady_clock::time_point m_startTime;
+		};
+
+		LoadReport(const std::string& filename);
+
+		void addTime(Phase phase, double milliseconds);
+		double time(Phase phase) const;
+		void addBytesRead(std::uint64_t bytes);
+
+		void setCacheUsed(bool cacheUsed);
+		void setCounts(std::size_t vertexCount, std::size_t indexCount, std::size_t groupCount, std::size_t materialCount, std::size_t textureCount);
+		void setVertexSize(std::size_t vertexSize);
+		// largest errors of packed vertices, position in model units and normals and tangents in degrees
+		void setQuantizationError(float positionError, float directionError, float texCoordError);
+		// average cache miss ratio before and after the mesh optimization
+		void setAcmr(double before, double after);
+
+		// stops the total time and records the peak memory
+		void finish();
+
+		void print() const;
+		bool writeJson(const std::string& filename) const;
+
+	private:
+		std::string m_filename;
+		std::chrono::steady_clock::time_point m_startTime;
+		double m_totalTime = 0.0;
+		double m_times[phaseCount] = {};
+		std::uint64_t m_bytesRead = 0;
+		std::size_t m_peakMemory = 0;
+		bool m_cacheUsed = false;
+
+		std::size_t m_vertexCount = 0;
+		std::size_t m_indexCount = 0;
+		std::size_t m_groupCount = 0;
+		std::size_t m_materialCount = 0;
+		std::size_t m_textureCount = 0;
+		std::size_t m_vertexSize = 0;
+
+		bool m_quantized = false;
+		float m_positionError = 0.0f;
+		float m_directionError = 0.0f;
+		float m_texCoordError = 0.0f;
+
+		bool m_optimized = false;
+		double m_acmrBefore = 0.0;
+		double m_acmrAfter = 0.0;
+	};
+
+}
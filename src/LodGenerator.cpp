@@ -0,0 +1,501 @@
+#include "LodGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <unordered_map>
+
+using namespace minity;
+using namespace glm;
+
+namespace
+{
+	// cosine of the largest angle by which a collapse may turn the normal of a remaining triangle
+	const float maximumNormalChange = 0.25f;
+
+	// sum of the squared distances to a set of planes, weighted by the areas of their triangles -- the error of a
+	// position is the weighted mean, so that it is a squared distance in model units
+	struct Quadric
+	{
+		double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+		double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+		double c = 0.0;
+		double weight = 0.0;
+
+		void addPlane(const dvec3& n, double d, double w)
+		{
+			a00 += w * n.x * n.x; a01 += w * n.x * n.y; a02 += w * n.x * n.z;
+			a11 += w * n.y * n.y; a12 += w * n.y * n.z; a22 += w * n.z * n.z;
+			b0 += w * n.x * d; b1 += w * n.y * d; b2 += w * n.z * d;
+			c += w * d * d;
+			weight += w;
+		}
+
+		Quadric& operator+=(const Quadric& q)
+		{
+			a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+			b0 += q.b0; b1 += q.b1; b2 += q.b2;
+			c += q.c;
+			weight += q.weight;
+			return *this;
+		}
+
+		double error(const vec3& position) const
+		{
+			if (weight <= 0.0)
+				return 0.0;
+
+			const double x = position.x, y = position.y, z = position.z;
+			const double e = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+
+			return std::max(e, 0.0) / weight;
+		}
+	};
+
+	// collapses edges of one triangle list, in passes over all edges in order of increasing error
+	class Simplifier
+	{
+	public:
+		Simplifier(const uint* indices, std::size_t indexCount, const std::vector<Vertex>& vertices);
+
+		// collapses edges until at most targetTriangleCount triangles are left or no collapse is possible
+		void simplify(std::size_t targetTriangleCount);
+
+		std::size_t triangleCount() const
+		{
+			return m_triangles.size() / 3;
+		}
+
+		// largest collapse error so far as a distance
+		float error() const
+		{
+			return float(std::sqrt(m_maximumError));
+		}
+
+		std::vector<uint> indices() const;
+
+	private:
+		struct Collapse
+		{
+			uint from;
+			uint to;
+			double error;
+		};
+
+		// returns whether any edge was collapsed
+		bool collapseEdges(std::size_t targetTriangleCount);
+
+		// the triangles around a vertex must not flip or connect to neighbors the other vertex already shares an edge with
+		bool collapseValid(uint from, uint to, const std::vector<uint>& offsets, const std::vector<uint>& adjacency, const std::vector<uint>& remap) const;
+
+		// local vertices of the triangles, with their global indices and positions
+		std::vector<uint> m_vertices;
+		std::vector<vec3> m_positions;
+		// the first local vertex at the same position, which carries the quadric and topology of all of them
+		std::vector<uint> m_canonical;
+		std::vector<unsigned char> m_locked;
+		std::vector<Quadric> m_quadrics;
+		std::vector<uint> m_triangles;
+		double m_maximumError = 0.0;
+	};
+
+	Simplifier::Simplifier(const uint* indices, std::size_t indexCount, const std::vector<Vertex>& vertices)
+	{
+		std::unordered_map<uint, uint> localVertices;
+		m_triangles.resize(indexCount / 3 * 3);
+
+		for (std::size_t i = 0; i < m_triangles.size(); i++)
+		{
+			const auto inserted = localVertices.emplace(indices[i], uint(m_vertices.size()));
+
+			if (inserted.second)
+			{
+				m_vertices.push_back(indices[i]);
+				m_positions.push_back(vertices[indices[i]].position);
+			}
+
+			m_triangles[i] = inserted.first->second;
+		}
+
+		const std::size_t vertexCount = m_vertices.size();
+
+		// vertices with equal positions differ in their attributes, the seam between them cannot move
+		std::vector<uint> sorted(vertexCount);
+		std::iota(sorted.begin(), sorted.end(), 0);
+
+		std::sort(sorted.begin(), sorted.end(), [this](uint a, uint b)
+		{
+			const vec3& pa = m_positions[a];
+			const vec3& pb = m_positions[b];
+			return pa.x < pb.x || (pa.x == pb.x && (pa.y < pb.y || (pa.y == pb.y && (pa.z < pb.z || (pa.z == pb.z && a < b)))));
+		});
+
+		m_canonical.resize(vertexCount);
+		m_locked.assign(vertexCount, 0);
+
+		for (std::size_t i = 0; i < vertexCount; i++)
+		{
+			const bool same = i > 0 && m_positions[sorted[i]] == m_positions[sorted[i - 1]];
+			m_canonical[sorted[i]] = same ? m_canonical[sorted[i - 1]] : sorted[i];
+
+			if (same)
+				m_locked[m_canonical[sorted[i]]] = 1;
+		}
+
+		// triangles that are already degenerate are removed
+		std::size_t kept = 0;
+
+		for (std::size_t t = 0; t < m_triangles.size(); t += 3)
+		{
+			const uint c0 = m_canonical[m_triangles[t + 0]];
+			const uint c1 = m_canonical[m_triangles[t + 1]];
+			const uint c2 = m_canonical[m_triangles[t + 2]];
+
+			if (c0 == c1 || c1 == c2 || c2 == c0)
+				continue;
+
+			std::copy(m_triangles.begin() + t, m_triangles.begin() + t + 3, m_triangles.begin() + kept);
+			kept += 3;
+		}
+
+		m_triangles.resize(kept);
+
+		// an edge without a twin in the opposite direction is on the border, one that appears twice is non-manifold
+		std::vector<std::uint64_t> edges;
+		edges.reserve(m_triangles.size());
+
+		for (std::size_t t = 0; t < m_triangles.size(); t += 3)
+		{
+			for (int e = 0; e < 3; e++)
+			{
+				const uint a = m_canonical[m_triangles[t + e]];
+				const uint b = m_canonical[m_triangles[t + (e + 1) % 3]];
+				edges.push_back(std::uint64_t(a) << 32 | b);
+			}
+		}
+
+		std::sort(edges.begin(), edges.end());
+
+		for (std::size_t i = 0; i < edges.size(); i++)
+		{
+			const uint a = uint(edges[i] >> 32);
+			const uint b = uint(edges[i] & 0xffffffffu);
+			const bool duplicate = (i > 0 && edges[i - 1] == edges[i]) || (i + 1 < edges.size() && edges[i + 1] == edges[i]);
+
+			if (duplicate || !std::binary_search(edges.begin(), edges.end(), std::uint64_t(b) << 32 | a))
+			{
+				m_locked[a] = 1;
+				m_locked[b] = 1;
+			}
+		}
+
+		m_quadrics.resize(vertexCount);
+
+		for (std::size_t t = 0; t < m_triangles.size(); t += 3)
+		{
+			const dvec3 p0 = dvec3(m_positions[m_triangles[t + 0]]);
+			const dvec3 p1 = dvec3(m_positions[m_triangles[t + 1]]);
+			const dvec3 p2 = dvec3(m_positions[m_triangles[t + 2]]);
+			const dvec3 n = cross(p1 - p0, p2 - p0);
+			const double l = length(n);
+
+			if (l <= 0.0)
+				continue;
+
+			for (int c = 0; c < 3; c++)
+				m_quadrics[m_canonical[m_triangles[t + c]]].addPlane(n / l, -dot(n / l, p0), l * 0.5);
+		}
+	}
+
+	void Simplifier::simplify(std::size_t targetTriangleCount)
+	{
+		while (triangleCount() > targetTriangleCount && collapseEdges(targetTriangleCount))
+			;
+	}
+
+	std::vector<uint> Simplifier::indices() const
+	{
+		std::vector<uint> result(m_triangles.size());
+
+		for (std::size_t i = 0; i < m_triangles.size(); i++)
+			result[i] = m_vertices[m_triangles[i]];
+
+		return result;
+	}
+
+	bool Simplifier::collapseEdges(std::size_t targetTriangleCount)
+	{
+		const std::size_t vertexCount = m_vertices.size();
+
+		// each undirected edge once, between the local vertices of the first triangle using it
+		std::vector< std::pair<std::uint64_t, std::uint64_t> > edges;
+		edges.reserve(m_triangles.size());
+
+		for (std::size_t t = 0; t < m_triangles.size(); t += 3)
+		{
+			for (int e = 0; e < 3; e++)
+			{
+				const uint a = m_triangles[t + e];
+				const uint b = m_triangles[t + (e + 1) % 3];
+				const uint ca = m_canonical[a];
+				const uint cb = m_canonical[b];
+
+				if (m_locked[ca] && m_locked[cb])
+					continue;
+
+				edges.push_back({ std::uint64_t(std::min(ca, cb)) << 32 | std::max(ca, cb), std::uint64_t(a) << 32 | b });
+			}
+		}
+
+		std::stable_sort(edges.begin(), edges.end(), [](const auto& x, const auto& y) { return x.first < y.first; });
+		edges.erase(std::unique(edges.begin(), edges.end(), [](const auto& x, const auto& y) { return x.first == y.first; }), edges.end());
+
+		// each edge collapses in the direction with the smaller error, onto the position of the remaining vertex
+		std::vector<Collapse> collapses;
+		collapses.reserve(edges.size());
+
+		for (const auto& edge : edges)
+		{
+			const uint a = uint(edge.second >> 32);
+			const uint b = uint(edge.second & 0xffffffffu);
+			Quadric q = m_quadrics[m_canonical[a]];
+			q += m_quadrics[m_canonical[b]];
+
+			Collapse collapse = { 0, 0, -1.0 };
+
+			if (!m_locked[m_canonical[a]])
+				collapse = { a, b, q.error(m_positions[b]) };
+
+			if (!m_locked[m_canonical[b]])
+			{
+				const double error = q.error(m_positions[a]);
+
+				if (collapse.error < 0.0 || error < collapse.error)
+					collapse = { b, a, error };
+			}
+
+			collapses.push_back(collapse);
+		}
+
+		if (collapses.empty())
+			return false;
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& x, const Collapse& y) { return x.error < y.error; });
+
+		// every collapse removes about two triangles -- a pass stops at the goal, and skips collapses much worse than
+		// the one at the goal, which are taken in a later pass once the quadrics around them have been updated
+		const std::size_t collapseGoal = std::max<std::size_t>((triangleCount() - targetTriangleCount) / 2, 1);
+		const double errorLimit = collapses[std::min(collapseGoal, collapses.size()) - 1].error * 1.5;
+
+		// triangles around each canonical vertex
+		std::vector<uint> offsets(vertexCount + 1, 0);
+
+		for (uint v : m_triangles)
+			offsets[m_canonical[v] + 1]++;
+
+		std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+		std::vector<uint> adjacency(m_triangles.size());
+		std::vector<uint> cursors(offsets.begin(), offsets.end() - 1);
+
+		for (std::size_t i = 0; i < m_triangles.size(); i++)
+			adjacency[cursors[m_canonical[m_triangles[i]]]++] = uint(i / 3);
+
+		std::vector<uint> remap(vertexCount);
+		std::iota(remap.begin(), remap.end(), 0);
+
+		// vertices of a collapse do not take part in another one in the same pass, whose quadric would be outdated
+		std::vector<unsigned char> collapsed(vertexCount, 0);
+		std::size_t remainingTriangles = triangleCount();
+		std::size_t collapseCount = 0;
+
+		for (const Collapse& collapse : collapses)
+		{
+			if (collapseCount >= collapseGoal || remainingTriangles <= targetTriangleCount)
+				break;
+
+			if (collapse.error > errorLimit && collapse.error > 0.0)
+				break;
+
+			const uint from = m_canonical[collapse.from];
+			const uint to = m_canonical[collapse.to];
+
+			if (collapsed[from] || collapsed[to])
+				continue;
+
+			if (!collapseValid(collapse.from, collapse.to, offsets, adjacency, remap))
+				continue;
+
+			for (uint a = offsets[from]; a < offsets[from + 1]; a++)
+			{
+				for (int c = 0; c < 3; c++)
+				{
+					if (m_canonical[remap[m_triangles[adjacency[a] * 3 + c]]] == to)
+						remainingTriangles--;
+				}
+			}
+
+			// an unlocked vertex is the only one at its position
+			remap[collapse.from] = collapse.to;
+			m_quadrics[to] += m_quadrics[from];
+			m_maximumError = std::max(m_maximumError, collapse.error);
+
+			collapsed[from] = 1;
+			collapsed[to] = 1;
+			collapseCount++;
+		}
+
+		if (collapseCount == 0)
+			return false;
+
+		std::size_t kept = 0;
+
+		for (std::size_t t = 0; t < m_triangles.size(); t += 3)
+		{
+			const uint v0 = remap[m_triangles[t + 0]];
+			const uint v1 = remap[m_triangles[t + 1]];
+			const uint v2 = remap[m_triangles[t + 2]];
+
+			if (m_canonical[v0] == m_canonical[v1] || m_canonical[v1] == m_canonical[v2] || m_canonical[v2] == m_canonical[v0])
+				continue;
+
+			m_triangles[kept++] = v0;
+			m_triangles[kept++] = v1;
+			m_triangles[kept++] = v2;
+		}
+
+		m_triangles.resize(kept);
+
+		return true;
+	}
+
+	bool Simplifier::collapseValid(uint from, uint to, const std::vector<uint>& offsets, const std::vector<uint>& adjacency, const std::vector<uint>& remap) const
+	{
+		const uint canonicalFrom = m_canonical[from];
+		const uint canonicalTo = m_canonical[to];
+
+		// the neighbors of both vertices, which may only share the opposite vertices of the triangles on their edge
+		std::vector<uint> neighborsFrom;
+		std::vector<uint> neighborsTo;
+		std::vector<uint> opposite;
+
+		for (uint a = offsets[canonicalFrom]; a < offsets[canonicalFrom + 1]; a++)
+		{
+			const uint* triangle = &m_triangles[adjacency[a] * 3];
+			uint v[3];
+			int corner = -1;
+			bool containsTo = false;
+
+			for (int c = 0; c < 3; c++)
+			{
+				v[c] = remap[triangle[c]];
+
+				if (m_canonical[v[c]] == canonicalFrom)
+					corner = c;
+				else if (m_canonical[v[c]] == canonicalTo)
+					containsTo = true;
+			}
+
+			if (corner < 0)
+				continue;
+
+			const uint c1 = m_canonical[v[(corner + 1) % 3]];
+			const uint c2 = m_canonical[v[(corner + 2) % 3]];
+
+			// already degenerate in this pass
+			if (c1 == c2)
+				continue;
+
+			neighborsFrom.push_back(c1);
+			neighborsFrom.push_back(c2);
+
+			if (containsTo)
+			{
+				opposite.push_back(c1 == canonicalTo ? c2 : c1);
+				continue;
+			}
+
+			// the triangles that stay must not turn over, or turn so far that a series of collapses could flip them
+			const vec3& p1 = m_positions[v[(corner + 1) % 3]];
+			const vec3& p2 = m_positions[v[(corner + 2) % 3]];
+			const vec3 before = cross(p1 - m_positions[from], p2 - m_positions[from]);
+			const vec3 after = cross(p1 - m_positions[to], p2 - m_positions[to]);
+
+			if (dot(before, after) <= maximumNormalChange * length(before) * length(after))
+				return false;
+		}
+
+		for (uint a = offsets[canonicalTo]; a < offsets[canonicalTo + 1]; a++)
+		{
+			const uint* triangle = &m_triangles[adjacency[a] * 3];
+
+			for (int c = 0; c < 3; c++)
+				neighborsTo.push_back(m_canonical[remap[triangle[c]]]);
+		}
+
+		// triangles remapped onto the target vertex in this pass are not in its adjacency yet
+		for (uint n : neighborsFrom)
+		{
+			if (n == canonicalTo || std::find(opposite.begin(), opposite.end(), n) != opposite.end())
+				continue;
+
+			if (std::find(neighborsTo.begin(), neighborsTo.end(), n) != neighborsTo.end())
+				return false;
+		}
+
+		return true;
+	}
+}
+
+std::vector< std::vector<uint> > LodGenerator::simplify(const uint* indices, std::size_t indexCount, const std::vector<Vertex>& vertices, std::vector<float>& errors)
+{
+	std::vector< std::vector<uint> > levels;
+	errors.clear();
+
+	Simplifier simplifier(indices, indexCount, vertices);
+	std::size_t previousCount = indexCount / 3;
+
+	while (levels.size() < maximumLevelCount && previousCount >= 2 * minimumTriangleCount)
+	{
+		simplifier.simplify(previousCount / 2);
+
+		// a level that removes only a few triangles is not worth switching to
+		if (simplifier.triangleCount() * 5 > previousCount * 4)
+			break;
+
+		previousCount = simplifier.triangleCount();
+		levels.push_back(simplifier.indices());
+		errors.push_back(simplifier.error());
+	}
+
+	return levels;
+}
+
+void LodGenerator::generate(std::vector<Group>& groups, std::vector<uint>& indices, const std::vector<Vertex>& vertices, ThreadPool& pool)
+{
+	std::vector< std::vector< std::vector<uint> > > levels(groups.size());
+	std::vector< std::vector<float> > errors(groups.size());
+
+	pool.parallelFor(groups.size(), [&](std::size_t g)
+	{
+		levels[g] = simplify(indices.data() + groups[g].startIndex, groups[g].endIndex - groups[g].startIndex, vertices, errors[g]);
+	});
+
+	for (std::size_t g = 0; g < groups.size(); g++)
+	{
+		groups[g].lods.clear();
+
+		for (std::size_t l = 0; l < levels[g].size(); l++)
+		{
+			GroupLod lod;
+			lod.startIndex = uint(indices.size());
+			indices.insert(indices.end(), levels[g][l].begin(), levels[g][l].end());
+			lod.endIndex = uint(indices.size());
+			lod.error = errors[g][l];
+			groups[g].lods.push_back(lod);
+
+			std::vector<uint>().swap(levels[g][l]);
+		}
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Model.h"
+#include "ThreadPool.h"
+
+#include <vector>
+
+namespace minity
+{
+	// Builds coarser levels of detail of each group by edge collapses with the quadric error metric (Garland and
+	// Heckbert, "Surface Simplification Using Quadric Error Metrics", 1997). Vertices only move onto other vertices,
+	// so all levels index the vertex array of the full group. Vertices on the border of a group, on attribute seams
+	// and on non-manifold edges are kept in place, so that adjacent groups at different levels do not crack apart.
+	class LodGenerator
+	{
+	public:
+		// each level has about half the triangles of the previous one, up to this many levels per group
+		static const glm::uint maximumLevelCount = 12;
+		// groups are not simplified further once a level has fewer triangles than this
+		static const glm::uint minimumTriangleCount = 32;
+
+		// appends the indices of the levels of all groups to indices, and adds the levels to their groups
+		static void generate(std::vector<Group>& groups, std::vector<glm::uint>& indices, const std::vector<Vertex>& vertices, ThreadPool& pool);
+
+		// the levels of one triangle list, as index lists into the same vertices with their errors -- stops early when
+		// the simplification stalls, e.g., because only locked vertices are left
+		static std::vector< std::vector<glm::uint> > simplify(const glm::uint* indices, std::size_t indexCount, const std::vector<Vertex>& vertices, std::vector<float>& errors);
+	};
+
+}
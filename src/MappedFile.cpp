@@ -0,0 +1,155 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace minity;
+
+MappedFile::MappedFile()
+{
+
+}
+
+MappedFile::MappedFile(const std::string& filename, bool sequential)
+{
+	open(filename, sequential);
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const std::string& filename, bool sequential)
+{
+	close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | (sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS), nullptr);
+
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	m_file = file;
+	m_size = std::size_t(fileSize.QuadPart);
+	m_open = true;
+
+	// empty files cannot be mapped, but are still valid (and empty) input
+	if (m_size == 0)
+		return true;
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (mapping == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	m_mapping = mapping;
+	m_data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+
+	if (m_data == nullptr)
+	{
+		close();
+		return false;
+	}
+#else
+	int file = ::open(filename.c_str(), O_RDONLY);
+
+	if (file < 0)
+		return false;
+
+	struct stat status;
+
+	if (fstat(file, &status) != 0)
+	{
+		::close(file);
+		return false;
+	}
+
+	m_size = std::size_t(status.st_size);
+	m_open = true;
+
+	if (m_size > 0)
+	{
+		void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+		if (data == MAP_FAILED)
+		{
+			::close(file);
+			m_size = 0;
+			m_open = false;
+			return false;
+		}
+
+		madvise(data, m_size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+		m_data = static_cast<const char*>(data);
+	}
+
+	// the mapping stays valid after closing the descriptor
+	::close(file);
+#endif
+
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (m_data)
+		UnmapViewOfFile(m_data);
+
+	if (m_mapping)
+		CloseHandle(m_mapping);
+
+	if (m_file)
+		CloseHandle(m_file);
+
+	m_mapping = nullptr;
+	m_file = nullptr;
+#else
+	if (m_data)
+		munmap(const_cast<char*>(m_data), m_size);
+#endif
+
+	m_data = nullptr;
+	m_size = 0;
+	m_open = false;
+}
+
+bool MappedFile::isOpen() const
+{
+	return m_open;
+}
+
+const char* MappedFile::data() const
+{
+	return m_data;
+}
+
+const char* MappedFile::end() const
+{
+	return m_data + m_size;
+}
+
+std::size_t MappedFile::size() const
+{
+	return m_size;
+}
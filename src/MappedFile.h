@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+namespace minity
+{
+	// Read-only memory mapping of a whole file, used to parse large files without copying them into stream buffers
+	class MappedFile
+	{
+	public:
+		MappedFile();
+		MappedFile(const std::string& filename, bool sequential = true);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		// sequential tells the system that the file is read from front to back, which enables aggressive read-ahead
+		bool open(const std::string& filename, bool sequential = true);
+		void close();
+
+		bool isOpen() const;
+		const char* data() const;
+		const char* end() const;
+		std::size_t size() const;
+
+	private:
+		const char* m_data = nullptr;
+		std::size_t m_size = 0;
+		bool m_open = false;
+
+#ifdef _WIN32
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+#endif
+	};
+
+}
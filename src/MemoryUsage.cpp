@@ -0,0 +1,59 @@
+#include "MemoryUsage.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#include <fstream>
+#endif
+
+using namespace minity;
+
+std::size_t MemoryUsage::residentSize()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+
+	return counters.WorkingSetSize;
+#else
+	// the second field is the number of resident pages
+	std::ifstream statm("/proc/self/statm");
+	std::size_t pages = 0, residentPages = 0;
+
+	if (!(statm >> pages >> residentPages))
+		return 0;
+
+	return residentPages * std::size_t(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+std::size_t MemoryUsage::peakResidentSize()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+
+	return counters.PeakWorkingSetSize;
+#else
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+
+#ifdef __APPLE__
+	// bytes on macOS, kilobytes elsewhere
+	return std::size_t(usage.ru_maxrss);
+#else
+	return std::size_t(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+
+namespace minity
+{
+	// Resident memory of the process, as reported by the operating system (0 where unavailable)
+	class MemoryUsage
+	{
+	public:
+		// bytes currently held in physical memory, including mapped files
+		static std::size_t residentSize();
+
+		// highest resident size since the process started
+		static std::size_t peakResidentSize();
+	};
+
+}
@@ -0,0 +1,543 @@
+#include "MeshCache.h"
+#include "FileUtility.h"
+
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+#include <globjects/globjects.h>
+#include <globjects/logging.h>
+
+using namespace minity;
+using namespace glm;
+
+namespace
+{
+	const char magic[8] = { 'M','C','A','C','H','E','\r','\n' };
+
+	struct CacheString
+	{
+		std::uint32_t offset;
+		std::uint32_t length;
+	};
+
+	struct CacheGroup
+	{
+		CacheString name;
+		std::uint32_t materialIndex;
+		std::uint32_t startIndex;
+		std::uint32_t endIndex;
+		vec3 maxBounds;
+		vec3 minBounds;
+		vec3 centerMass;
+		// levels of detail of the group in the LOD section
+		std::uint32_t firstLod;
+		std::uint32_t lodCount;
+		// clusters of the group in the cluster section
+		std::uint32_t firstCluster;
+		std::uint32_t clusterCount;
+		// base vertex and whether the indices are packed into 16 bits, see IndexPacker
+		std::uint32_t baseVertex;
+		std::uint32_t shortIndices;
+	};
+
+	struct CacheCluster
+	{
+		std::uint32_t startIndex;
+		std::uint32_t endIndex;
+		vec3 minBounds;
+		vec3 maxBounds;
+		vec3 coneAxis;
+		float coneCutoff;
+	};
+
+	struct CacheLod
+	{
+		std::uint32_t startIndex;
+		std::uint32_t endIndex;
+		float error;
+	};
+
+	struct CacheMaterial
+	{
+		CacheString name;
+		vec3 ambient;
+		vec3 diffuse;
+		vec3 specular;
+		float shininess;
+		CacheString ambientTexture;
+		CacheString diffuseTexture;
+		CacheString specularTexture;
+		CacheString shininessTexture;
+		CacheString bumpTexture;
+		CacheString normalTexture;
+		CacheString tangentTexture;
+	};
+
+	struct CacheDependency
+	{
+		CacheString path;
+		std::uint64_t size;
+		std::int64_t time;
+		std::uint64_t hash;
+	};
+
+	// all sections start at multiples of this, so that the vertex and index data can be used in place
+	const std::uint64_t sectionAlignment = 16;
+
+	// size of a dependency that did not exist when the cache was written, which becomes stale once the file appears
+	const std::uint64_t missingFileSize = ~std::uint64_t(0);
+
+	bool sectionValid(std::uint64_t offset, std::uint64_t count, std::uint64_t elementSize, std::uint64_t fileSize)
+	{
+		return offset <= fileSize && count <= (fileSize - offset) / elementSize;
+	}
+}
+
+struct MeshCache::Header
+{
+	char magic[8];
+	std::uint32_t version;
+	std::uint32_t vertexSize;
+	std::uint64_t key;
+
+	std::uint64_t vertexOffset;
+	std::uint64_t vertexCount;
+	std::uint64_t indexOffset;
+	std::uint64_t indexCount;
+	std::uint64_t groupOffset;
+	std::uint64_t groupCount;
+	std::uint64_t lodOffset;
+	std::uint64_t lodCount;
+	std::uint64_t clusterOffset;
+	std::uint64_t clusterCount;
+	std::uint64_t materialOffset;
+	std::uint64_t materialCount;
+	std::uint64_t dependencyOffset;
+	std::uint64_t dependencyCount;
+	std::uint64_t stringOffset;
+	std::uint64_t stringSize;
+
+	vec3 minimumBounds;
+	vec3 maximumBounds;
+};
+
+std::string MeshCache::cacheFilename(const std::string& filename)
+{
+	return filename + ".mcache";
+}
+
+bool MeshCache::open(const std::string& cacheFilename, std::uint64_t key)
+{
+	close();
+
+	if (!m_file.open(cacheFilename))
+		return false;
+
+	const std::uint64_t fileSize = m_file.size();
+	const Header* header = reinterpret_cast<const Header*>(m_file.data());
+
+	bool valid = fileSize >= sizeof(Header) &&
+		memcmp(header->magic, magic, sizeof(magic)) == 0 &&
+		header->version == version &&
+		header->vertexSize == sizeof(Vertex) &&
+		header->key == key &&
+		sectionValid(header->vertexOffset, header->vertexCount, sizeof(Vertex), fileSize) &&
+		sectionValid(header->indexOffset, header->indexCount, sizeof(glm::uint), fileSize) &&
+		sectionValid(header->groupOffset, header->groupCount, sizeof(CacheGroup), fileSize) &&
+		sectionValid(header->lodOffset, header->lodCount, sizeof(CacheLod), fileSize) &&
+		sectionValid(header->clusterOffset, header->clusterCount, sizeof(CacheCluster), fileSize) &&
+		sectionValid(header->materialOffset, header->materialCount, sizeof(CacheMaterial), fileSize) &&
+		sectionValid(header->dependencyOffset, header->dependencyCount, sizeof(CacheDependency), fileSize) &&
+		sectionValid(header->stringOffset, header->stringSize, 1, fileSize) &&
+		header->dependencyCount > 0;
+
+	if (!valid)
+	{
+		globjects::debug() << "Mesh cache " << cacheFilename << " is invalid or was written with different settings.";
+		close();
+		return false;
+	}
+
+	m_header = header;
+
+	if (!contentsValid())
+	{
+		globjects::debug() << "Mesh cache " << cacheFilename << " is corrupt.";
+		close();
+		return false;
+	}
+
+	// the cache is stale if any of the source files has changed -- if only the time stamp differs,
+	// we compare the contents, so that files that were merely touched or checked out again do not trigger a rebuild
+	const CacheDependency* dependencies = reinterpret_cast<const CacheDependency*>(m_file.data() + m_header->dependencyOffset);
+
+	for (std::uint64_t i = 0; i < m_header->dependencyCount; i++)
+	{
+		const std::string path = string(dependencies[i].path.offset, dependencies[i].path.length);
+		std::error_code error;
+		const std::uint64_t size = std::filesystem::file_size(path, error);
+
+		if (dependencies[i].size == missingFileSize)
+		{
+			valid = !std::filesystem::exists(path, error) && !error;
+		}
+		else if (error || size != dependencies[i].size)
+		{
+			valid = false;
+		}
+		else if (FileUtility::fileTime(path) != dependencies[i].time)
+		{
+			MappedFile file(path);
+			valid = file.isOpen() && FileUtility::hash(file.data(), file.size()) == dependencies[i].hash;
+		}
+
+		if (!valid)
+		{
+			globjects::debug() << "Mesh cache " << cacheFilename << " is out of date (" << path << " has changed).";
+			close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool MeshCache::contentsValid() const
+{
+	const std::uint64_t indexCount = m_header->indexCount;
+	const glm::uint* indices = this->indices();
+
+	for (std::uint64_t i = 0; i < indexCount; i++)
+	{
+		if (indices[i] >= m_header->vertexCount)
+			return false;
+	}
+
+	auto rangeValid = [indexCount](std::uint32_t startIndex, std::uint32_t endIndex)
+	{
+		return startIndex <= endIndex && endIndex <= indexCount;
+	};
+
+	const CacheGroup* groups = reinterpret_cast<const CacheGroup*>(m_file.data() + m_header->groupOffset);
+	const CacheLod* lods = reinterpret_cast<const CacheLod*>(m_file.data() + m_header->lodOffset);
+	const CacheCluster* clusters = reinterpret_cast<const CacheCluster*>(m_file.data() + m_header->clusterOffset);
+
+	for (std::uint64_t i = 0; i < m_header->groupCount; i++)
+	{
+		const CacheGroup& g = groups[i];
+
+		if (!rangeValid(g.startIndex, g.endIndex) || g.materialIndex >= m_header->materialCount ||
+			std::uint64_t(g.firstLod) + g.lodCount > m_header->lodCount ||
+			std::uint64_t(g.firstCluster) + g.clusterCount > m_header->clusterCount)
+			return false;
+
+		for (std::uint64_t l = g.firstLod; l < std::uint64_t(g.firstLod) + g.lodCount; l++)
+		{
+			if (!rangeValid(lods[l].startIndex, lods[l].endIndex))
+				return false;
+		}
+
+		// the clusters partition the full group
+		for (std::uint64_t c = g.firstCluster; c < std::uint64_t(g.firstCluster) + g.clusterCount; c++)
+		{
+			if (!rangeValid(clusters[c].startIndex, clusters[c].endIndex) || clusters[c].startIndex < g.startIndex || clusters[c].endIndex > g.endIndex)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+void MeshCache::close()
+{
+	m_header = nullptr;
+	m_file.close();
+}
+
+const Vertex* MeshCache::vertices() const
+{
+	return reinterpret_cast<const Vertex*>(m_file.data() + m_header->vertexOffset);
+}
+
+std::size_t MeshCache::vertexCount() const
+{
+	return std::size_t(m_header->vertexCount);
+}
+
+const glm::uint* MeshCache::indices() const
+{
+	return reinterpret_cast<const glm::uint*>(m_file.data() + m_header->indexOffset);
+}
+
+std::size_t MeshCache::indexCount() const
+{
+	return std::size_t(m_header->indexCount);
+}
+
+std::vector<Group> MeshCache::groups() const
+{
+	const CacheGroup* cacheGroups = reinterpret_cast<const CacheGroup*>(m_file.data() + m_header->groupOffset);
+	const CacheLod* cacheLods = reinterpret_cast<const CacheLod*>(m_file.data() + m_header->lodOffset);
+	std::vector<Group> groups(std::size_t(m_header->groupCount));
+
+	for (std::size_t i = 0; i < groups.size(); i++)
+	{
+		const CacheGroup& g = cacheGroups[i];
+		groups[i].name = string(g.name.offset, g.name.length);
+		groups[i].materialIndex = g.materialIndex;
+		groups[i].startIndex = g.startIndex;
+		groups[i].endIndex = g.endIndex;
+		groups[i].maxBounds = g.maxBounds;
+		groups[i].minBounds = g.minBounds;
+		groups[i].centerMass = g.centerMass;
+		groups[i].firstCluster = g.firstCluster;
+		groups[i].clusterCount = g.clusterCount;
+		groups[i].baseVertex = g.baseVertex;
+		groups[i].shortIndices = g.shortIndices != 0;
+
+		for (std::uint64_t l = g.firstLod; l < std::uint64_t(g.firstLod) + g.lodCount; l++)
+		{
+			GroupLod lod;
+			lod.startIndex = cacheLods[l].startIndex;
+			lod.endIndex = cacheLods[l].endIndex;
+			lod.error = cacheLods[l].error;
+			groups[i].lods.push_back(lod);
+		}
+	}
+
+	return groups;
+}
+
+std::vector<Cluster> MeshCache::clusters() const
+{
+	const CacheCluster* cacheClusters = reinterpret_cast<const CacheCluster*>(m_file.data() + m_header->clusterOffset);
+	std::vector<Cluster> clusters(std::size_t(m_header->clusterCount));
+
+	for (std::size_t i = 0; i < clusters.size(); i++)
+	{
+		const CacheCluster& c = cacheClusters[i];
+		clusters[i].startIndex = c.startIndex;
+		clusters[i].endIndex = c.endIndex;
+		clusters[i].minBounds = c.minBounds;
+		clusters[i].maxBounds = c.maxBounds;
+		clusters[i].coneAxis = c.coneAxis;
+		clusters[i].coneCutoff = c.coneCutoff;
+	}
+
+	return clusters;
+}
+
+std::vector<Material> MeshCache::materials() const
+{
+	const CacheMaterial* cacheMaterials = reinterpret_cast<const CacheMaterial*>(m_file.data() + m_header->materialOffset);
+	std::vector<Material> materials(std::size_t(m_header->materialCount));
+
+	for (std::size_t i = 0; i < materials.size(); i++)
+	{
+		const CacheMaterial& m = cacheMaterials[i];
+		materials[i].name = string(m.name.offset, m.name.length);
+		materials[i].ambient = m.ambient;
+		materials[i].diffuse = m.diffuse;
+		materials[i].specular = m.specular;
+		materials[i].shininess = m.shininess;
+		materials[i].ambientTexturePath = string(m.ambientTexture.offset, m.ambientTexture.length);
+		materials[i].diffuseTexturePath = string(m.diffuseTexture.offset, m.diffuseTexture.length);
+		materials[i].specularTexturePath = string(m.specularTexture.offset, m.specularTexture.length);
+		materials[i].shininessTexturePath = string(m.shininessTexture.offset, m.shininessTexture.length);
+		materials[i].bumpTexturePath = string(m.bumpTexture.offset, m.bumpTexture.length);
+		materials[i].normalTexturePath = string(m.normalTexture.offset, m.normalTexture.length);
+		materials[i].tangentTexturePath = string(m.tangentTexture.offset, m.tangentTexture.length);
+	}
+
+	return materials;
+}
+
+vec3 MeshCache::minimumBounds() const
+{
+	return m_header->minimumBounds;
+}
+
+vec3 MeshCache::maximumBounds() const
+{
+	return m_header->maximumBounds;
+}
+
+bool MeshCache::write(const std::string& cacheFilename, std::uint64_t key, const std::vector<std::string>& dependencies, const Model& model)
+{
+	std::string strings;
+
+	auto addString = [&strings](const std::string& s)
+	{
+		CacheString cacheString;
+		cacheString.offset = std::uint32_t(strings.size());
+		cacheString.length = std::uint32_t(s.size());
+		strings += s;
+		return cacheString;
+	};
+
+	std::vector<CacheDependency> cacheDependencies;
+
+	for (auto& d : dependencies)
+	{
+		CacheDependency dependency;
+		dependency.path = addString(std::filesystem::absolute(d).string());
+
+		// a missing material library is recorded as such, so that the cache is rebuilt once it is added
+		std::error_code error;
+
+		if (&d != &dependencies.front() && !std::filesystem::exists(d, error) && !error)
+		{
+			dependency.size = missingFileSize;
+			dependency.time = 0;
+			dependency.hash = 0;
+			cacheDependencies.push_back(dependency);
+			continue;
+		}
+
+		MappedFile file(d);
+
+		if (!file.isOpen())
+			return false;
+
+		dependency.size = file.size();
+		dependency.time = FileUtility::fileTime(d);
+		dependency.hash = FileUtility::hash(file.data(), file.size());
+		cacheDependencies.push_back(dependency);
+	}
+
+	std::vector<CacheGroup> cacheGroups;
+	std::vector<CacheLod> cacheLods;
+
+	for (auto& g : model.groups())
+	{
+		CacheGroup group;
+		group.name = addString(g.name);
+		group.materialIndex = g.materialIndex;
+		group.startIndex = g.startIndex;
+		group.endIndex = g.endIndex;
+		group.maxBounds = g.maxBounds;
+		group.minBounds = g.minBounds;
+		group.centerMass = g.centerMass;
+		group.firstLod = std::uint32_t(cacheLods.size());
+		group.lodCount = std::uint32_t(g.lods.size());
+		group.firstCluster = g.firstCluster;
+		group.clusterCount = g.clusterCount;
+		group.baseVertex = g.baseVertex;
+		group.shortIndices = g.shortIndices ? 1 : 0;
+		cacheGroups.push_back(group);
+
+		for (auto& l : g.lods)
+			cacheLods.push_back({ l.startIndex, l.endIndex, l.error });
+	}
+
+	std::vector<CacheCluster> cacheClusters;
+
+	for (auto& c : model.clusters())
+		cacheClusters.push_back({ c.startIndex, c.endIndex, c.minBounds, c.maxBounds, c.coneAxis, c.coneCutoff });
+
+	std::vector<CacheMaterial> cacheMaterials;
+
+	for (auto& m : model.materials())
+	{
+		CacheMaterial material;
+		material.name = addString(m.name);
+		material.ambient = m.ambient;
+		material.diffuse = m.diffuse;
+		material.specular = m.specular;
+		material.shininess = m.shininess;
+		material.ambientTexture = addString(m.ambientTexturePath);
+		material.diffuseTexture = addString(m.diffuseTexturePath);
+		material.specularTexture = addString(m.specularTexturePath);
+		material.shininessTexture = addString(m.shininessTexturePath);
+		material.bumpTexture = addString(m.bumpTexturePath);
+		material.normalTexture = addString(m.normalTexturePath);
+		material.tangentTexture = addString(m.tangentTexturePath);
+		cacheMaterials.push_back(material);
+	}
+
+	Header header = {};
+	memcpy(header.magic, magic, sizeof(magic));
+	header.version = version;
+	header.vertexSize = sizeof(Vertex);
+	header.key = key;
+	header.minimumBounds = model.minimumBounds();
+	header.maximumBounds = model.maximumBounds();
+
+	std::uint64_t offset = sizeof(Header);
+
+	auto section = [&offset](std::uint64_t size)
+	{
+		offset = (offset + sectionAlignment - 1) / sectionAlignment * sectionAlignment;
+		std::uint64_t sectionOffset = offset;
+		offset += size;
+		return sectionOffset;
+	};
+
+	header.vertexCount = model.vertices().size();
+	header.vertexOffset = section(header.vertexCount * sizeof(Vertex));
+	header.indexCount = model.indices().size();
+	header.indexOffset = section(header.indexCount * sizeof(glm::uint));
+	header.groupCount = cacheGroups.size();
+	header.groupOffset = section(header.groupCount * sizeof(CacheGroup));
+	header.lodCount = cacheLods.size();
+	header.lodOffset = section(header.lodCount * sizeof(CacheLod));
+	header.clusterCount = cacheClusters.size();
+	header.clusterOffset = section(header.clusterCount * sizeof(CacheCluster));
+	header.materialCount = cacheMaterials.size();
+	header.materialOffset = section(header.materialCount * sizeof(CacheMaterial));
+	header.dependencyCount = cacheDependencies.size();
+	header.dependencyOffset = section(header.dependencyCount * sizeof(CacheDependency));
+	header.stringSize = strings.size();
+	header.stringOffset = section(header.stringSize);
+
+	// write to a temporary file first, so that an interrupted write never leaves a truncated cache behind
+	const std::string temporaryFilename = cacheFilename + ".tmp";
+	std::ofstream os(temporaryFilename, std::ios::binary | std::ios::trunc);
+
+	if (!os.is_open())
+		return false;
+
+	auto writeSection = [&os](std::uint64_t offset, const void* data, std::uint64_t size)
+	{
+		static const char padding[sectionAlignment] = {};
+		os.write(padding, std::streamsize(offset - std::uint64_t(os.tellp())));
+		os.write(static_cast<const char*>(data), std::streamsize(size));
+	};
+
+	os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	writeSection(header.vertexOffset, model.vertices().data(), header.vertexCount * sizeof(Vertex));
+	writeSection(header.indexOffset, model.indices().data(), header.indexCount * sizeof(glm::uint));
+	writeSection(header.groupOffset, cacheGroups.data(), header.groupCount * sizeof(CacheGroup));
+	writeSection(header.lodOffset, cacheLods.data(), header.lodCount * sizeof(CacheLod));
+	writeSection(header.clusterOffset, cacheClusters.data(), header.clusterCount * sizeof(CacheCluster));
+	writeSection(header.materialOffset, cacheMaterials.data(), header.materialCount * sizeof(CacheMaterial));
+	writeSection(header.dependencyOffset, cacheDependencies.data(), header.dependencyCount * sizeof(CacheDependency));
+	writeSection(header.stringOffset, strings.data(), header.stringSize);
+	os.close();
+
+	std::error_code error;
+
+	if (!os.good())
+	{
+		std::filesystem::remove(temporaryFilename, error);
+		return false;
+	}
+
+	std::filesystem::rename(temporaryFilename, cacheFilename, error);
+
+	if (error)
+	{
+		std::filesystem::remove(temporaryFilename, error);
+		return false;
+	}
+
+	return true;
+}
+
+std::string MeshCache::string(std::uint32_t offset, std::uint32_t length) const
+{
+	if (std::uint64_t(offset) + length > m_header->stringSize)
+		return std::string();
+
+	return std::string(m_file.data() + m_header->stringOffset + offset, length);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Model.h"
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace minity
+{
+	// Binary cache of a loaded mesh, stored next to its source file (e.g., bunny.obj.mcache).
+	// The vertex and index arrays are stored in their final layout, so that they can be uploaded directly from the memory-mapped file.
+	class MeshCache
+	{
+	public:
+		static const std::uint32_t version = 8;
+
+		static std::string cacheFilename(const std::string& filename);
+
+		// opens the cache and checks whether it was written with the same key and all source files are unchanged
+		bool open(const std::string& cacheFilename, std::uint64_t key);
+		void close();
+
+		const Vertex* vertices() const;
+		std::size_t vertexCount() const;
+
+		const glm::uint* indices() const;
+		std::size_t indexCount() const;
+
+		std::vector<Group> groups() const;
+		std::vector<Cluster> clusters() const;
+		std::vector<Material> materials() const;
+
+		glm::vec3 minimumBounds() const;
+		glm::vec3 maximumBounds() const;
+
+		// the first dependency is the source file itself, the others are files that affect the result (e.g., material libraries),
+		// which may also be missing
+		static bool write(const std::string& cacheFilename, std::uint64_t key, const std::vector<std::string>& dependencies, const Model& model);
+
+	private:
+		struct Header;
+
+		std::string string(std::uint32_t offset, std::uint32_t length) const;
+
+		// checks that all indices refer to vertices, and that the ranges of groups, levels of detail and clusters are within
+		// the index array and refer to existing entries
+		bool contentsValid() const;
+
+		MappedFile m_file;
+		const Header* m_header = nullptr;
+	};
+
+}
@@ -0,0 +1,376 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <unordered_map>
+
+using namespace minity;
+using namespace glm;
+
+namespace
+{
+	const uint unassigned = 0xffffffffu;
+
+	// soft cluster boundaries may make the ACMR of a cluster this much worse, larger values reduce overdraw further
+	const double overdrawThreshold = 1.05;
+
+	// the cache of the Forsyth scores, which model a least recently used cache rather than the FIFO of the ACMR
+	const std::size_t forsythCacheSize = 32;
+
+	float vertexScore(int cachePosition, int liveTriangles)
+	{
+		if (liveTriangles <= 0)
+			return -1.0f;
+
+		float score = 0.0f;
+
+		// the vertices of the last triangle get a fixed score, so that the next one does not simply reuse its edge
+		if (cachePosition >= 0 && cachePosition < 3)
+			score = 0.75f;
+		else if (cachePosition >= 3)
+			score = std::pow(1.0f - float(cachePosition - 3) / float(forsythCacheSize - 3), 1.5f);
+
+		// vertices with few triangles left are finished first, so that they do not leave lone triangles behind
+		return score + 2.0f / std::sqrt(float(liveTriangles));
+	}
+
+	// FIFO post-transform cache, as simulated by the ACMR
+	class VertexCache
+	{
+	public:
+		VertexCache()
+		{
+			m_entries.fill(unassigned);
+		}
+
+		// returns whether the vertex was missing
+		bool access(uint vertex)
+		{
+			if (std::find(m_entries.begin(), m_entries.end(), vertex) != m_entries.end())
+				return false;
+
+			m_entries[m_head] = vertex;
+			m_head = (m_head + 1) % m_entries.size();
+			return true;
+		}
+
+	private:
+		std::array<uint, MeshOptimizer::cacheSize> m_entries;
+		std::size_t m_head = 0;
+	};
+}
+
+std::size_t MeshOptimizer::cacheMisses(const uint* indices, std::size_t indexCount)
+{
+	VertexCache cache;
+	std::size_t misses = 0;
+
+	for (std::size_t i = 0; i < indexCount; i++)
+		misses += cache.access(indices[i]) ? 1 : 0;
+
+	return misses;
+}
+
+double MeshOptimizer::acmr(const std::vector<Group>& groups, const std::vector<uint>& indices)
+{
+	std::size_t misses = 0;
+	std::size_t triangleCount = 0;
+
+	for (const Group& group : groups)
+	{
+		// the end index is exclusive
+		const std::size_t triangleIndexCount = (group.endIndex - group.startIndex) / 3 * 3;
+		misses += cacheMisses(indices.data() + group.startIndex, triangleIndexCount);
+		triangleCount += triangleIndexCount / 3;
+	}
+
+	return triangleCount > 0 ? double(misses) / double(triangleCount) : 0.0;
+}
+
+void MeshOptimizer::optimize(const std::vector<Group>& groups, std::vector<uint>& indices, std::vector<Vertex>& vertices, bool reduceOverdraw, ThreadPool& pool)
+{
+	pool.parallelFor(groups.size(), [&](std::size_t g)
+	{
+		optimizeTriangles(indices.data() + groups[g].startIndex, groups[g].endIndex - groups[g].startIndex, vertices, reduceOverdraw);
+	});
+
+	optimizeVertexFetch(indices, vertices);
+}
+
+void MeshOptimizer::optimizeTriangles(uint* indices, std::size_t indexCount, const std::vector<Vertex>& vertices, bool reduceOverdraw)
+{
+	const std::size_t triangleCount = indexCount / 3;
+
+	if (triangleCount < 2)
+		return;
+
+	// local vertex numbers in order of first use, which keep the arrays below as small as the group
+	std::unordered_map<uint, uint> localVertices;
+	std::vector<uint> corners(triangleCount * 3);
+
+	for (std::size_t c = 0; c < corners.size(); c++)
+		corners[c] = localVertices.emplace(indices[c], uint(localVertices.size())).first->second;
+
+	const std::size_t vertexCount = localVertices.size();
+
+	// triangles adjacent to each vertex, as a compressed sparse row table -- the ones not emitted yet are kept at the front
+	std::vector<uint> offsets(vertexCount + 1, 0);
+
+	for (uint v : corners)
+		offsets[v + 1]++;
+
+	std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+	std::vector<uint> adjacency(corners.size());
+	std::vector<uint> cursors(offsets.begin(), offsets.end() - 1);
+
+	for (std::size_t c = 0; c < corners.size(); c++)
+		adjacency[cursors[corners[c]]++] = uint(c / 3);
+
+	std::vector<int> liveTriangles(vertexCount);
+
+	for (std::size_t v = 0; v < vertexCount; v++)
+		liveTriangles[v] = int(offsets[v + 1] - offsets[v]);
+
+	// Forsyth: always emit the triangle with the highest sum of vertex scores, which favor vertices recently
+	// used and vertices with few remaining triangles -- only the triangles around the cache are considered
+	std::vector<int> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	std::vector<float> triangleScores(triangleCount, 0.0f);
+	std::vector<unsigned char> emitted(triangleCount, 0);
+
+	for (std::size_t v = 0; v < vertexCount; v++)
+	{
+		vertexScores[v] = vertexScore(-1, liveTriangles[v]);
+
+		for (uint a = offsets[v]; a < offsets[v + 1]; a++)
+			triangleScores[adjacency[a]] += vertexScores[v];
+	}
+
+	std::array<uint, forsythCacheSize + 3> cache;
+	std::array<uint, forsythCacheSize + 3> newCache;
+	std::size_t cacheCount = 0;
+	std::vector<uint> ordered;
+	ordered.reserve(triangleCount * 3);
+
+	std::size_t cursor = 0;
+	int next = -1;
+
+	for (std::size_t n = 0; n < triangleCount; n++)
+	{
+		// without a triangle around the cache, continue with the first one left in the input order
+		if (next < 0)
+		{
+			while (emitted[cursor])
+				cursor++;
+
+			next = int(cursor);
+		}
+
+		const uint t = uint(next);
+		std::size_t newCount = 0;
+		emitted[t] = 1;
+
+		for (int c = 0; c < 3; c++)
+		{
+			const uint v = corners[t * 3 + c];
+			ordered.push_back(indices[t * 3 + c]);
+
+			for (uint a = offsets[v]; a < offsets[v] + uint(liveTriangles[v]); a++)
+			{
+				if (adjacency[a] == t)
+				{
+					std::swap(adjacency[a], adjacency[offsets[v] + liveTriangles[v] - 1]);
+					break;
+				}
+			}
+
+			liveTriangles[v]--;
+
+			if (std::find(newCache.begin(), newCache.begin() + newCount, v) == newCache.begin() + newCount)
+				newCache[newCount++] = v;
+		}
+
+		// the vertices of the triangle move to the front of the cache, the last ones drop out
+		const std::size_t triangleVertexCount = newCount;
+
+		for (std::size_t i = 0; i < cacheCount; i++)
+		{
+			if (std::find(newCache.begin(), newCache.begin() + triangleVertexCount, cache[i]) == newCache.begin() + triangleVertexCount)
+				newCache[newCount++] = cache[i];
+		}
+
+		for (std::size_t i = 0; i < newCount; i++)
+			cachePositions[newCache[i]] = i < forsythCacheSize ? int(i) : -1;
+
+		for (std::size_t i = 0; i < newCount; i++)
+		{
+			const uint v = newCache[i];
+			const float score = vertexScore(cachePositions[v], liveTriangles[v]);
+			const float difference = score - vertexScores[v];
+			vertexScores[v] = score;
+
+			for (uint a = offsets[v]; a < offsets[v] + uint(liveTriangles[v]); a++)
+				triangleScores[adjacency[a]] += difference;
+		}
+
+		cacheCount = std::min(newCount, forsythCacheSize);
+		std::copy(newCache.begin(), newCache.begin() + cacheCount, cache.begin());
+
+		next = -1;
+		float nextScore = -1.0f;
+
+		for (std::size_t i = 0; i < cacheCount; i++)
+		{
+			const uint v = cache[i];
+
+			for (uint a = offsets[v]; a < offsets[v] + uint(liveTriangles[v]); a++)
+			{
+				if (triangleScores[adjacency[a]] > nextScore)
+				{
+					nextScore = triangleScores[adjacency[a]];
+					next = int(adjacency[a]);
+				}
+			}
+		}
+	}
+
+	if (!reduceOverdraw)
+	{
+		std::copy(ordered.begin(), ordered.end(), indices);
+		return;
+	}
+
+	// hard boundaries are where the cache order starts over, as a triangle misses all its vertices
+	std::vector<std::size_t> boundaries(1, 0);
+	VertexCache boundaryCache;
+
+	for (std::size_t t = 0; t < triangleCount; t++)
+	{
+		std::size_t misses = 0;
+
+		for (int c = 0; c < 3; c++)
+			misses += boundaryCache.access(ordered[t * 3 + c]) ? 1 : 0;
+
+		if (misses == 3 && t > 0)
+			boundaries.push_back(t);
+	}
+
+	boundaries.push_back(triangleCount);
+
+	// soft boundaries split the clusters further wherever the ACMR so far is close to that of the whole cluster
+	std::vector<std::size_t> clusters;
+
+	for (std::size_t b = 0; b + 1 < boundaries.size(); b++)
+	{
+		const std::size_t begin = boundaries[b];
+		const std::size_t end = boundaries[b + 1];
+
+		const double clusterAcmr = double(cacheMisses(ordered.data() + begin * 3, (end - begin) * 3)) / double(end - begin);
+
+		VertexCache cache;
+		std::size_t misses = 0;
+		std::size_t clusterBegin = begin;
+
+		clusters.push_back(begin);
+
+		for (std::size_t t = begin; t < end; t++)
+		{
+			for (int c = 0; c < 3; c++)
+				misses += cache.access(ordered[t * 3 + c]) ? 1 : 0;
+
+			if (t + 1 < end && double(misses) <= overdrawThreshold * clusterAcmr * double(t + 1 - clusterBegin))
+			{
+				clusters.push_back(t + 1);
+				clusterBegin = t + 1;
+				misses = 0;
+				cache = VertexCache();
+			}
+		}
+	}
+
+	clusters.push_back(triangleCount);
+
+	// clusters that face away from the center of the group are likely to occlude others, so they are drawn first
+	vec3 center(0.0f);
+	float area = 0.0f;
+	std::vector<vec3> clusterCenters(clusters.size() - 1, vec3(0.0f));
+	std::vector<vec3> clusterNormals(clusters.size() - 1, vec3(0.0f));
+
+	for (std::size_t c = 0; c + 1 < clusters.size(); c++)
+	{
+		float clusterArea = 0.0f;
+
+		for (std::size_t t = clusters[c]; t < clusters[c + 1]; t++)
+		{
+			const vec3& p0 = vertices[ordered[t * 3 + 0]].position;
+			const vec3& p1 = vertices[ordered[t * 3 + 1]].position;
+			const vec3& p2 = vertices[ordered[t * 3 + 2]].position;
+			const vec3 normal = cross(p1 - p0, p2 - p0);
+			const float triangleArea = length(normal);
+
+			clusterCenters[c] += (p0 + p1 + p2) * (triangleArea / 3.0f);
+			clusterNormals[c] += normal;
+			clusterArea += triangleArea;
+		}
+
+		center += clusterCenters[c];
+		area += clusterArea;
+
+		if (clusterArea > 0.0f)
+			clusterCenters[c] /= clusterArea;
+	}
+
+	if (area > 0.0f)
+		center /= area;
+
+	std::vector<float> occlusionPotentials(clusters.size() - 1, 0.0f);
+
+	for (std::size_t c = 0; c + 1 < clusters.size(); c++)
+	{
+		if (clusterNormals[c] != vec3(0.0f))
+			occlusionPotentials[c] = dot(clusterCenters[c] - center, normalize(clusterNormals[c]));
+	}
+
+	std::vector<uint> clusterOrder(clusters.size() - 1);
+	std::iota(clusterOrder.begin(), clusterOrder.end(), 0);
+
+	std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&](uint a, uint b)
+	{
+		return occlusionPotentials[a] > occlusionPotentials[b];
+	});
+
+	uint* output = indices;
+
+	for (uint c : clusterOrder)
+		output = std::copy(ordered.begin() + clusters[c] * 3, ordered.begin() + clusters[c + 1] * 3, output);
+}
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<uint>& indices, std::vector<Vertex>& vertices)
+{
+	std::vector<uint> remap(vertices.size(), unassigned);
+	uint next = 0;
+
+	for (uint& i : indices)
+	{
+		if (remap[i] == unassigned)
+			remap[i] = next++;
+
+		i = remap[i];
+	}
+
+	for (uint& r : remap)
+	{
+		if (r == unassigned)
+			r = next++;
+	}
+
+	std::vector<Vertex> reordered(vertices.size());
+
+	for (std::size_t v = 0; v < vertices.size(); v++)
+		reordered[remap[v]] = vertices[v];
+
+	vertices.swap(reordered);
+}
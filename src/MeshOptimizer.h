@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Model.h"
+#include "ThreadPool.h"
+
+#include <vector>
+
+namespace minity
+{
+	// Reorders the index buffer of a mesh for the post-transform vertex cache and optionally to reduce overdraw, and
+	// the vertices in the order the triangles use them. Triangles only move within their group, so the index ranges of
+	// the groups stay valid.
+	class MeshOptimizer
+	{
+	public:
+		// size of the simulated FIFO cache, small enough to be a lower bound for current hardware
+		static const glm::uint cacheSize = 16;
+
+		// average number of cache misses per triangle (ACMR), with an empty cache at the start of each group as they
+		// are drawn separately -- 3 is the worst case and 0.5 is the limit for large regular meshes
+		static double acmr(const std::vector<Group>& groups, const std::vector<glm::uint>& indices);
+
+		static void optimize(const std::vector<Group>& groups, std::vector<glm::uint>& indices, std::vector<Vertex>& vertices, bool reduceOverdraw, ThreadPool& pool);
+
+		// reorders the triangles of one group for the vertex cache (Forsyth, "Linear-Speed Vertex Cache Optimisation",
+		// 2006) -- for reduced overdraw, the result is split into clusters at places where the cache can be flushed
+		// without much loss, which are then sorted so that outward facing ones are drawn first (Sander et al., "Fast
+		// Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007)
+		static void optimizeTriangles(glm::uint* indices, std::size_t indexCount, const std::vector<Vertex>& vertices, bool reduceOverdraw);
+
+		// renumbers the vertices in order of first use, so that they are fetched mostly sequentially -- unused vertices are kept at the end
+		static void optimizeVertexFetch(std::vector<glm::uint>& indices, std::vector<Vertex>& vertices);
+
+	private:
+		static std::size_t cacheMisses(const glm::uint* indices, std::size_t indexCount);
+	};
+
+}
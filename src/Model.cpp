@@ -1,4 +1,18 @@
 #include "Model.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include "MeshCache.h"
+#include "MemoryUsage.h"
+#include "VertexWelder.h"
+#include "NormalGenerator.h"
+#include "TangentGenerator.h"
+#include "VertexQuantizer.h"
+#include "MeshOptimizer.h"
+#include "LodGenerator.h"
+#include "ClusterBuilder.h"
+#include "IndexPacker.h"
+#include "StripBuilder.h"
+#include "TemporaryFile.h"
 
 #include <list>
 #include <fstream>
@@ -14,12 +28,13 @@
 #include <cctype>
 #include <locale>
 #include <filesystem>
+#include <charconv>
+#include <cstring>
+#include <string_view>
+#include <chrono>
 #include <globjects/globjects.h>
 #include <globjects/logging.h>
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
-
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/string_cast.hpp>
 
@@ -51,39 +66,129 @@ std::string trim(const std::string &str, const std::string & whitespace = "\n\r\
 	return trimRight(trimLeft(str, whitespace), whitespace);
 }
 
-template<class e, class t, int N>
-std::basic_istream<e, t>& operator>>(std::basic_istream<e, t>& in, const e(&sliteral)[N])
+// the tokenizer below works directly on the (memory-mapped) file contents and mirrors the whitespace
+// handling of the standard stream operators, so that it produces exactly the same results as before
+
+inline bool isSpace(char c)
 {
-	std::array<e, N - 1> buffer; //get buffer
-	in >> buffer[0]; //skips whitespace
-	if (N > 2)
-		in.read(&buffer[1], N - 2); //read the rest
-	if (strncmp(&buffer[0], sliteral, N - 1)) //if it failed
-		in.setstate(in.rdstate() | std::ios::failbit); //set the state
-	return in;
+	return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f' || c == '\n';
 }
 
-template<class e, class t>
-std::basic_istream<e, t>& operator>>(std::basic_istream<e, t>& in, const e& cliteral)
+inline const char* skipSpace(const char* cursor, const char* end)
 {
-	e buffer;  //get buffer
-	in >> buffer; //read data
-	if (buffer != cliteral) //if it failed
-		in.setstate(in.rdstate() | std::ios::failbit); //set the state
-	return in;
+	while (cursor < end && isSpace(*cursor))
+		cursor++;
+
+	return cursor;
+}
+
+inline const char* skipToken(const char* cursor, const char* end)
+{
+	while (cursor < end && !isSpace(*cursor))
+		cursor++;
+
+	return cursor;
 }
 
-//redirect mutable char arrays to their normal function
-template<class e, class t, int N>
-std::basic_istream<e, t>& operator>>(std::basic_istream<e, t>& in, e(&carray)[N])
+inline bool parseFloat(const char*& cursor, const char* end, float& value)
 {
-	return std::operator>>(in, carray);
+	const char* first = skipSpace(cursor, end);
+
+	// std::from_chars does not accept an explicit plus sign
+	if (first < end && *first == '+')
+		first++;
+
+	const std::from_chars_result result = std::from_chars(first, end, value);
+
+	if (result.ec != std::errc())
+		return false;
+
+	cursor = result.ptr;
+	return true;
+}
+
+inline bool parseInt(const char*& cursor, const char* end, int& value)
+{
+	const char* first = skipSpace(cursor, end);
+
+	if (first < end && *first == '+')
+		first++;
+
+	const std::from_chars_result result = std::from_chars(first, end, value);
+
+	if (result.ec != std::errc())
+		return false;
+
+	cursor = result.ptr;
+	return true;
+}
+
+// skips leading whitespace and then matches the literal characters exactly
+template <std::size_t N>
+inline bool parseLiteral(const char*& cursor, const char* end, const char(&literal)[N])
+{
+	const char* first = skipSpace(cursor, end);
+
+	if (std::size_t(end - first) < N - 1 || strncmp(first, literal, N - 1) != 0)
+		return false;
+
+	cursor = first + N - 1;
+	return true;
+}
+
+// options that change the loaded mesh must be part of the key, so that a cache written with other settings is not used
+std::uint64_t cacheKey(const LoadOptions& options)
+{
+	std::uint32_t weldEpsilon;
+	memcpy(&weldEpsilon, &options.weldEpsilon, sizeof(weldEpsilon));
+
+	const std::uint64_t meshOptimization = options.optimizeVertexCache ? (options.reduceOverdraw ? 2 : 1) : 0;
+
+	return std::uint64_t(weldEpsilon) | std::uint64_t(options.normalWeighting) << 32 | meshOptimization << 40 | std::uint64_t(options.generateLods) << 42 | std::uint64_t(options.buildClusters) << 43 | std::uint64_t(options.shortIndices) << 44;
+}
+
+void requestTextures(const Material & material, TextureLoader & textureLoader, const LoadOptions & options)
+{
+	for (auto path : { &material.ambientTexturePath, &material.diffuseTexturePath, &material.specularTexturePath, &material.shininessTexturePath, &material.bumpTexturePath, &material.normalTexturePath, &material.tangentTexturePath })
+	{
+		if (!path->empty())
+			textureLoader.request(*path, options.useCache, options.compressTextures);
+	}
+}
+
+// assigns the textures that have been uploaded since the last call
+void assignTextures(Material & material, const TextureLoader & textureLoader)
+{
+	if (!material.ambientTexture && !material.ambientTexturePath.empty())
+		material.ambientTexture = textureLoader.texture(material.ambientTexturePath);
+
+	if (!material.diffuseTexture && !material.diffuseTexturePath.empty())
+		material.diffuseTexture = textureLoader.texture(material.diffuseTexturePath);
+
+	if (!material.specularTexture && !material.specularTexturePath.empty())
+		material.specularTexture = textureLoader.texture(material.specularTexturePath);
+
+	if (!material.shininessTexture && !material.shininessTexturePath.empty())
+		material.shininessTexture = textureLoader.texture(material.shininessTexturePath);
+
+	if (!material.bumpTexture && !material.bumpTexturePath.empty())
+		material.bumpTexture = textureLoader.texture(material.bumpTexturePath);
+
+	if (!material.normalTexture && !material.normalTexturePath.empty())
+		material.normalTexture = textureLoader.texture(material.normalTexturePath);
+
+	if (!material.tangentTexture && !material.tangentTexturePath.empty())
+		material.tangentTexture = textureLoader.texture(material.tangentTexturePath);
 }
 
 class ObjLoader
 {
 public:
 
+	ObjLoader(LoadReport* report = nullptr) : m_report(report)
+	{
+	}
+
 	struct ObjGroup
 	{
 		std::string name;
@@ -91,6 +196,9 @@ public:
 		std::vector<uint> positionIndices;
 		std::vector<uint> normalIndices;
 		std::vector<uint> texCoordIndices;
+
+		// offset and number of the group's triangle corners in the temporary corner file (streaming mode only)
+		std::vector< std::pair<std::uint64_t, std::uint64_t> > cornerRuns;
 	};
 
 	struct ObjMaterial
@@ -127,13 +235,103 @@ public:
 		std::string map_tangent;
 	};
 
-	bool loadObjFile(const std::string & filename)
+	struct ObjRecord
+	{
+		enum class Type { Group, Material, Library, Faces };
+
+		Type type = Type::Faces;
+		std::string name;
+		std::vector<uint> positionIndices;
+		std::vector<uint> normalIndices;
+		std::vector<uint> texCoordIndices;
+
+		// location of the faces in the temporary corner file, after they have been written there in streaming mode
+		std::uint64_t cornerOffset = 0;
+		std::uint64_t cornerCount = 0;
+	};
+
+	// line-aligned range of the file that can be parsed independently of all others
+	struct ObjChunk
+	{
+		const char* begin = nullptr;
+		const char* end = nullptr;
+
+		// number of positions, normals and texture coordinates (including the placeholders) preceding the chunk
+		std::size_t positionBase = 1;
+		std::size_t normalBase = 1;
+		std::size_t texCoordBase = 1;
+
+		std::vector< vec3 > positions;
+		std::vector< vec3 > normals;
+		std::vector< vec2 > texCoords;
+
+		// vertex lines that could not be parsed, as they do not count towards relative indices
+		std::vector<const char*> skippedLines;
+
+		// group, material and library statements as well as faces in file order
+		std::vector<ObjRecord> records;
+	};
+
+	struct ObjCorner
+	{
+		uint position;
+		uint texCoord;
+		uint normal;
+	};
+
+	// intermediate data of the streaming mode, which is kept in temporary files instead of memory
+	struct ObjSpill
+	{
+		ObjSpill(const std::string & directory) : positions(directory), normals(directory), texCoords(directory), corners(directory)
+		{
+		}
+
+		bool good() const
+		{
+			return positions.good() && normals.good() && texCoords.good() && corners.good();
+		}
+
+		TemporaryFile positions;
+		TemporaryFile normals;
+		TemporaryFile texCoords;
+
+		// triangle corners in file order
+		TemporaryFile corners;
+
+		// including the placeholders
+		std::size_t positionCount = 0;
+		std::size_t normalCount = 0;
+		std::size_t texCoordCount = 0;
+		std::uint64_t cornerCount = 0;
+	};
+
+	// corner of a triangle, sorted into a partition by its position index for welding in streaming mode
+	struct PartitionCorner
+	{
+		// location in the final index buffer
+		uint index;
+		uint position;
+		// normal index, or the index of the group plus one if normals are generated (0 for corners without a normal)
+		uint normal;
+		uint texCoord;
+		// weighted normal of the triangle, if normals are generated
+		vec3 faceNormal;
+	};
+
+	bool loadObjFile(const std::string & filename, const LoadOptions & options, ThreadPool & pool)
 	{
 		std::filesystem::path path(filename);
-		std::ifstream is(filename);
+		MappedFile file;
 
-		if (!is.is_open())
-			return false;
+		{
+			LoadReport::Timer timer(m_report, LoadReport::Phase::FileIO);
+
+			if (!file.open(filename))
+				return false;
+		}
+
+		if (m_report)
+			m_report->addBytesRead(file.size());
 
 		std::vector< vec3 > positions;
 		std::vector< vec3 > normals;
@@ -167,380 +365,219 @@ public:
 		groupIterator--;
 		groupMap[defaultGroup.name] = groupIterator;
 
-		std::string buffer;
-
-		while (is.good())
-		{
-			if (getline(is, buffer))
-			{
-				std::istringstream iss(buffer);
-				std::string token;
-
-				if (iss >> token)
-				{
-					switch (token.at(0))
-					{
-						// v, vn, vt
-					case 'v':
-					{
-						if (token == "v")
-						{
-							vec3 p(0.0f);
-
-							if (iss >> p.x >> p.y >> p.z)
-								positions.push_back(p);
-						}
-						else if (token == "vn")
-						{
-							vec3 n(0.0f);
-
-							if (iss >> n.x >> n.y >> n.z)
-								normals.push_back(n);
-						}
-						else if (token == "vt")
-						{
-							vec2 t(0.0f);
-
-							if (iss >> t.x >> t.y)
-								texCoords.push_back(t);
-						}
-					}
-					break;
-
-					// mtllib
-					case 'm':
-					{
-						// the Wavefront obj specification does not really allow for spaces in the mtl file name,
-						// since multiple libraries are supposed to be separated by spaces, but many programs
-						// do not take care of that -- therefore, we first try whether it is a single filename,
-						// and only if that fails we use the interpretation according to the specification
-						std::string libraryName;
-
-						if (getline(iss, libraryName))
-						{
-							libraryName = trim(libraryName);
-							std::filesystem::path libraryPath = libraryName;
-
-							// first try
-							if (libraryPath.is_absolute())
-							{
-								if (loadMtlFile(libraryPath.string(), materials, materialMap))
-									break;
-							}
-
-							std::stringstream mss(libraryName);
-
-							while (mss >> libraryName)
-							{
-								libraryName = trim(libraryName);
-								std::filesystem::path libraryPath = path.parent_path();
-								libraryPath.append(libraryName);
-								loadMtlFile(libraryPath.string(), materials, materialMap);
-							}
-						}
-					}
-					break;
-
-					// use material
-					case 'u':
-					{
-						std::string materialName;
-
-						if (getline(iss, materialName))
-						{
-							materialName = trim(materialName);
-							currentMaterial = materialName;
-							groupIterator->material = currentMaterial;
-						}
-					}
-					break;
-
-					// group
-					case 'g':
-					case 'o':
-					{
-						std::string groupName;
-						
-						if (getline(iss,groupName))
-						{
-							groupName = trim(groupName);
-							std::unordered_map< std::string, typename std::list<ObjGroup>::iterator >::iterator j = groupMap.find(groupName);
-
-							if (j == groupMap.end())
-							{
-								ObjGroup newGroup;
-								newGroup.name = groupName;
-								
-								groupList.push_back(newGroup);
-								groupIterator = groupList.end();
-								groupIterator--;
-							}
-							else
-								groupIterator = j->second;
-
-							groupIterator->material = currentMaterial;
-						}
-					}
-					break;
-
-					// face
-					case 'f':
-					{
-						int v = 0, n = 0, t = 0;
-
-						if (buffer.find("//") != std::string::npos)
-						{
-							// v//n
-							if (iss >> v >> ("//") >> n)
-							{
-								groupIterator->positionIndices.push_back(v < 0 ? (uint) (v + positions.size()) : (uint) (v));
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(n < 0 ? (uint) (n + normals.size()) : (uint) (n));
-							}
-
-							if (iss >> v >> ("//") >> n)
-							{
-								groupIterator->positionIndices.push_back(v < 0 ? (uint) (v + positions.size()) : (uint) (v));
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(n < 0 ? (uint) (n + normals.size()) : (uint) (n));
-							}
-
-							if (iss >> v >> ("//") >> n)
-							{
-								groupIterator->positionIndices.push_back(v < 0 ? (uint) (v + positions.size()) : (uint) (v));
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(n < 0 ? (uint) (n + normals.size()) : (uint) (n));
-							}
-
-							while (iss >> v >> ("//") >> n)
-							{
-								groupIterator->positionIndices.push_back(groupIterator->positionIndices[groupIterator->positionIndices.size() - 3]);
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(groupIterator->normalIndices[groupIterator->normalIndices.size() - 3]);
+		const unsigned int threadCount = pool.size();
+		const bool streaming = options.memoryBudget > 0;
+		std::vector<ObjChunk> chunks;
+		std::unique_ptr<ObjSpill> spill;
 
-								groupIterator->positionIndices.push_back(groupIterator->positionIndices[groupIterator->positionIndices.size() - 2]);
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(groupIterator->normalIndices[groupIterator->normalIndices.size() - 2]);
+		// small files are not worth the overhead of a second pass, and in streaming mode,
+		// blocks of an eighth of the budget are parsed one after another
+		const std::size_t minimumChunkSize = std::size_t(1) << 20;
+		std::size_t chunkCount = 1;
 
-								groupIterator->positionIndices.push_back(v < 0 ? (uint) (v + positions.size()) : (uint) (v));
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(n < 0 ? (uint) (n + normals.size()) : (uint) (n));
-							}
+		if (streaming)
+			chunkCount = std::max(std::size_t(1), file.size() / std::max(minimumChunkSize, options.memoryBudget / 8));
+		else if (threadCount > 1)
+			chunkCount = std::max(std::size_t(1), std::min(std::size_t(threadCount) * 4, file.size() / minimumChunkSize));
 
-							break;
-						}
+		chunks = splitObjFile(file, chunkCount);
 
-						iss = std::istringstream(buffer);
-						iss >> token;
+		if (streaming)
+		{
+			// attributes and faces are moved to temporary files next to the model
+			LoadReport::Timer timer(m_report, LoadReport::Phase::Tokenizing);
+			spill = std::make_unique<ObjSpill>(path.parent_path().string());
 
-						if (iss >> v >> ("/") >> t >> ("/") >> n)
-						{
-							// v/t/n
-							groupIterator->positionIndices.push_back(v < 0 ? (uint) (v + positions.size()) : (uint) (v));
-							groupIterator->texCoordIndices.push_back(t < 0 ? (uint) (t + texCoords.size()) : (uint) (t));
-							groupIterator->normalIndices.push_back(n < 0 ? (uint) (n + normals.size()) : (uint) (n));
+			if (!parseObjBlocks(chunks, *spill))
+			{
+				globjects::debug() << "Could not write temporary files to " << path.parent_path().string() << "!";
+				return false;
+			}
+		}
+		else if (chunks.size() > 1)
+		{
+			// first pass: vertex attributes
+			LoadReport::Timer tokenizingTimer(m_report, LoadReport::Phase::Tokenizing);
 
-							if (iss >> v >> ("/") >> t >> ("/") >> n)
-							{
-								groupIterator->positionIndices.push_back(v < 0 ? (uint) (v + positions.size()) : (uint) (v));
-								groupIterator->texCoordIndices.push_back(t < 0 ? (uint) (t + texCoords.size()) : (uint) (t));
-								groupIterator->normalIndices.push_back(n < 0 ? (uint) (n + normals.size()) : (uint) (n));
-							}
+			pool.parallelFor(chunks.size(), [&](std::size_t i)
+			{
+				parseObjChunk(chunks[i], true, false);
+			});
 
-							if (iss >> v >> ("/") >> t >> ("/") >> n)
-							{
-								groupIterator->positionIndices.push_back(v < 0 ? (uint) (v + positions.size()) : (uint) (v));
-								groupIterator->texCoordIndices.push_back(t < 0 ? (uint) (t + texCoords.size()) : (uint) (t));
-								groupIterator->normalIndices.push_back(n < 0 ? (uint) (n + normals.size()) : (uint) (n));
-							}
+			// the number of attributes preceding each chunk is needed to resolve relative indices
+			std::size_t positionCount = positions.size();
+			std::size_t normalCount = normals.size();
+			std::size_t texCoordCount = texCoords.size();
 
-							while (iss >> v >> ("/") >> t >> ("/") >> n)
-							{
-								groupIterator->positionIndices.push_back(groupIterator->positionIndices[groupIterator->positionIndices.size() - 3]);
-								groupIterator->texCoordIndices.push_back(groupIterator->texCoordIndices[groupIterator->texCoordIndices.size() - 3]);
-								groupIterator->normalIndices.push_back(groupIterator->normalIndices[groupIterator->normalIndices.size() - 3]);
+			for (auto & c : chunks)
+			{
+				c.positionBase = positionCount;
+				c.normalBase = normalCount;
+				c.texCoordBase = texCoordCount;
 
-								groupIterator->positionIndices.push_back(groupIterator->positionIndices[groupIterator->positionIndices.size() - 2]);
-								groupIterator->texCoordIndices.push_back(groupIterator->texCoordIndices[groupIterator->texCoordIndices.size() - 2]);
-								groupIterator->normalIndices.push_back(groupIterator->normalIndices[groupIterator->normalIndices.size() - 2]);
+				positionCount += c.positions.size();
+				normalCount += c.normals.size();
+				texCoordCount += c.texCoords.size();
+			}
 
-								groupIterator->positionIndices.push_back(v < 0 ? (uint) (v + positions.size()) : (uint) (v));
-								groupIterator->texCoordIndices.push_back(t < 0 ? (uint) (t + texCoords.size()) : (uint) (t));
-								groupIterator->normalIndices.push_back(n < 0 ? (uint) (n + normals.size()) : (uint) (n));
-							}
+			positions.resize(positionCount);
+			normals.resize(normalCount);
+			texCoords.resize(texCoordCount);
 
-							break;
-						}
+			tokenizingTimer.stop();
 
-						iss = std::istringstream(buffer);
-						iss >> token;
+			// second pass: faces and statements, while the attributes are moved to their final position
+			LoadReport::Timer triangulationTimer(m_report, LoadReport::Phase::Triangulation);
 
-						if (iss >> v >> ("/") >> t)
-						{
-							// v/t
-							groupIterator->positionIndices.push_back(v < 0 ? (uint) (v + positions.size()) : (uint) (v));
-							groupIterator->texCoordIndices.push_back(t < 0 ? (uint) (t + texCoords.size()) : (uint) (t));
-							groupIterator->normalIndices.push_back(0);
+			pool.parallelFor(chunks.size(), [&](std::size_t i)
+			{
+				ObjChunk & c = chunks[i];
 
-							if (iss >> v >> ("/") >> t)
-							{
-								groupIterator->positionIndices.push_back(v < 0 ? (uint) (v + positions.size()) : (uint) (v));
-								groupIterator->texCoordIndices.push_back(t < 0 ? (uint) (t + texCoords.size()) : (uint) (t));
-								groupIterator->normalIndices.push_back(0);
-							}
+				std::copy(c.positions.begin(), c.positions.end(), positions.begin() + c.positionBase);
+				std::copy(c.normals.begin(), c.normals.end(), normals.begin() + c.normalBase);
+				std::copy(c.texCoords.begin(), c.texCoords.end(), texCoords.begin() + c.texCoordBase);
 
-							if (iss >> v >> ("/") >> t)
-							{
-								groupIterator->positionIndices.push_back(v < 0 ? (uint) (v + positions.size()) : (uint) (v));
-								groupIterator->texCoordIndices.push_back(t < 0 ? (uint) (t + texCoords.size()) : (uint) (t));
-								groupIterator->normalIndices.push_back(0);
-							}
+				std::vector< vec3 >().swap(c.positions);
+				std::vector< vec3 >().swap(c.normals);
+				std::vector< vec2 >().swap(c.texCoords);
 
-							while (iss >> v >> ("/") >> t)
-							{
-								groupIterator->positionIndices.push_back(groupIterator->positionIndices[groupIterator->positionIndices.size() - 3]);
-								groupIterator->texCoordIndices.push_back(groupIterator->texCoordIndices[groupIterator->texCoordIndices.size() - 3]);
-								groupIterator->normalIndices.push_back(0);
-
-								groupIterator->positionIndices.push_back(groupIterator->positionIndices[groupIterator->positionIndices.size() - 2]);
-								groupIterator->texCoordIndices.push_back(groupIterator->texCoordIndices[groupIterator->texCoordIndices.size() - 2]);
-								groupIterator->normalIndices.push_back(0);
+				parseObjChunk(c, false, true);
+			});
+		}
+		else
+		{
+			// a single chunk is parsed in one pass directly into the attribute arrays
+			LoadReport::Timer timer(m_report, LoadReport::Phase::Tokenizing);
+			ObjChunk & c = chunks.front();
+			c.positions.swap(positions);
+			c.normals.swap(normals);
+			c.texCoords.swap(texCoords);
+
+			parseObjChunk(c, true, true);
+
+			c.positions.swap(positions);
+			c.normals.swap(normals);
+			c.texCoords.swap(texCoords);
+		}
 
-								groupIterator->positionIndices.push_back(v < 0 ? (uint) (v + positions.size()) : (uint) (v));
-								groupIterator->texCoordIndices.push_back(t < 0 ? (uint) (t + texCoords.size()) : (uint) (t));
-								groupIterator->normalIndices.push_back(0);
-							}
+		// replay the statements in file order, so that the result is identical to parsing the file serially
+		for (auto & c : chunks)
+		{
+			for (auto & record : c.records)
+			{
+				switch (record.type)
+				{
+				case ObjRecord::Type::Library:
+				{
+					LoadReport::Timer timer(m_report, LoadReport::Phase::MaterialParsing);
+					loadMtlLibrary(path, record.name, materials, materialMap);
+				}
+				break;
 
-							break;
-						}
-						else
-						{
-							iss = std::istringstream(buffer);
-							iss >> token;
+				case ObjRecord::Type::Material:
+				{
+					currentMaterial = record.name;
+					groupIterator->material = currentMaterial;
+				}
+				break;
 
-							// v
-							if (iss >> v)
-							{
-								groupIterator->positionIndices.push_back(v < 0 ? (uint) (v + positions.size()) : (uint) (v));
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(0);
-							}
+				case ObjRecord::Type::Group:
+				{
+					std::unordered_map< std::string, typename std::list<ObjGroup>::iterator >::iterator j = groupMap.find(record.name);
 
-							if (iss >> v)
-							{
-								groupIterator->positionIndices.push_back(v < 0 ? (uint) (v + positions.size()) : (uint) (v));
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(0);
-							}
+					if (j == groupMap.end())
+					{
+						ObjGroup newGroup;
+						newGroup.name = record.name;
 
-							if (iss >> v)
-							{
-								groupIterator->positionIndices.push_back(v < 0 ? (uint) (v + positions.size()) : (uint) (v));
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(0);
-							}
+						groupList.push_back(newGroup);
+						groupIterator = groupList.end();
+						groupIterator--;
+					}
+					else
+						groupIterator = j->second;
 
-							while (iss >> v)
-							{
-								groupIterator->positionIndices.push_back(groupIterator->positionIndices[groupIterator->positionIndices.size() - 3]);
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(0);
+					groupIterator->material = currentMaterial;
+				}
+				break;
 
-								groupIterator->positionIndices.push_back(groupIterator->positionIndices[groupIterator->positionIndices.size() - 2]);
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(0);
+				case ObjRecord::Type::Faces:
+				{
+					if (record.cornerCount > 0)
+						groupIterator->cornerRuns.emplace_back(record.cornerOffset, record.cornerCount);
 
-								groupIterator->positionIndices.push_back(v < 0 ? (uint) (v + positions.size()) : (uint) (v));
-								groupIterator->texCoordIndices.push_back(0);
-								groupIterator->normalIndices.push_back(0);
-							}
-						}
-					}
-					break;
-					}
+					appendIndices(groupIterator->positionIndices, record.positionIndices);
+					appendIndices(groupIterator->texCoordIndices, record.texCoordIndices);
+					appendIndices(groupIterator->normalIndices, record.normalIndices);
+				}
+				break;
 				}
 			}
+
+			std::vector<ObjRecord>().swap(c.records);
 		}
 
 		if (materials.size() <= 1)
 		{
+			LoadReport::Timer timer(m_report, LoadReport::Phase::MaterialParsing);
 			std::filesystem::path libraryPath = path;
 			libraryPath.replace_extension("mtl");
 			loadMtlFile(libraryPath.string(), materials, materialMap);
 		}
 
-		// compute normals if not present in the file
-		if (normals.size() <= 1)
+		if (streaming)
 		{
-			// compute face normals
-			for (std::list<ObjGroup>::iterator i = groupList.begin(); i != groupList.end(); i++)
-			{
-				if (i->positionIndices.size() > 0)
-				{
-					for (uint j = 0; j < i->positionIndices.size() - 2; j += 3)
-					{
-						const vec3 & p0 = positions[i->positionIndices[j + 0]];
-						const vec3 & p1 = positions[i->positionIndices[j + 1]];
-						const vec3 & p2 = positions[i->positionIndices[j + 2]];
+			LoadReport::Timer timer(m_report, LoadReport::Phase::VertexWelding);
 
-						if (i->normalIndices[j + 0] == 0 || i->normalIndices[j + 1] == 0 || i->normalIndices[j + 2] == 0)
-						{
-							if (i->normalIndices[j + 0] == 0)
-								i->normalIndices[j + 0] = uint(normals.size());
+			if (!buildStreamingMesh(path, *spill, groupList, materialMap, options))
+				return false;
 
-							if (i->normalIndices[j + 1] == 0)
-								i->normalIndices[j + 1] = uint(normals.size());
+			convertMaterials(path, materials);
+			return true;
+		}
 
-							if (i->normalIndices[j + 2] == 0)
-								i->normalIndices[j + 2] = uint(normals.size());
+		// merge positions that are closer than the weld distance, so that they also share generated normals
+		if (options.weldEpsilon > 0.0f)
+		{
+			LoadReport::Timer timer(m_report, LoadReport::Phase::VertexWelding);
+			const std::vector<uint> positionMap = VertexWelder::weldPositions(positions, options.weldEpsilon);
 
-							const vec3 a(p2 - p1);
-							const vec3 b(p0 - p1);
-							const vec3 n = normalize(cross(a, b));
-							normals.push_back(n);
-						}
-					}
-				}
+			for (auto & g : groupList)
+			{
+				for (auto & p : g.positionIndices)
+					p = positionMap[p];
 			}
+		}
 
-			// compute vertex normals
-			std::vector< vec3 > vertexNormals(positions.size());
-			std::vector< vec3 > groupNormals(positions.size());
+		// compute normals if not present in the file
+		if (normals.size() <= 1)
+		{
+			LoadReport::Timer timer(m_report, LoadReport::Phase::NormalGeneration);
+			const auto startTime = std::chrono::steady_clock::now();
+			NormalGenerator generator(positions, options.normalWeighting, pool);
+			std::vector< vec3 > vertexNormals(1, vec3(0.0f));
 
-			for (std::list<ObjGroup>::iterator i = groupList.begin(); i != groupList.end(); i++)
+			for (auto & g : groupList)
 			{
-				if (i->positionIndices.size() > 0)
-				{
-					for (uint j = 0; j < i->positionIndices.size() - 2; j += 3)
-					{
-						groupNormals[i->positionIndices[j + 0]] = groupNormals[i->positionIndices[j + 0]] + normals[i->normalIndices[j + 0]];
-						groupNormals[i->positionIndices[j + 1]] = groupNormals[i->positionIndices[j + 1]] + normals[i->normalIndices[j + 1]];
-						groupNormals[i->positionIndices[j + 2]] = groupNormals[i->positionIndices[j + 2]] + normals[i->normalIndices[j + 2]];
-					}
-
-					for (uint j = 0; j < i->positionIndices.size() - 2; j += 3)
-					{
-						vertexNormals[i->positionIndices[j + 0]] = normalize(groupNormals[i->positionIndices[j + 0]]);
-						vertexNormals[i->positionIndices[j + 1]] = normalize(groupNormals[i->positionIndices[j + 1]]);
-						vertexNormals[i->positionIndices[j + 2]] = normalize(groupNormals[i->positionIndices[j + 2]]);
-					}
-
-					for (uint j = 0; j < i->positionIndices.size() - 2; j += 3)
-					{
-						groupNormals[i->positionIndices[j + 0]] = vec3(0.0f);
-						groupNormals[i->positionIndices[j + 1]] = vec3(0.0f);
-						groupNormals[i->positionIndices[j + 2]] = vec3(0.0f);
-					}
-
-					i->normalIndices = i->positionIndices;
-				}
+				if (g.positionIndices.size() > 0)
+					generator.generate(g.positionIndices, vertexNormals, g.normalIndices);
 			}
 
 			normals.swap(vertexNormals);
+
+			const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - startTime;
+			globjects::debug() << "Generated " << normals.size() - 1 << " normals in " << duration.count() << " ms";
 		}
 
-		m_vertices.resize(positions.size());
+		// every distinct (position, normal, texture coordinate) combination becomes one vertex, in order of first use
+		LoadReport::Timer weldingTimer(m_report, LoadReport::Phase::VertexWelding);
+		VertexWelder welder(positions.size());
+		std::size_t faceVertexCount = 0;
 
+		for (auto & g : groupList)
+			faceVertexCount += g.positionIndices.size();
+
+		m_indices.reserve(faceVertexCount);
 
 		for (std::list<ObjGroup>::iterator i = groupList.begin(); i != groupList.end(); i++)
 		{
@@ -563,37 +600,29 @@ public:
 					
 				for (uint j = 0; j < i->positionIndices.size(); j++)
 				{
-					const uint index = i->positionIndices[j];
+					const auto vertexIndex = welder.insert(i->positionIndices[j], i->normalIndices[j], i->texCoordIndices[j]);
 
-					Vertex vertex;
-					vertex.position = positions[index];
-					vertex.normal = normals[i->normalIndices[j]];
-					vertex.texcoord = texCoords[i->texCoordIndices[j]];
-
-					groupMinBounds = min(groupMinBounds, vertex.position);
-					groupMaxBounds = max(groupMaxBounds, vertex.position);					
-
-					if (m_vertices[index].position == vertex.position)
-					{
-						if (m_vertices[index].texcoord != vertex.texcoord || m_vertices[index].normal != vertex.normal)
-						{
-							m_indices.push_back(uint(m_vertices.size()));
-							m_vertices.push_back(vertex);
-						}
-						else
-						{
-							m_vertices[index] = vertex;
-							m_indices.push_back(index);
-						}
-					}
-					else
+					if (vertexIndex.second)
 					{
-						m_vertices[index] = vertex;
-						m_indices.push_back(index);
+						Vertex vertex;
+						vertex.position = positions[i->positionIndices[j]];
+						vertex.normal = normals[i->normalIndices[j]];
+						vertex.texcoord = texCoords[i->texCoordIndices[j]];
+						m_vertices.push_back(vertex);
 					}
+
+					const vec3 & position = m_vertices[vertexIndex.first].position;
+					groupMinBounds = min(groupMinBounds, position);
+					groupMaxBounds = max(groupMaxBounds, position);
+
+					m_indices.push_back(vertexIndex.first);
 				}
 
-				
+				// the face indices of the group are not needed anymore
+				std::vector<uint>().swap(i->positionIndices);
+				std::vector<uint>().swap(i->normalIndices);
+				std::vector<uint>().swap(i->texCoordIndices);
+
 				newGroup.maxBounds = groupMaxBounds;
 				newGroup.minBounds = groupMinBounds;
 				newGroup.centerMass = (groupMaxBounds + groupMinBounds) * 0.5f;
@@ -603,122 +632,589 @@ public:
 		
 		}
 
+		weldingTimer.stop();
 
+		globjects::debug() << "Welded " << faceVertexCount << " face vertices into " << m_vertices.size() << " unique vertices";
+
+		convertMaterials(path, materials);
+
+		return true;
+	}
 
+	void convertMaterials(const std::filesystem::path & path, const std::vector<ObjMaterial> & materials)
+	{
 		m_materials.reserve(materials.size());
-		
 
 		for (auto & m : materials)
 		{
 			Material newMaterial;
+			newMaterial.name = m.name;
 			newMaterial.ambient = m.Ka;
 			newMaterial.diffuse = m.Kd;
 			newMaterial.specular = m.Ks;
 			newMaterial.shininess = m.Ns;
 
-			if (!m.map_Ka.empty())
+			newMaterial.ambientTexturePath = texturePath(path, m.map_Ka);
+			newMaterial.diffuseTexturePath = texturePath(path, m.map_Kd);
+			newMaterial.specularTexturePath = texturePath(path, m.map_Ks);
+			newMaterial.shininessTexturePath = texturePath(path, m.map_Ns);
+			newMaterial.bumpTexturePath = texturePath(path, m.map_bump);
+			newMaterial.normalTexturePath = texturePath(path, m.map_normal);
+			newMaterial.tangentTexturePath = texturePath(path, m.map_tangent);
+
+			m_materials.push_back(newMaterial);
+		}
+	}
+
+	// parses the blocks one after another and writes their attributes and faces to the temporary files,
+	// so that only the group, material and library statements remain in memory
+	bool parseObjBlocks(std::vector<ObjChunk> & chunks, ObjSpill & spill)
+	{
+		// placeholders for faces without normals or texture coordinates, as in the in-memory mode
+		const vec3 position(0.0f);
+		const vec3 normal(0.0f);
+		const vec2 texCoord(1.0f);
+
+		spill.positions.write(&position, sizeof(position));
+		spill.normals.write(&normal, sizeof(normal));
+		spill.texCoords.write(&texCoord, sizeof(texCoord));
+		spill.positionCount = 1;
+		spill.normalCount = 1;
+		spill.texCoordCount = 1;
+
+		std::vector<ObjCorner> corners;
+
+		for (auto & c : chunks)
+		{
+			c.positionBase = spill.positionCount;
+			c.normalBase = spill.normalCount;
+			c.texCoordBase = spill.texCoordCount;
+
+			parseObjChunk(c, true, true);
+
+			spill.positions.write(c.positions);
+			spill.normals.write(c.normals);
+			spill.texCoords.write(c.texCoords);
+			spill.positionCount += c.positions.size();
+			spill.normalCount += c.normals.size();
+			spill.texCoordCount += c.texCoords.size();
+
+			std::vector< vec3 >().swap(c.positions);
+			std::vector< vec3 >().swap(c.normals);
+			std::vector< vec2 >().swap(c.texCoords);
+			std::vector<const char*>().swap(c.skippedLines);
+
+			for (auto & record : c.records)
+			{
+				if (record.type != ObjRecord::Type::Faces)
+					continue;
+
+				corners.resize(record.positionIndices.size());
+
+				for (std::size_t i = 0; i < corners.size(); i++)
+					corners[i] = ObjCorner{ record.positionIndices[i], record.texCoordIndices[i], record.normalIndices[i] };
+
+				record.cornerOffset = spill.cornerCount;
+				record.cornerCount = corners.size();
+				spill.corners.write(corners);
+				spill.cornerCount += corners.size();
+
+				std::vector<uint>().swap(record.positionIndices);
+				std::vector<uint>().swap(record.normalIndices);
+				std::vector<uint>().swap(record.texCoordIndices);
+			}
+
+			if (!spill.good())
+				return false;
+		}
+
+		return true;
+	}
+
+	// welds the corners in partitions of position indices, each of which is small enough to fit into the memory budget,
+	// and writes the final vertex and index arrays -- vertices are ordered by partition, but are otherwise identical to the in-memory mode
+	bool buildStreamingMesh(const std::filesystem::path & path, ObjSpill & spill, std::list<ObjGroup> & groupList, std::unordered_map<std::string, int> & materialMap, const LoadOptions & options)
+	{
+		if (!spill.positions.map(false) || !spill.normals.map(false) || !spill.texCoords.map(false) || !spill.corners.map(true))
+			return false;
+
+		const vec3* positions = reinterpret_cast<const vec3*>(spill.positions.data());
+		const vec3* normals = reinterpret_cast<const vec3*>(spill.normals.data());
+		const vec2* texCoords = reinterpret_cast<const vec2*>(spill.texCoords.data());
+		const ObjCorner* corners = reinterpret_cast<const ObjCorner*>(spill.corners.data());
+		const bool generateNormals = spill.normalCount <= 1;
+
+		if (options.weldEpsilon > 0.0f)
+			globjects::debug() << "Welding positions is not supported when streaming, the weld distance is ignored.";
+
+		// estimated working set per corner: the corner itself and the hash table slots for welding (and smoothing)
+		const std::uint64_t bytesPerCorner = sizeof(PartitionCorner) + (generateNormals ? 96 : 48);
+		const std::uint64_t maximumPartitionCount = 256;
+		const std::uint64_t partitionCount = std::min(maximumPartitionCount, std::max(std::uint64_t(1), (spill.cornerCount * bytesPerCorner + options.memoryBudget - 1) / options.memoryBudget));
+		const std::uint64_t partitionSize = (spill.positionCount + partitionCount - 1) / partitionCount;
+
+		if (spill.cornerCount * bytesPerCorner > partitionCount * options.memoryBudget)
+			globjects::debug() << "The memory budget is too small for this model and will be exceeded.";
+
+		std::vector< std::unique_ptr<TemporaryFile> > partitions;
+
+		for (std::uint64_t i = 0; i < partitionCount; i++)
+			partitions.push_back(std::make_unique<TemporaryFile>(path.parent_path().string()));
+
+		// distribute the corners to the partitions in the order of the final index buffer
+		auto validIndex = [](uint index, std::size_t count)
+		{
+			return index < count ? index : 0;
+		};
+
+		uint index = 0;
+		uint groupIndex = 0;
+
+		for (auto i = groupList.begin(); i != groupList.end(); i++, groupIndex++)
+		{
+			if (i->cornerRuns.empty())
+				continue;
+
+			Group newGroup;
+			newGroup.name = i->name;
+			newGroup.startIndex = index;
+
+			vec3 groupMinBounds = vec3(std::numeric_limits<float>::max());
+			vec3 groupMaxBounds = vec3(-std::numeric_limits<float>::max());
+
+			std::unordered_map<std::string, int>::iterator j = materialMap.find(i->material);
+
+			if (j != materialMap.end())
+				newGroup.materialIndex = j->second;
+			else
+				newGroup.materialIndex = 0;
+
+			// the corners of all runs form one triangle list, as in the in-memory mode
+			PartitionCorner triangle[3];
+			int triangleCorner = 0;
+
+			for (auto & run : i->cornerRuns)
 			{
-				std::filesystem::path texturePath = m.map_Ka;
+				for (std::uint64_t k = 0; k < run.second; k++)
+				{
+					const ObjCorner & corner = corners[run.first + k];
+					PartitionCorner & c = triangle[triangleCorner++];
+					c.index = index++;
+					c.position = validIndex(corner.position, spill.positionCount);
+					c.normal = generateNormals ? groupIndex + 1 : validIndex(corner.normal, spill.normalCount);
+					c.texCoord = validIndex(corner.texCoord, spill.texCoordCount);
+					c.faceNormal = vec3(0.0f);
+
+					groupMinBounds = min(groupMinBounds, positions[c.position]);
+					groupMaxBounds = max(groupMaxBounds, positions[c.position]);
+
+					if (triangleCorner < 3)
+						continue;
+
+					if (generateNormals)
+					{
+						const vec3 & p0 = positions[triangle[0].position];
+						const vec3 & p1 = positions[triangle[1].position];
+						const vec3 & p2 = positions[triangle[2].position];
+						const vec3 n = NormalGenerator::faceNormal(p0, p1, p2, options.normalWeighting);
+
+						if (options.normalWeighting == NormalWeighting::Angle)
+						{
+							triangle[0].faceNormal = n * NormalGenerator::cornerAngle(p0, p1, p2);
+							triangle[1].faceNormal = n * NormalGenerator::cornerAngle(p1, p2, p0);
+							triangle[2].faceNormal = n * NormalGenerator::cornerAngle(p2, p0, p1);
+						}
+						else
+						{
+							triangle[0].faceNormal = n;
+							triangle[1].faceNormal = n;
+							triangle[2].faceNormal = n;
+						}
+					}
 
-				if (!texturePath.is_absolute())
+					for (int t = 0; t < 3; t++)
+						partitions[triangle[t].position / partitionSize]->write(&triangle[t], sizeof(PartitionCorner));
+
+					triangleCorner = 0;
+				}
+			}
+
+			// corners of an incomplete triangle at the end of the group get no generated normal
+			for (int t = 0; t < triangleCorner; t++)
+			{
+				if (generateNormals)
+					triangle[t].normal = 0;
+
+				partitions[triangle[t].position / partitionSize]->write(&triangle[t], sizeof(PartitionCorner));
+			}
+
+			newGroup.maxBounds = groupMaxBounds;
+			newGroup.minBounds = groupMinBounds;
+			newGroup.centerMass = (groupMaxBounds + groupMinBounds) * 0.5f;
+			newGroup.endIndex = index;
+			m_groups.push_back(newGroup);
+		}
+
+		m_indices.resize(index);
+
+		std::uint64_t largestPartition = 0;
+
+		for (auto & partition : partitions)
+		{
+			if (!partition->map(true))
+				return false;
+
+			const PartitionCorner* partitionCorners = reinterpret_cast<const PartitionCorner*>(partition->data());
+			const std::size_t cornerCount = std::size_t(partition->size() / sizeof(PartitionCorner));
+			largestPartition = std::max(largestPartition, std::uint64_t(cornerCount));
+
+			// smooth normals are accumulated per position and group, in the same order as by the NormalGenerator
+			VertexWelder normalWelder(generateNormals ? cornerCount / 4 : 0);
+			std::vector<vec3> normalSums;
+
+			if (generateNormals)
+			{
+				for (std::size_t c = 0; c < cornerCount; c++)
+				{
+					if (partitionCorners[c].normal == 0)
+						continue;
+
+					const auto normalIndex = normalWelder.insert(partitionCorners[c].position, partitionCorners[c].normal, 0);
+
+					if (normalIndex.second)
+						normalSums.push_back(vec3(0.0f));
+
+					normalSums[normalIndex.first] += partitionCorners[c].faceNormal;
+				}
+
+				for (auto & n : normalSums)
+				{
+					if (n != vec3(0.0f))
+						n = normalize(n);
+				}
+			}
+
+			VertexWelder welder(cornerCount / 4);
+			const uint vertexBase = uint(m_vertices.size());
+
+			for (std::size_t c = 0; c < cornerCount; c++)
+			{
+				const PartitionCorner & corner = partitionCorners[c];
+				const auto vertexIndex = welder.insert(corner.position, corner.normal, corner.texCoord);
+
+				if (vertexIndex.second)
 				{
-					texturePath = path.parent_path();
-					texturePath.append(m.map_Ka);
+					Vertex vertex;
+					vertex.position = positions[corner.position];
+
+					if (!generateNormals)
+						vertex.normal = normals[corner.normal];
+					else if (corner.normal > 0)
+						vertex.normal = normalSums[normalWelder.insert(corner.position, corner.normal, 0).first];
+					else
+						vertex.normal = vec3(0.0f);
+
+					vertex.texcoord = texCoords[corner.texCoord];
+					m_vertices.push_back(vertex);
 				}
 
-				newMaterial.ambientTexture = std::move(loadTexture(texturePath.string()));
+				m_indices[corner.index] = vertexBase + vertexIndex.first;
+			}
+
+			// frees the disk space of the partition right away
+			partition.reset();
+		}
+
+		globjects::debug() << "Streamed " << index << " face vertices through " << partitionCount << " partitions (largest: " << largestPartition << ") into " << m_vertices.size() << " unique vertices";
+
+		return true;
+	}
+
+	std::vector<ObjChunk> splitObjFile(const MappedFile & file, std::size_t chunkCount)
+	{
+		std::vector<ObjChunk> chunks(chunkCount);
+		const char* begin = file.data();
+
+		for (std::size_t i = 0; i < chunkCount; i++)
+		{
+			const char* end = file.end();
+
+			if (i + 1 < chunkCount)
+			{
+				end = std::max(begin, file.data() + file.size() * (i + 1) / chunkCount);
+
+				const char* lineEnd = static_cast<const char*>(memchr(end, '\n', file.end() - end));
+				end = lineEnd ? lineEnd + 1 : file.end();
 			}
 
-			if (!m.map_Kd.empty())
+			chunks[i].begin = begin;
+			chunks[i].end = end;
+			begin = end;
+		}
+
+		return chunks;
+	}
+
+	// parses vertex attributes and/or faces and statements of a chunk; when the attributes are not parsed,
+	// the chunk's skipped lines from an earlier pass are needed to resolve relative indices
+	void parseObjChunk(ObjChunk & chunk, bool parseVertices, bool parseFaces)
+	{
+		std::size_t positionCount = chunk.positionBase;
+		std::size_t normalCount = chunk.normalBase;
+		std::size_t texCoordCount = chunk.texCoordBase;
+		std::size_t skippedIndex = 0;
+
+		const char* cursor = chunk.begin;
+
+		while (cursor < chunk.end)
+		{
+			const char* lineEnd = static_cast<const char*>(memchr(cursor, '\n', chunk.end - cursor));
+
+			if (!lineEnd)
+				lineEnd = chunk.end;
+
+			const char* lineStart = cursor;
+			cursor = lineEnd + (lineEnd < chunk.end ? 1 : 0);
+
+			const char* tokenStart = skipSpace(lineStart, lineEnd);
+			const char* tokenEnd = skipToken(tokenStart, lineEnd);
+
+			if (tokenStart == tokenEnd)
+				continue;
+
+			const std::string_view token(tokenStart, tokenEnd - tokenStart);
+			const char* lineCursor = tokenEnd;
+
+			// statements keep the remainder of the line after the keyword (equivalent to getline after extracting the token)
+			auto addStatement = [&](ObjRecord::Type type)
 			{
-				std::filesystem::path texturePath = m.map_Kd;
+				if (!parseFaces || tokenEnd == lineEnd)
+					return;
+
+				ObjRecord record;
+				record.type = type;
+				record.name = trim(std::string(tokenEnd, lineEnd - tokenEnd));
+				chunk.records.push_back(std::move(record));
+			};
 
-				if (!texturePath.is_absolute())
+			switch (token.front())
+			{
+				// v, vn, vt
+			case 'v':
+			{
+				if (token != "v" && token != "vn" && token != "vt")
+					break;
+
+				bool valid = false;
+
+				if (parseVertices)
+				{
+					if (token == "v")
+					{
+						vec3 p(0.0f);
+
+						if ((valid = parseFloat(lineCursor, lineEnd, p.x) && parseFloat(lineCursor, lineEnd, p.y) && parseFloat(lineCursor, lineEnd, p.z)))
+							chunk.positions.push_back(p);
+					}
+					else if (token == "vn")
+					{
+						vec3 n(0.0f);
+
+						if ((valid = parseFloat(lineCursor, lineEnd, n.x) && parseFloat(lineCursor, lineEnd, n.y) && parseFloat(lineCursor, lineEnd, n.z)))
+							chunk.normals.push_back(n);
+					}
+					else
+					{
+						vec2 t(0.0f);
+
+						if ((valid = parseFloat(lineCursor, lineEnd, t.x) && parseFloat(lineCursor, lineEnd, t.y)))
+							chunk.texCoords.push_back(t);
+					}
+
+					if (!valid)
+						chunk.skippedLines.push_back(lineStart);
+				}
+				else
 				{
-					texturePath = path.parent_path();
-					texturePath.append(m.map_Kd);
+					valid = skippedIndex >= chunk.skippedLines.size() || chunk.skippedLines[skippedIndex] != lineStart;
+
+					if (!valid)
+						skippedIndex++;
 				}
 
-				newMaterial.diffuseTexture = std::move(loadTexture(texturePath.string()));
-			}
+				if (valid)
+				{
+					if (token == "v")
+						positionCount++;
+					else if (token == "vn")
+						normalCount++;
+					else
+						texCoordCount++;
+				}
+			}
+			break;
+
+			// mtllib
+			case 'm':
+				addStatement(ObjRecord::Type::Library);
+				break;
+
+			// use material
+			case 'u':
+				addStatement(ObjRecord::Type::Material);
+				break;
+
+			// group
+			case 'g':
+			case 'o':
+				addStatement(ObjRecord::Type::Group);
+				break;
 
-			if (!m.map_Ks.empty())
+			// face
+			case 'f':
 			{
-				std::filesystem::path texturePath = m.map_Ks;
+				if (!parseFaces)
+					break;
+
+				if (chunk.records.empty() || chunk.records.back().type != ObjRecord::Type::Faces)
+					chunk.records.emplace_back();
 
-				if (!texturePath.is_absolute())
+				std::vector<uint>& positionIndices = chunk.records.back().positionIndices;
+				std::vector<uint>& texCoordIndices = chunk.records.back().texCoordIndices;
+				std::vector<uint>& normalIndices = chunk.records.back().normalIndices;
+
+				// the first three vertices form a triangle, every further vertex is triangulated as a fan
+				auto addVertex = [&](uint corner, int v, int t, int n)
 				{
-					texturePath = path.parent_path();
-					texturePath.append(m.map_Ks);
-				}
+					if (corner >= 3)
+					{
+						positionIndices.push_back(positionIndices[positionIndices.size() - 3]);
+						texCoordIndices.push_back(texCoordIndices[texCoordIndices.size() - 3]);
+						normalIndices.push_back(normalIndices[normalIndices.size() - 3]);
 
-				newMaterial.specularTexture = std::move(loadTexture(texturePath.string()));
-			}
+						positionIndices.push_back(positionIndices[positionIndices.size() - 2]);
+						texCoordIndices.push_back(texCoordIndices[texCoordIndices.size() - 2]);
+						normalIndices.push_back(normalIndices[normalIndices.size() - 2]);
+					}
 
-			if (!m.map_Ns.empty())
-			{
-				std::filesystem::path texturePath = m.map_Ns;
+					positionIndices.push_back(v < 0 ? (uint) (v + positionCount) : (uint) (v));
+					texCoordIndices.push_back(t < 0 ? (uint) (t + texCoordCount) : (uint) (t));
+					normalIndices.push_back(n < 0 ? (uint) (n + normalCount) : (uint) (n));
+				};
 
-				if (!texturePath.is_absolute())
+				int v = 0, n = 0, t = 0;
+				uint corner = 0;
+
+				if (std::string_view(lineStart, lineEnd - lineStart).find("//") != std::string_view::npos)
 				{
-					texturePath = path.parent_path();
-					texturePath.append(m.map_Ns);
+					// v//n
+					while (parseInt(lineCursor, lineEnd, v) && parseLiteral(lineCursor, lineEnd, "//") && parseInt(lineCursor, lineEnd, n))
+						addVertex(corner++, v, 0, n);
+
+					break;
 				}
 
-				newMaterial.shininessTexture = std::move(loadTexture(texturePath.string()));
-			}
+				const char* faceStart = lineCursor;
 
-			if (!m.map_bump.empty())
-			{
-				std::filesystem::path texturePath = m.map_bump;
+				// v/t/n
+				while (parseInt(lineCursor, lineEnd, v) && parseLiteral(lineCursor, lineEnd, "/") && parseInt(lineCursor, lineEnd, t) && parseLiteral(lineCursor, lineEnd, "/") && parseInt(lineCursor, lineEnd, n))
+					addVertex(corner++, v, t, n);
 
-				if (!texturePath.is_absolute())
-				{
-					texturePath = path.parent_path();
-					texturePath.append(m.map_bump);
-				}
+				if (corner > 0)
+					break;
 
-				newMaterial.bumpTexture = std::move(loadTexture(texturePath.string()));
-			}
+				// v/t
+				lineCursor = faceStart;
 
-			if (!m.map_normal.empty()) {
-				std::filesystem::path texturePath = m.map_normal;
+				while (parseInt(lineCursor, lineEnd, v) && parseLiteral(lineCursor, lineEnd, "/") && parseInt(lineCursor, lineEnd, t))
+					addVertex(corner++, v, t, 0);
 
-				if (!texturePath.is_absolute()) {
-					texturePath = path.parent_path();
-					texturePath.append(m.map_normal);
-				}
+				if (corner > 0)
+					break;
 
+				// v
+				lineCursor = faceStart;
 
-				newMaterial.normalTexture = std::move(loadTexture(texturePath.string()));
+				while (parseInt(lineCursor, lineEnd, v))
+					addVertex(corner++, v, 0, 0);
+			}
+			break;
 			}
+		}
+	}
 
-			if (!m.map_tangent.empty()) {
-				std::filesystem::path texturePath = m.map_tangent;
+	// texture maps are given relative to the obj file unless they are absolute
+	std::string texturePath(const std::filesystem::path & path, const std::string & map)
+	{
+		if (map.empty())
+			return std::string();
 
-				if (!texturePath.is_absolute()) {
-					texturePath = path.parent_path();
-					texturePath.append(m.map_tangent);
-				}
+		std::filesystem::path texturePath = map;
 
+		if (!texturePath.is_absolute())
+		{
+			texturePath = path.parent_path();
+			texturePath.append(map);
+		}
 
-				newMaterial.tangentTexture = std::move(loadTexture(texturePath.string()));
-			}
+		return texturePath.string();
+	}
 
-			m_materials.push_back(newMaterial);
+	void appendIndices(std::vector<uint> & indices, std::vector<uint> & newIndices)
+	{
+		if (indices.empty())
+			indices.swap(newIndices);
+		else
+			indices.insert(indices.end(), newIndices.begin(), newIndices.end());
 
+		std::vector<uint>().swap(newIndices);
+	}
+
+	void loadMtlLibrary(const std::filesystem::path & path, std::string libraryName, std::vector<ObjMaterial> & materials, std::unordered_map< std::string, int > & materialMap)
+	{
+		// the Wavefront obj specification does not really allow for spaces in the mtl file name,
+		// since multiple libraries are supposed to be separated by spaces, but many programs
+		// do not take care of that -- therefore, we first try whether it is a single filename,
+		// and only if that fails we use the interpretation according to the specification
+		std::filesystem::path libraryPath = libraryName;
+
+		// first try
+		if (libraryPath.is_absolute())
+		{
+			if (loadMtlFile(libraryPath.string(), materials, materialMap))
+				return;
 		}
 
-		return true;
+		std::stringstream mss(libraryName);
+
+		while (mss >> libraryName)
+		{
+			libraryName = trim(libraryName);
+			std::filesystem::path libraryPath = path.parent_path();
+			libraryPath.append(libraryName);
+			loadMtlFile(libraryPath.string(), materials, materialMap);
+		}
 	}
 
 	bool loadMtlFile(const std::string & filename, std::vector<ObjMaterial> & materials, std::unordered_map< std::string, int > & materialMap)
 	{
+		// also libraries that are missing, so that the mesh cache becomes stale once they are added
+		m_materialLibraries.push_back(filename);
+
 		std::ifstream is(filename);
 
 		if (!is.is_open())
 			return false;
 
+		if (m_report)
+		{
+			std::error_code error;
+			const std::uintmax_t size = std::filesystem::file_size(filename, error);
+
+			if (!error)
+				m_report->addBytesRead(size);
+		}
+
 		std::string buffer;
 		int currentMaterialIndex = 0;
 
@@ -880,74 +1376,30 @@ public:
 		return true;
 	}
 
-	std::unique_ptr<Texture> loadTexture(const std::string & filename)
+	// the results are moved out of the loader, so that the mesh only exists once
+	std::vector<Group> releaseGroups()
 	{
-		int width, height, channels;
-
-		stbi_set_flip_vertically_on_load(true);
-		unsigned char *data = stbi_load(filename.c_str(), &width, &height, &channels, 0);
-		if (data)
-		{
-			std::cout << "Loaded " << filename << std::endl;
-
-			auto texture = Texture::create(GL_TEXTURE_2D);
-			texture->setParameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-			texture->setParameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-			texture->setParameter(GL_TEXTURE_WRAP_S, GL_REPEAT);
-			texture->setParameter(GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-			GLenum format = GL_RGBA;
-
-			switch (channels)
-			{
-			case 1:
-				format = GL_RED;
-				break;
-
-			case 2:
-				format = GL_RG;
-				break;
-
-			case 3:
-				format = GL_RGB;
-				break;
-
-			case 4:
-				format = GL_RGBA;
-				break;
-			}
-				
-			texture->image2D(0, format, ivec2(width,height), 0, format, GL_UNSIGNED_BYTE, data);
-			texture->generateMipmap();
-
-			stbi_image_free(data);
-
-			return texture;
-		}
-
-		return std::unique_ptr<Texture>();
+		return std::move(m_groups);
 	}
 
-
-
-	const std::vector<Group> & groups() const
+	std::vector<Vertex> releaseVertices()
 	{
-		return m_groups;
+		return std::move(m_vertices);
 	}
 
-	const std::vector<Vertex> & vertices() const
+	std::vector<uint> releaseIndices()
 	{
-		return m_vertices;
+		return std::move(m_indices);
 	}
 
-	const std::vector<uint> & indices() const
+	std::vector<Material> releaseMaterials()
 	{
-		return m_indices;
+		return std::move(m_materials);
 	}
 
-	const std::vector<Material> & materials() const
+	const std::vector<std::string> & materialLibraries() const
 	{
-		return m_materials;
+		return m_materialLibraries;
 	}
 
 private:
@@ -956,6 +1408,9 @@ private:
 	std::vector < Vertex > m_vertices;
 	std::vector < glm::uint > m_indices;
 	std::vector < Material > m_materials;
+	std::vector < std::string > m_materialLibraries;
+
+	LoadReport* m_report = nullptr;
 
 };
 
@@ -964,70 +1419,385 @@ Model::Model()
 
 }
 
-Model::Model(const std::string& filename)
+Model::Model(const std::string& filename, const LoadOptions& options)
+{
+	load(filename, options);
+}
+
+Model::~Model()
 {
-	load(filename);
+
 }
 
-void Model::load(const std::string& filename)
+void Model::load(const std::string& filename, const LoadOptions& options)
 {
 	globjects::debug() << "Loading file " << filename << " ...";
 
 	m_minimumBounds = vec3(std::numeric_limits<float>::max());
 	m_maximumBounds = vec3(-std::numeric_limits<float>::max());
 
-	ObjLoader loader;
+	m_report.reset();
+	m_reportFilename = options.reportFilename;
+
+	if (options.report || !options.reportFilename.empty())
+		m_report = std::make_unique<LoadReport>(filename);
+
+	m_cache.reset();
+	m_vertices.clear();
+	m_indices.clear();
+
+	const std::string cacheFilename = MeshCache::cacheFilename(filename);
+	auto cache = std::make_unique<MeshCache>();
+	LoadReport::Timer cacheTimer(m_report.get(), LoadReport::Phase::FileIO);
+
+	if (options.useCache && cache->open(cacheFilename, cacheKey(options)))
+	{
+		globjects::debug() << "Using mesh cache " << cacheFilename;
+
+		if (m_report)
+		{
+			std::error_code error;
+			const std::uintmax_t size = std::filesystem::file_size(cacheFilename, error);
+
+			if (!error)
+				m_report->addBytesRead(size);
+
+			m_report->setCacheUsed(true);
+		}
 
-	if (loader.loadObjFile(filename))
+		m_filename = filename;
+		m_vertexData = cache->vertices();
+		m_vertexCount = cache->vertexCount();
+		m_indexData = cache->indices();
+		m_indexCount = cache->indexCount();
+		m_materials = cache->materials();
+		m_groups = cache->groups();
+		m_clusters = cache->clusters();
+		m_minimumBounds = cache->minimumBounds();
+		m_maximumBounds = cache->maximumBounds();
+		m_cache = std::move(cache);
+		cacheTimer.stop();
+
+		// the buffers are filled straight from the mapped cache file
+		LoadReport::Timer uploadTimer(m_report.get(), LoadReport::Phase::Upload);
+		if (!options.packVertices)
+			m_vertexBuffer->setStorage(m_vertexCount * sizeof(Vertex), m_vertexData, gl::GL_NONE_BIT);
+
+		if (!options.shortIndices && !options.triangleStrips)
+			m_indexBuffer->setStorage(m_indexCount * sizeof(uint), m_indexData, gl::GL_NONE_BIT);
+	}
+	else
 	{
+		cacheTimer.stop();
+		ObjLoader loader(m_report.get());
+
+		// one pool for parsing and all processing phases, so the threads are only started once per load
+		ThreadPool pool(options.threadCount);
+
+		if (!loader.loadObjFile(filename, options, pool))
+		{
+			globjects::debug() << "Error loading << " << filename << "!";
+			m_report.reset();
+			return;
+		}
+
 		m_filename = filename;
-		m_vertices = loader.vertices();
-		m_indices = loader.indices();
-		m_materials = loader.materials();
-		m_groups = loader.groups();
+		m_vertices = loader.releaseVertices();
+		m_indices = loader.releaseIndices();
+		m_materials = loader.releaseMaterials();
+		m_groups = loader.releaseGroups();
+		m_clusters.clear();
+
+		{
+			LoadReport::Timer timer(m_report.get(), LoadReport::Phase::TangentGeneration);
+			TangentGenerator::generate(m_indices, m_vertices, pool);
+		}
+
+		if (options.optimizeVertexCache)
+		{
+			LoadReport::Timer timer(m_report.get(), LoadReport::Phase::MeshOptimization);
+			const double acmrBefore = MeshOptimizer::acmr(m_groups, m_indices);
+
+			MeshOptimizer::optimize(m_groups, m_indices, m_vertices, options.reduceOverdraw, pool);
+
+			const double acmrAfter = MeshOptimizer::acmr(m_groups, m_indices);
+			globjects::debug() << "Average cache miss ratio (FIFO of " << MeshOptimizer::cacheSize << " vertices): " << acmrBefore << " before, " << acmrAfter << " after optimization";
+
+			if (m_report)
+				m_report->setAcmr(acmrBefore, acmrAfter);
+		}
+
+		if (options.buildClusters)
+		{
+			LoadReport::Timer timer(m_report.get(), LoadReport::Phase::ClusterBuilding);
+			ClusterBuilder::build(m_groups, m_indices, m_vertices, m_clusters, pool);
+
+			// the triangles of each cluster are ordered for the vertex cache again
+			if (options.optimizeVertexCache)
+			{
+				pool.parallelFor(m_clusters.size(), [&](std::size_t c)
+				{
+					MeshOptimizer::optimizeTriangles(m_indices.data() + m_clusters[c].startIndex, m_clusters[c].endIndex - m_clusters[c].startIndex, m_vertices, false);
+				});
+
+				globjects::debug() << "Average cache miss ratio after clustering: " << MeshOptimizer::acmr(m_groups, m_indices);
+			}
+
+			globjects::debug() << "Split " << m_groups.size() << " groups into " << m_clusters.size() << " clusters";
+		}
+
+		if (options.generateLods)
+		{
+			LoadReport::Timer timer(m_report.get(), LoadReport::Phase::LodGeneration);
+			const std::size_t fullIndexCount = m_indices.size();
+
+			LodGenerator::generate(m_groups, m_indices, m_vertices, pool);
+
+			std::size_t levelCount = 0;
+
+			for (auto & g : m_groups)
+				levelCount += g.lods.size();
+
+			// the levels are ordered for the vertex cache like the full groups
+			if (options.optimizeVertexCache)
+			{
+				pool.parallelFor(m_groups.size(), [&](std::size_t g)
+				{
+					for (auto & lod : m_groups[g].lods)
+						MeshOptimizer::optimizeTriangles(m_indices.data() + lod.startIndex, lod.endIndex - lod.startIndex, m_vertices, false);
+				});
+			}
+
+			globjects::debug() << "Generated " << levelCount << " levels of detail for " << m_groups.size() << " groups with " << (m_indices.size() - fullIndexCount) / 3 << " triangles in addition to " << fullIndexCount / 3;
+		}
+
+		// the index array is stored in the cache in this order, only the packing is repeated when loading it
+		if (options.shortIndices)
+		{
+			LoadReport::Timer timer(m_report.get(), LoadReport::Phase::MeshOptimization);
+			IndexPacker::sort(m_groups, m_indices, m_clusters);
+		}
+
+		{
+			LoadReport::Timer timer(m_report.get(), LoadReport::Phase::Bounds);
+
+			for (auto i : m_indices)
+			{
+				const auto & v = m_vertices[i];
+				m_minimumBounds = min(m_minimumBounds, v.position);
+				m_maximumBounds = max(m_maximumBounds, v.position);
+			}
+		}
+
+		m_vertexData = m_vertices.data();
+		m_vertexCount = m_vertices.size();
+		m_indexData = m_indices.data();
+		m_indexCount = m_indices.size();
 
-		for (auto i : m_indices)
 		{
-			const auto & v = m_vertices[i];
-			m_minimumBounds = min(m_minimumBounds, v.position);
-			m_maximumBounds = max(m_maximumBounds, v.position);
+			LoadReport::Timer timer(m_report.get(), LoadReport::Phase::Upload);
+			if (!options.packVertices)
+				m_vertexBuffer->setStorage(m_vertices, gl::GL_NONE_BIT);
+
+			if (!options.shortIndices && !options.triangleStrips)
+				m_indexBuffer->setStorage(m_indices, gl::GL_NONE_BIT);
+		}
+
+		// streaming ignores the weld distance, and the unwelded mesh must not be cached under a key that includes it
+		const bool weldingIgnored = options.memoryBudget > 0 && options.weldEpsilon > 0.0f;
+
+		if (options.useCache && weldingIgnored)
+		{
+			globjects::debug() << "Not writing mesh cache " << cacheFilename << ", since the weld distance was ignored.";
+		}
+		else if (options.useCache)
+		{
+			LoadReport::Timer timer(m_report.get(), LoadReport::Phase::FileIO);
+
+			std::vector<std::string> dependencies = { filename };
+			dependencies.insert(dependencies.end(), loader.materialLibraries().begin(), loader.materialLibraries().end());
+
+			if (MeshCache::write(cacheFilename, cacheKey(options), dependencies, *this))
+				globjects::debug() << "Wrote mesh cache " << cacheFilename;
+			else
+				globjects::debug() << "Could not write mesh cache " << cacheFilename << "!";
 		}
+	}
+
+	m_positionOffset = vec3(0.0f);
+	m_positionScale = vec3(1.0f);
+
+	if (options.packVertices)
+	{
+		LoadReport::Timer timer(m_report.get(), LoadReport::Phase::Upload);
+		const VertexQuantizer quantizer(m_minimumBounds, m_maximumBounds);
+		QuantizationError error;
+
+		m_vertexBuffer->setStorage(quantizer.pack(m_vertexData, m_vertexCount, error), gl::GL_NONE_BIT);
+		m_positionOffset = quantizer.positionOffset();
+		m_positionScale = quantizer.positionScale();
+
+		globjects::debug() << "Packed " << m_vertexCount << " vertices into " << m_vertexCount * sizeof(PackedVertex) / 1024 << " KB instead of " << m_vertexCount * sizeof(Vertex) / 1024 << " KB";
+		globjects::debug() << "Largest quantization errors: position " << error.position << ", normal " << error.direction << " degrees, texture coordinate " << error.texCoord;
+
+		if (m_report)
+			m_report->setQuantizationError(error.position, error.direction, error.texCoord);
+	}
+
+	if (m_report)
+		m_report->setVertexSize(options.packVertices ? sizeof(PackedVertex) : sizeof(Vertex));
+
+	m_shortIndexCount = 0;
+	m_shortIndices = options.shortIndices;
+	m_triangleStrips = options.triangleStrips;
+	m_stripPositions.clear();
+
+	if (options.shortIndices || options.triangleStrips)
+	{
+		LoadReport::Timer timer(m_report.get(), LoadReport::Phase::Upload);
+		uploadIndices();
+	}
+
+	// textures are decoded in the background and assigned in updateTextures() as they become available
+	for (auto & m : m_materials)
+	{
+		requestTextures(m, *m_textureLoader, options);
+		assignTextures(m, *m_textureLoader);
+	}
 
-		globjects::debug() << "Minimum bounds: " << m_minimumBounds;
-		globjects::debug() << "Maximum bounds: " << m_maximumBounds;
+	globjects::debug() << "Minimum bounds: " << m_minimumBounds;
+	globjects::debug() << "Maximum bounds: " << m_maximumBounds;
+	globjects::debug() << "Resident memory: " << MemoryUsage::residentSize() / (1 << 20) << " MB (peak: " << MemoryUsage::peakResidentSize() / (1 << 20) << " MB)";
 
-		m_vertexBuffer->setStorage(m_vertices, gl::GL_NONE_BIT);
-		m_indexBuffer->setStorage(m_indices, gl::GL_NONE_BIT);
+	auto vertexBindingPosition = m_vertexArray->binding(0);
+	vertexBindingPosition->setAttribute(0);
+	auto vertexBindingNormal = m_vertexArray->binding(1);
+	vertexBindingNormal->setAttribute(1);
+	auto vertexBindingTexCoord = m_vertexArray->binding(2);
+	vertexBindingTexCoord->setAttribute(2);
+	auto vertexBindingTangent = m_vertexArray->binding(3);
+	vertexBindingTangent->setAttribute(3);
 
-		auto vertexBindingPosition = m_vertexArray->binding(0);
-		vertexBindingPosition->setAttribute(0);
+	if (options.packVertices)
+	{
+		// the normalized formats are converted to floats when fetched, only the positions need to be scaled in the shaders
+		vertexBindingPosition->setBuffer(m_vertexBuffer.get(), 0, sizeof(PackedVertex));
+		vertexBindingPosition->setFormat(3, GL_UNSIGNED_SHORT, GL_TRUE);
+		vertexBindingNormal->setBuffer(m_vertexBuffer.get(), 4 * sizeof(std::uint16_t), sizeof(PackedVertex));
+		vertexBindingNormal->setFormat(4, GL_INT_2_10_10_10_REV, GL_TRUE);
+		vertexBindingTangent->setBuffer(m_vertexBuffer.get(), 4 * sizeof(std::uint16_t) + sizeof(uint), sizeof(PackedVertex));
+		vertexBindingTangent->setFormat(4, GL_INT_2_10_10_10_REV, GL_TRUE);
+		vertexBindingTexCoord->setBuffer(m_vertexBuffer.get(), 4 * sizeof(std::uint16_t) + 2 * sizeof(uint), sizeof(PackedVertex));
+		vertexBindingTexCoord->setFormat(2, GL_HALF_FLOAT);
+	}
+	else
+	{
 		vertexBindingPosition->setBuffer(m_vertexBuffer.get(), 0, sizeof(Vertex));
 		vertexBindingPosition->setFormat(3, GL_FLOAT);
-		m_vertexArray->enable(0);
-
-		auto vertexBindingNormal = m_vertexArray->binding(1);
-		vertexBindingNormal->setAttribute(1);
 		vertexBindingNormal->setBuffer(m_vertexBuffer.get(), sizeof(vec3), sizeof(Vertex));
 		vertexBindingNormal->setFormat(3, GL_FLOAT);
-		m_vertexArray->enable(1);
-
-		auto vertexBindingTexCoord = m_vertexArray->binding(2);
-		vertexBindingTexCoord->setAttribute(2);
 		vertexBindingTexCoord->setBuffer(m_vertexBuffer.get(), sizeof(vec3) + sizeof(vec3), sizeof(Vertex));
 		vertexBindingTexCoord->setFormat(2, GL_FLOAT);
-		m_vertexArray->enable(2);
+		vertexBindingTangent->setBuffer(m_vertexBuffer.get(), sizeof(vec3) + sizeof(vec3) + sizeof(vec2), sizeof(Vertex));
+		vertexBindingTangent->setFormat(4, GL_FLOAT);
+	}
 
-		m_vertexArray->bindElementBuffer(m_indexBuffer.get());
+	m_vertexArray->enable(0);
+	m_vertexArray->enable(1);
+	m_vertexArray->enable(2);
+	m_vertexArray->enable(3);
 
+	m_vertexArray->bindElementBuffer(m_indexBuffer.get());
+
+	{
+		LoadReport::Timer timer(m_report.get(), LoadReport::Phase::Upload);
+
+		// a fraction of the size of the full vertices, which makes depth-only passes cheaper to fetch
+		if (options.packVertices)
+		{
+			const VertexQuantizer quantizer(m_minimumBounds, m_maximumBounds);
+			std::vector< std::array<std::uint16_t, 4> > positions(m_vertexCount);
+
+			for (std::size_t i = 0; i < m_vertexCount; i++)
+				positions[i] = quantizer.packPosition(m_vertexData[i].position);
+
+			m_positionBuffer->setStorage(positions, gl::GL_NONE_BIT);
+		}
+		else
+		{
+			std::vector<vec3> positions(m_vertexCount);
+
+			for (std::size_t i = 0; i < m_vertexCount; i++)
+				positions[i] = m_vertexData[i].position;
+
+			m_positionBuffer->setStorage(positions, gl::GL_NONE_BIT);
+		}
+	}
+
+	auto positionBinding = m_positionArray->binding(0);
+	positionBinding->setAttribute(0);
+
+	if (options.packVertices)
+	{
+		positionBinding->setBuffer(m_positionBuffer.get(), 0, 4 * sizeof(std::uint16_t));
+		positionBinding->setFormat(3, GL_UNSIGNED_SHORT, GL_TRUE);
 	}
 	else
 	{
-		globjects::debug() << "Error loading << " << filename << "!";
+		positionBinding->setBuffer(m_positionBuffer.get(), 0, sizeof(vec3));
+		positionBinding->setFormat(3, GL_FLOAT);
+	}
+
+	m_positionArray->enable(0);
+
+	m_positionArray->bindElementBuffer(m_indexBuffer.get());
+
+	if (m_report && m_textureLoader->pendingCount() == 0)
+		finishReport();
+}
+
+
+
+
+bool Model::updateTextures()
+{
+	std::size_t uploadCount = 0;
+
+	{
+		LoadReport::Timer timer(m_report.get(), LoadReport::Phase::Upload);
+		uploadCount = m_textureLoader->upload();
+	}
+
+	if (uploadCount > 0)
+	{
+		for (auto & m : m_materials)
+			assignTextures(m, *m_textureLoader);
 	}
+
+	if (m_report && m_textureLoader->pendingCount() == 0)
+		finishReport();
+
+	return uploadCount > 0;
 }
 
+void Model::finishReport()
+{
+	m_report->addTime(LoadReport::Phase::TextureDecode, m_textureLoader->decodeTime());
+	m_report->addBytesRead(m_textureLoader->bytesRead());
+	m_report->setCounts(m_vertexCount, m_indexCount, m_groups.size(), m_materials.size(), m_textureLoader->textureCount());
+	m_report->finish();
+	m_report->print();
 
+	if (!m_reportFilename.empty())
+	{
+		if (m_report->writeJson(m_reportFilename))
+			globjects::debug() << "Wrote load report " << m_reportFilename;
+		else
+			globjects::debug() << "Could not write load report " << m_reportFilename << "!";
+	}
 
+	m_report.reset();
+}
 
 const std::string & Model::filename() const
 {
@@ -1041,11 +1811,17 @@ const std::vector<Group> & Model::groups() const
 
 const std::vector<Vertex> & Model::vertices() const
 {
+	if (m_cache && m_vertices.empty())
+		m_vertices.assign(m_vertexData, m_vertexData + m_vertexCount);
+
 	return m_vertices;
 }
 
 const std::vector<uint> & Model::indices() const
 {
+	if (m_cache && m_indices.empty())
+		m_indices.assign(m_indexData, m_indexData + m_indexCount);
+
 	return m_indices;
 }
 
@@ -1054,6 +1830,102 @@ const std::vector<Material> & Model::materials() const
 	return m_materials;
 }
 
+const std::vector<Cluster> & Model::clusters() const
+{
+	return m_clusters;
+}
+
+std::size_t Model::indexOffset(const Group& group, uint index) const
+{
+	return IndexPacker::offset(group, m_triangleStrips ? stripPosition(index) : index, m_shortIndexCount);
+}
+
+uint Model::indexCount(const Group& group, uint startIndex, uint endIndex) const
+{
+	return uint((indexOffset(group, endIndex) - indexOffset(group, startIndex)) / group.indexSize());
+}
+
+void Model::setTriangleStrips(bool triangleStrips)
+{
+	if (triangleStrips == m_triangleStrips)
+		return;
+
+	m_triangleStrips = triangleStrips;
+	uploadIndices();
+
+	m_vertexArray->bindElementBuffer(m_indexBuffer.get());
+	m_positionArray->bindElementBuffer(m_indexBuffer.get());
+}
+
+bool Model::triangleStrips() const
+{
+	return m_triangleStrips;
+}
+
+gl::GLenum Model::primitiveMode() const
+{
+	return m_triangleStrips ? GL_TRIANGLE_STRIP : GL_TRIANGLES;
+}
+
+void Model::uploadIndices()
+{
+	const auto startTime = std::chrono::steady_clock::now();
+
+	// the groups with the ranges of their full indices and levels of detail in the encoded indices
+	std::vector<Group> groups = m_groups;
+	std::vector<uint> strips;
+
+	if (m_triangleStrips)
+	{
+		strips = StripBuilder::build(m_groups, m_clusters, m_indexData, m_indexCount, m_stripPositions);
+
+		for (Group& group : groups)
+		{
+			group.startIndex = stripPosition(group.startIndex);
+			group.endIndex = stripPosition(group.endIndex);
+
+			for (GroupLod& lod : group.lods)
+			{
+				lod.startIndex = stripPosition(lod.startIndex);
+				lod.endIndex = stripPosition(lod.endIndex);
+			}
+		}
+	}
+	else
+	{
+		m_stripPositions.clear();
+	}
+
+	m_shortIndexCount = IndexPacker::shortIndexCount(groups);
+
+	// the storage of a buffer cannot be replaced
+	m_indexBuffer = std::make_unique<globjects::Buffer>();
+	std::size_t size = 0;
+
+	if (m_shortIndices || m_triangleStrips)
+	{
+		const std::vector<std::uint8_t> packed = m_triangleStrips ? IndexPacker::pack(groups, strips.data(), strips.size(), m_shortIndexCount) : IndexPacker::pack(groups, m_indexData, m_indexCount, m_shortIndexCount);
+		m_indexBuffer->setStorage(packed, gl::GL_NONE_BIT);
+		size = packed.size();
+	}
+	else
+	{
+		size = m_indexCount * sizeof(uint);
+		m_indexBuffer->setStorage(size, m_indexData, gl::GL_NONE_BIT);
+	}
+
+	const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - startTime;
+	const std::size_t shortGroupCount = std::count_if(m_groups.begin(), m_groups.end(), [](const Group& group) { return group.shortIndices; });
+
+	globjects::debug() << "Uploaded " << size / 1024 << " KB of indices as triangle " << (m_triangleStrips ? "strips" : "lists") << " in " << duration.count() << " ms, with 16 bits for " << shortGroupCount << " of " << m_groups.size() << " groups (" << m_indexCount * sizeof(uint) / 1024 << " KB as 32 bit lists)";
+}
+
+uint Model::stripPosition(uint index) const
+{
+	auto position = std::lower_bound(m_stripPositions.begin(), m_stripPositions.end(), index, [](const uvec2& p, uint i) { return p.x < i; });
+	return position != m_stripPositions.end() ? position->y : (m_stripPositions.empty() ? 0 : m_stripPositions.back().y);
+}
+
 vec3 Model::minimumBounds() const
 {
 	return m_minimumBounds;
@@ -1069,6 +1941,21 @@ VertexArray & Model::vertexArray()
 	return *m_vertexArray.get();
 }
 
+vec3 Model::positionOffset() const
+{
+	return m_positionOffset;
+}
+
+vec3 Model::positionScale() const
+{
+	return m_positionScale;
+}
+
+VertexArray & Model::positionArray()
+{
+	return *m_positionArray.get();
+}
+
 Buffer & Model::vertexBuffer()
 {
 	return *m_vertexBuffer.get();
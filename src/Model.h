@@ -9,15 +9,45 @@
 #include <globjects/VertexAttributeBinding.h>
 #include <globjects/Buffer.h>
 
+#include "TextureLoader.h"
+#include "LoadReport.h"
+
 #include <vector>
 
 namespace minity
 {
+	class MeshCache;
+
 	struct Vertex
 	{
 		glm::vec3 position;
 		glm::vec3 normal;
 		glm::vec2 texcoord;
+		// xyz is the tangent and w the sign of the bitangent, see TangentGenerator
+		glm::vec4 tangent;
+	};
+
+	// simplified version of a group, whose indices refer to the same vertices, see LodGenerator
+	struct GroupLod
+	{
+		glm::uint startIndex = 0;
+		glm::uint endIndex = 0;
+		// largest error of the simplification as a distance in model units
+		float error = 0.0f;
+	};
+
+	// small set of adjacent triangles of a group, contiguous in the index buffer, see ClusterBuilder
+	struct Cluster
+	{
+		glm::uint startIndex = 0;
+		glm::uint endIndex = 0;
+		glm::vec3 minBounds = glm::vec3(0.0f);
+		glm::vec3 maxBounds = glm::vec3(0.0f);
+		// the normals of all triangles are within the cone around the axis, and the cluster faces away from a camera at
+		// offset d from the center of its box if dot(d, coneAxis) <= -(coneCutoff * length(d) + radius of the box) --
+		// the cutoff is the sine of the opening angle, or 1 if the cluster cannot be culled this way
+		glm::vec3 coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+		float coneCutoff = 1.0f;
 	};
 
 	struct Group
@@ -29,12 +59,42 @@ namespace minity
 		glm::vec3 maxBounds = glm::vec3(0,0,0);
 		glm::vec3 minBounds = glm::vec3(0,0,0);
 		glm::vec3 centerMass = glm::vec3(0,0,0);
+		// coarser levels of detail with increasing errors after the full group in startIndex and endIndex, empty if none were generated
+		std::vector<GroupLod> lods;
+		// clusters of the full group in the cluster table of the model, none if they were not built
+		glm::uint firstCluster = 0;
+		glm::uint clusterCount = 0;
+		// the uploaded indices of the group and its levels of detail are relative to the base vertex, and 16 bit if
+		// shortIndices is set -- both are only used with LoadOptions::shortIndices, see IndexPacker
+		glm::uint baseVertex = 0;
+		bool shortIndices = false;
 		
 		glm::uint count() const
 		{
 			return endIndex - startIndex + 1;
 		}
 
+		// first index and number of indices of a level of detail, level 0 is the full group
+		glm::uint lodStartIndex(glm::uint level) const
+		{
+			return level > 0 ? lods[level - 1].startIndex : startIndex;
+		}
+
+		glm::uint lodIndexCount(glm::uint level) const
+		{
+			return level > 0 ? lods[level - 1].endIndex - lods[level - 1].startIndex : endIndex - startIndex;
+		}
+
+		gl::GLenum indexType() const
+		{
+			return shortIndices ? gl::GL_UNSIGNED_SHORT : gl::GL_UNSIGNED_INT;
+		}
+
+		glm::uint indexSize() const
+		{
+			return shortIndices ? 2 : 4;
+		}
+
 	};
 
 	struct Material
@@ -52,44 +112,158 @@ namespace minity
 		std::shared_ptr<globjects::Texture> bumpTexture;
 		std::shared_ptr<globjects::Texture> normalTexture;
 		std::shared_ptr<globjects::Texture> tangentTexture;
+
+		// resolved file names of the texture maps, empty if the material does not use the map
+		std::string ambientTexturePath;
+		std::string diffuseTexturePath;
+		std::string specularTexturePath;
+		std::string shininessTexturePath;
+		std::string bumpTexturePath;
+		std::string normalTexturePath;
+		std::string tangentTexturePath;
+	};
+
+	// how the normals of adjacent triangles are weighted when generating smooth normals
+	enum class NormalWeighting
+	{
+		Uniform,
+		Area,
+		Angle
+	};
+
+	struct LoadOptions
+	{
+		// number of threads used for parsing, 0 uses all hardware threads and 1 parses the file serially
+		unsigned int threadCount = 0;
+		// read the mesh and textures from binary caches next to the source files if they are up to date, and write them otherwise
+		bool useCache = true;
+		// block compress RGB and RGBA textures (BC1 and BC3), which uses less memory at a small loss of quality
+		bool compressTextures = false;
+		// positions closer than this distance are merged into one, 0 only merges vertices with identical indices
+		float weldEpsilon = 0.0f;
+		// weighting of generated normals, only used for files without normals
+		NormalWeighting normalWeighting = NormalWeighting::Uniform;
+		// upload the vertices in 20 instead of 48 bytes, with 16 bit positions relative to the model bounds, normals and tangents
+		// in GL_INT_2_10_10_10_REV and half float texture coordinates -- the vertices in main memory keep full precision
+		bool packVertices = false;
+		// reorder the triangles of each group for the post-transform vertex cache, and the vertices in the order they are used
+		bool optimizeVertexCache = false;
+		// additionally sort clusters of triangles so that outward facing ones are drawn first, at a slightly worse cache efficiency
+		bool reduceOverdraw = false;
+		// simplify each group into coarser levels of detail, which are appended to the index buffer
+		bool generateLods = false;
+		// split each group into clusters of up to 124 triangles with bounds and normal cones, which the renderer can cull
+		// one by one -- this replaces the triangle order of --optimize-mesh=overdraw by the cluster order
+		bool buildClusters = false;
+		// upload the indices of each group relative to its smallest vertex, in 16 bits for groups that span fewer than 65535
+		// vertices -- the indices in main memory stay 32 bit and absolute
+		bool shortIndices = false;
+		// upload the indices as triangle strips separated by primitive restarts, which need about half as many indices as
+		// lists -- the indices in main memory stay triangle lists
+		bool triangleStrips = false;
+		// maximum size in bytes of the intermediate data while parsing, which is streamed through temporary files next to the model,
+		// 0 keeps everything in memory -- the final vertex and index arrays are not included
+		std::size_t memoryBudget = 0;
+		// print the time per loading phase and other statistics once all textures have been uploaded
+		bool report = false;
+		// additionally write the report to this JSON file, enables the report if not empty
+		std::string reportFilename;
 	};
 
 	class Model
 	{
 	public:
 		Model();
-		Model(const std::string& filename);
-		void load(const std::string& filename);
+		Model(const std::string& filename, const LoadOptions& options = LoadOptions());
+		~Model();
+		void load(const std::string& filename, const LoadOptions& options = LoadOptions());
 		const std::string & filename() const;
 
+		// uploads textures that have finished decoding and assigns them to the materials, called once per frame --
+		// returns whether any material has changed
+		bool updateTextures();
+
 		const std::vector<Group> & groups() const;
+		// after loading from the mesh cache, these are only copied from the mapped file on the first call
 		const std::vector<Vertex> & vertices() const;
 		const std::vector<glm::uint> & indices() const;
 		const std::vector<Material> & materials() const;
+		const std::vector<Cluster> & clusters() const;
 
 		glm::vec3 minimumBounds() const;
 		glm::vec3 maximumBounds() const;
 
 		globjects::VertexArray & vertexArray();
 
+		// the vertex shaders decode the positions as offset + position * scale, which is the identity for unpacked vertices
+		glm::vec3 positionOffset() const;
+		glm::vec3 positionScale() const;
+
+		// only the positions at attribute 0, tightly packed, for passes that write depth only
+		globjects::VertexArray & positionArray();
+
 		globjects::Buffer & vertexBuffer();
 		globjects::Buffer & indexBuffer();
 
+		// offset in bytes of the index at the given position of a group in the index buffer, whose type is that of the
+		// group and whose values are relative to its base vertex -- with strips, the position has to be the start or end
+		// of the group, a level of detail or a cluster
+		std::size_t indexOffset(const Group& group, glm::uint index) const;
+		// number of indices in the index buffer for a range of positions of a group, with the same restriction
+		glm::uint indexCount(const Group& group, glm::uint startIndex, glm::uint endIndex) const;
+
+		// encodes and uploads the indices again as strips or lists, the draw calls have to be rebuilt afterwards
+		void setTriangleStrips(bool triangleStrips);
+		bool triangleStrips() const;
+		// GL_TRIANGLE_STRIP with GL_PRIMITIVE_RESTART_FIXED_INDEX for strips, GL_TRIANGLES otherwise
+		gl::GLenum primitiveMode() const;
+
 	private:
 
+		void finishReport();
+
+		// encodes the indices as selected into a new index buffer, and logs its size and the time this took
+		void uploadIndices();
+		// position in the strips of the start or end of a range of indices
+		glm::uint stripPosition(glm::uint index) const;
+
 		std::string m_filename;
 		
 		std::vector < Group > m_groups;
-		std::vector < Vertex > m_vertices;
-		std::vector < glm::uint > m_indices;
+		mutable std::vector < Vertex > m_vertices;
+		mutable std::vector < glm::uint > m_indices;
 		std::vector < Material > m_materials;
+		std::vector < Cluster > m_clusters;
+
+		// the final vertices and indices, either those of m_vertices and m_indices or in place in the mesh cache, which
+		// stays open after loading from it -- the buffers and strips are built from these
+		const Vertex* m_vertexData = nullptr;
+		std::size_t m_vertexCount = 0;
+		const glm::uint* m_indexData = nullptr;
+		std::size_t m_indexCount = 0;
+		std::unique_ptr<MeshCache> m_cache;
 
 		glm::vec3 m_minimumBounds = glm::vec3(0.0);
 		glm::vec3 m_maximumBounds = glm::vec3(0.0);
+		glm::vec3 m_positionOffset = glm::vec3(0.0f);
+		glm::vec3 m_positionScale = glm::vec3(1.0f);
+		// number of 16 bit indices at the start of the index buffer
+		std::size_t m_shortIndexCount = 0;
+		bool m_shortIndices = false;
+		bool m_triangleStrips = false;
+		std::vector<glm::uvec2> m_stripPositions;
 
 		std::unique_ptr<globjects::VertexArray> m_vertexArray = std::make_unique<globjects::VertexArray>();
 		std::unique_ptr<globjects::Buffer> m_vertexBuffer = std::make_unique<globjects::Buffer>();
 		std::unique_ptr< globjects::Buffer > m_indexBuffer = std::make_unique<globjects::Buffer>();
+		std::unique_ptr<globjects::VertexArray> m_positionArray = std::make_unique<globjects::VertexArray>();
+		std::unique_ptr<globjects::Buffer> m_positionBuffer = std::make_unique<globjects::Buffer>();
+
+		std::unique_ptr<TextureLoader> m_textureLoader = std::make_unique<TextureLoader>();
+
+		// only exists while a requested report is being collected
+		std::unique_ptr<LoadReport> m_report;
+		std::string m_reportFilename;
 
 	};
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "ModelRenderer.h"
 #include <globjects/base/File.h>
 #include <globjects/State.h>
+#include <globjects/TextureHandle.h>
 #include <iostream>
 #include <filesystem>
 #include <imgui.h>
@@ -8,6 +9,14 @@
 #include "Scene.h"
 #include "Model.h"
 #include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include <glbinding/Version.h>
+#include <glbinding-aux/ContextInfo.h>
 
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -29,24 +38,163 @@ ModelRenderer::ModelRenderer(Viewer* viewer) : Renderer(viewer)
 	m_lightArray->enable(0);
 	m_lightArray->unbind();
 
+	// multi-draw indirect and shader storage buffers are core in OpenGL 4.3, gl_DrawID needs an extension before 4.6
+	const auto extensions = glbinding::aux::ContextInfo::extensions();
+	const bool version43 = glbinding::aux::ContextInfo::version() >= glbinding::Version(4, 3);
+	m_multiDrawSupported = version43 && extensions.find(GLextension::GL_ARB_shader_draw_parameters) != extensions.end();
+	m_bindlessSupported = version43 && extensions.find(GLextension::GL_ARB_bindless_texture) != extensions.end();
+	m_indirectCountSupported = m_multiDrawSupported && extensions.find(GLextension::GL_ARB_indirect_parameters) != extensions.end();
+
+	// the model fragment shader samples material textures through a function defined in a second fragment shader
+	const std::string materialTextureShader = m_bindlessSupported ? "./res/model/model-textures-bindless-fs.glsl" : "./res/model/model-textures-bound-fs.glsl";
+
 	createShaderProgram("model-base", {
 		{ GL_VERTEX_SHADER,"./res/model/model-base-vs.glsl" },
-		{ GL_GEOMETRY_SHADER,"./res/model/model-base-gs.glsl" },
 		{ GL_FRAGMENT_SHADER,"./res/model/model-base-fs.glsl" },
+		{ GL_FRAGMENT_SHADER,materialTextureShader },
 		}, 
-		{ "./res/model/model-globals.glsl" });
+		{ "./res/model/model-globals.glsl", "./res/model/model-blocks.glsl" });
+
+	// reads the per-frame state from plain uniforms that are set one by one, kept to compare frame times
+	createShaderProgram("model-base-legacy", {
+		{ GL_VERTEX_SHADER,"./res/model/model-base-vs.glsl" },
+		{ GL_FRAGMENT_SHADER,"./res/model/model-base-fs.glsl" },
+		{ GL_FRAGMENT_SHADER,materialTextureShader },
+		},
+		{ "./res/model/model-globals.glsl", "./res/model/model-blocks.glsl" },
+		{ { "#include \"/model-blocks.glsl\"", "#define LEGACY_UNIFORMS\n#include \"/model-blocks.glsl\"" } });
+
+	// the previous pipeline with a geometry shader, kept to compare frame times
+	createShaderProgram("model-base-gs", {
+		{ GL_VERTEX_SHADER,"./res/model/model-base-vs.glsl" },
+		{ GL_GEOMETRY_SHADER,"./res/model/model-base-gs.glsl" },
+		{ GL_FRAGMENT_SHADER,"./res/model/model-base-fs.glsl" },
+		{ GL_FRAGMENT_SHADER,materialTextureShader },
+		},
+		{ "./res/model/model-globals.glsl", "./res/model/model-blocks.glsl" });
+
+	createShaderProgram("model-wireframe", {
+		{ GL_VERTEX_SHADER,"./res/model/model-prepass-vs.glsl" },
+		{ GL_FRAGMENT_SHADER,"./res/model/model-wireframe-fs.glsl" },
+		},
+		{ "./res/model/model-globals.glsl", "./res/model/model-blocks.glsl" });
+
+	createShaderProgram("model-prepass", {
+		{ GL_VERTEX_SHADER,"./res/model/model-prepass-vs.glsl" },
+		{ GL_FRAGMENT_SHADER,"./res/model/model-depth-fs.glsl" },
+		},
+		{ "./res/model/model-globals.glsl", "./res/model/model-blocks.glsl" });
+
+	createShaderProgram("model-occlusion", {
+		{ GL_VERTEX_SHADER,"./res/model/model-occlusion-vs.glsl" },
+		{ GL_FRAGMENT_SHADER,"./res/model/model-depth-fs.glsl" },
+		});
 
 	createShaderProgram("model-light", {
 		{ GL_VERTEX_SHADER,"./res/model/model-light-vs.glsl" },
 		{ GL_FRAGMENT_SHADER,"./res/model/model-light-fs.glsl" },
 		}, { "./res/model/model-globals.glsl" });
 
+	if (m_multiDrawSupported)
+	{
+		createShaderProgram("model-batch", {
+			{ GL_VERTEX_SHADER,"./res/model/model-batch-vs.glsl" },
+			{ GL_FRAGMENT_SHADER,"./res/model/model-base-fs.glsl" },
+			{ GL_FRAGMENT_SHADER,materialTextureShader },
+			},
+			{ "./res/model/model-globals.glsl", "./res/model/model-blocks.glsl", "./res/model/model-groups.glsl" });
+
+		createShaderProgram("model-batch-gs", {
+			{ GL_VERTEX_SHADER,"./res/model/model-batch-vs.glsl" },
+			{ GL_GEOMETRY_SHADER,"./res/model/model-base-gs.glsl" },
+			{ GL_FRAGMENT_SHADER,"./res/model/model-base-fs.glsl" },
+			{ GL_FRAGMENT_SHADER,materialTextureShader },
+			},
+			{ "./res/model/model-globals.glsl", "./res/model/model-blocks.glsl", "./res/model/model-groups.glsl" });
+
+		createShaderProgram("model-batch-wireframe", {
+			{ GL_VERTEX_SHADER,"./res/model/model-batch-depth-vs.glsl" },
+			{ GL_FRAGMENT_SHADER,"./res/model/model-wireframe-fs.glsl" },
+			},
+			{ "./res/model/model-globals.glsl", "./res/model/model-blocks.glsl", "./res/model/model-groups.glsl" });
+
+		// compute shaders are core in OpenGL 4.3 as well, so the batched path can always be culled on the GPU
+		createShaderProgram("model-cull", {
+			{ GL_COMPUTE_SHADER,"./res/model/model-cull-cs.glsl" },
+			},
+			{ "./res/model/model-globals.glsl", "./res/model/model-blocks.glsl", "./res/model/model-groups.glsl" });
+
+		createShaderProgram("model-depth", {
+			{ GL_VERTEX_SHADER,"./res/model/model-batch-depth-vs.glsl" },
+			{ GL_FRAGMENT_SHADER,"./res/model/model-depth-fs.glsl" },
+			},
+			{ "./res/model/model-globals.glsl", "./res/model/model-blocks.glsl", "./res/model/model-groups.glsl" });
+
+		createShaderProgram("model-depth-pyramid", {
+			{ GL_COMPUTE_SHADER,"./res/model/model-depth-pyramid-cs.glsl" },
+			});
+
+		if (!m_indirectCountSupported)
+			globjects::debug() << "Indirect draw counts are not supported, culled commands are kept with an instance count of zero.";
+	}
+	else
+	{
+		globjects::debug() << "Multi-draw indirect is not supported, groups are drawn one by one.";
+	}
+
+	if (m_bindlessSupported)
+		m_materialTextures = std::make_unique<Buffer>();
+	else
+		globjects::debug() << "Bindless textures are not supported, material textures are bound per draw.";
+
+	static_assert(sizeof(FrameUniforms) % 16 == 0, "FrameUniforms does not match the std140 layout of frameBlock");
+	m_frameUniforms->setStorage(sizeof(FrameUniforms), nullptr, GL_DYNAMIC_STORAGE_BIT);
+	m_materialData->setStorage(sizeof(MaterialData) * maximumMaterialCount, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+	// block bindings and texture units never change, and are restored by globjects when shaders are reloaded
+	auto setupModelProgram = [this](Program* program, bool frameBlock)
+	{
+		if (frameBlock)
+			program->uniformBlock("frameBlock")->setBinding(0);
+
+		program->uniformBlock("materialBlock")->setBinding(1);
+		program->setUniform("skybox", 0);
+
+		if (!m_bindlessSupported)
+		{
+			program->setUniform("diffuseTexture", 6);
+			program->setUniform("ambientTexture", 1);
+			program->setUniform("specularTexture", 2);
+			program->setUniform("normalTexture", 3);
+			program->setUniform("tangentTexture", 4);
+		}
+	};
+
+	setupModelProgram(shaderProgram("model-base"), true);
+	setupModelProgram(shaderProgram("model-base-gs"), true);
+	setupModelProgram(shaderProgram("model-base-legacy"), false);
+	shaderProgram("model-prepass")->uniformBlock("frameBlock")->setBinding(0);
+	shaderProgram("model-wireframe")->uniformBlock("frameBlock")->setBinding(0);
+
+	if (m_multiDrawSupported)
+	{
+		setupModelProgram(shaderProgram("model-batch"), true);
+		setupModelProgram(shaderProgram("model-batch-gs"), true);
+		shaderProgram("model-batch-wireframe")->uniformBlock("frameBlock")->setBinding(0);
+
+		shaderProgram("model-cull")->uniformBlock("frameBlock")->setBinding(0);
+		shaderProgram("model-cull")->setUniform("depthPyramid", 5);
+		shaderProgram("model-depth")->uniformBlock("frameBlock")->setBinding(0);
+		shaderProgram("model-depth-pyramid")->setUniform("depthTexture", 5);
+	}
 }
 
 bool setup = true;
 
 void ModelRenderer::display()
 {
+	const auto startTime = std::chrono::steady_clock::now();
+
 	// Save OpenGL state
 	auto currentState = State::currentState();
 
@@ -65,7 +213,8 @@ void ModelRenderer::display()
 	const mat3 inverseNormalMatrix = inverse(normalMatrix);
 	const vec2 viewportSize = viewer()->viewportSize();
 
-	auto shaderProgramModelBase = shaderProgram("model-base");
+	if (viewer()->scene()->model()->updateTextures() || !m_materialDataValid)
+		updateMaterialData(viewer()->scene()->model()->materials());
 
 	glEnable(GL_DEPTH_TEST);
 	glDepthFunc(GL_LESS);
@@ -73,12 +222,28 @@ void ModelRenderer::display()
 	viewer()->scene()->model()->vertexArray().bind();
 
 	const std::vector<Group>& groups = viewer()->scene()->model()->groups();
+	const std::vector<Cluster>& clusters = viewer()->scene()->model()->clusters();
 	const std::vector<Material>& materials = viewer()->scene()->model()->materials();
 
+	if (m_multiDrawSupported && !m_drawCommands)
+		createDrawCommands(*viewer()->scene()->model());
+
 	static std::vector<bool> groupEnabled(groups.size(), true);
 	static bool wireframeEnabled = false;
 	static bool lightSourceEnabled = true;
 	static vec4 wireframeLineColor = vec4(1.0f);
+	static bool batchedRendering = true;
+	static bool frustumCulling = true;
+	static bool gpuCulling = false;
+	static bool occlusionCulling = false;
+	static bool occlusionQueries = false;
+	static bool depthPrepass = false;
+	static bool geometryShader = false;
+	static bool levelOfDetail = true;
+	static float lodError = 1.0f;
+	static bool clusterCulling = true;
+	// off by default, since back faces are drawn and visible through open surfaces
+	static bool coneCulling = false;
 
 	// Shading Settings
 	static bool blinnPhong = true;
@@ -132,10 +297,113 @@ void ModelRenderer::display()
 
 	unsigned int skyboxTexture = viewer()->scene()->skyboxTexture;
 
+	const bool lodsAvailable = std::any_of(groups.begin(), groups.end(), [](const Group& group) { return !group.lods.empty(); });
+	const bool clustersAvailable = !clusters.empty();
+
 	if (ImGui::BeginMenu("Model")) {
 		ImGui::Checkbox("Wireframe Enabled", &wireframeEnabled);
 		ImGui::Checkbox("Light Source Enabled", &lightSourceEnabled);
 
+		if (m_multiDrawSupported)
+			ImGui::Checkbox("Batched Rendering", &batchedRendering);
+
+		ImGui::Checkbox("Frustum Culling", &frustumCulling);
+
+		if (m_multiDrawSupported && batchedRendering && frustumCulling)
+		{
+			ImGui::Checkbox("GPU Culling", &gpuCulling);
+
+			if (gpuCulling)
+				ImGui::Checkbox("Occlusion Culling", &occlusionCulling);
+		}
+
+		// the batched path culls occluded groups in the compute shader instead
+		if (!(m_multiDrawSupported && batchedRendering))
+			ImGui::Checkbox("Occlusion Queries", &occlusionQueries);
+
+		// lays down the depth first, so that each pixel is shaded only once
+		ImGui::Checkbox("Depth Pre-Pass", &depthPrepass);
+
+		// the previous pipeline, which computes the tangents per face
+		ImGui::Checkbox("Geometry Shader", &geometryShader);
+
+		// only available if the model was loaded with levels of detail
+		if (lodsAvailable)
+		{
+			ImGui::Checkbox("Level of Detail", &levelOfDetail);
+
+			if (levelOfDetail)
+				ImGui::SliderFloat("LOD Error (pixels)", &lodError, 0.1f, 10.0f);
+		}
+
+		// only available if the model was loaded with clusters, which are culled on the CPU
+		if (clustersAvailable && !(m_multiDrawSupported && batchedRendering && frustumCulling && gpuCulling))
+		{
+			ImGui::Checkbox("Cluster Culling", &clusterCulling);
+
+			// culls clusters that face away from the camera, which is only correct for closed surfaces since back face
+			// culling is not enabled
+			if (clusterCulling)
+				ImGui::Checkbox("Cone Culling", &coneCulling);
+		}
+
+		ImGui::Text("CPU Frame Time: %.3f ms", m_cpuFrameTime);
+		ImGui::Text("GPU Model Time: %.3f ms", m_modelTimer.smoothedTime());
+
+		if (m_benchmark == Benchmark::None)
+		{
+			if (ImGui::Button("Benchmark Depth Pre-Pass"))
+				m_benchmark = Benchmark::DepthPrepass;
+
+			if (ImGui::Button("Benchmark Geometry Shader"))
+				m_benchmark = Benchmark::GeometryShader;
+
+			// compares the triangle lists with strips, the model is encoded again for each
+			if (ImGui::Button("Benchmark Triangle Strips"))
+			{
+				m_benchmark = Benchmark::TriangleStrips;
+				m_benchmarkTriangleStrips = viewer()->scene()->model()->triangleStrips();
+			}
+
+			// compares the draws of the render queue in submission order with the draws sorted by state, which only
+			// applies without batched rendering
+			if (!(batchedRendering && m_drawCommands) && ImGui::Button("Benchmark State Sorting"))
+				m_benchmark = Benchmark::StateSorting;
+
+			// compares the per-frame state set uniform by uniform with the uniform buffer, without batched rendering
+			// and the geometry shader
+			if (!(batchedRendering && m_drawCommands) && ImGui::Button("Benchmark Uniform Buffers"))
+				m_benchmark = Benchmark::UniformBuffers;
+
+			m_benchmarkFrame = 0;
+		}
+		else
+		{
+			ImGui::Text("Benchmark running ...");
+		}
+
+		// the GPU path writes its results directly into the draw commands, nothing is counted or read back
+		if (m_multiDrawSupported && batchedRendering && frustumCulling && gpuCulling)
+		{
+			ImGui::Text("Culled Groups and Triangles: selected on the GPU");
+		}
+		else
+		{
+			ImGui::Text("Culled Groups: %u of %u", uint(m_culledGroupCount), uint(groups.size()));
+			ImGui::Text("Triangles: %u of %u", uint(m_lodTriangleCount), uint(m_fullTriangleCount));
+
+			if (clustersAvailable && clusterCulling)
+				ImGui::Text("Culled Clusters: %u of %u", uint(m_culledClusterCount), uint(clusters.size()));
+		}
+
+		if (occlusionQueries && !(m_multiDrawSupported && batchedRendering))
+			ImGui::Text("Occluded Groups: %u", uint(m_occludedGroupCount));
+
+		const RenderQueue::Statistics& statistics = m_renderQueue.statistics();
+		ImGui::Text("Draw Calls: %u, Program Binds: %u", statistics.drawCalls, statistics.programBinds);
+		ImGui::Text("Texture Binds: %u (%u skipped)", statistics.textureBinds, statistics.skippedTextureBinds);
+		ImGui::Text("Uniform Writes: %u (%u skipped)", statistics.uniformWrites, statistics.skippedUniformWrites);
+
 
 		if (wireframeEnabled) {
 			if (ImGui::CollapsingHeader("Wireframe")) {
@@ -210,7 +478,10 @@ void ModelRenderer::display()
 		if (ImGui::CollapsingHeader("Groups")) {
 			for (uint i = 0; i < groups.size(); i++) {
 				bool checked = groupEnabled.at(i);
-				ImGui::Checkbox(groups.at(i).name.c_str(), &checked);
+
+				if (ImGui::Checkbox(groups.at(i).name.c_str(), &checked))
+					m_groupEnabledChanged = true;
+
 				groupEnabled[i] = checked;
 			}
 		}
@@ -281,152 +552,528 @@ void ModelRenderer::display()
 
 
 
-	shaderProgramModelBase->setUniform("modelViewProjectionMatrix", modelViewProjectionMatrix);
-	shaderProgramModelBase->setUniform("modelViewMatrix", modelViewMatrix);
-	shaderProgramModelBase->setUniform("viewMatrix", viewMatrix);
-	shaderProgramModelBase->setUniform("modelLightMatrix", modelLightMatrix);
-	shaderProgramModelBase->setUniform("normalMatrix", normalMatrix);
-	shaderProgramModelBase->setUniform("procedualBumpMap", procedualBumpMap);
-	shaderProgramModelBase->setUniform("viewportSize", viewportSize);
-	shaderProgramModelBase->setUniform("worldCameraPosition", vec3(worldCameraPosition));
-	shaderProgramModelBase->setUniform("wireframeEnabled", wireframeEnabled);
-	shaderProgramModelBase->setUniform("wireframeLineColor", wireframeLineColor);
-	shaderProgramModelBase->setUniform("blinnPhong", blinnPhong);
-	shaderProgramModelBase->setUniform("toonShading", toonShading);
-	shaderProgramModelBase->setUniform("A", A);
-	shaderProgramModelBase->setUniform("k", k);
-	shaderProgramModelBase->setUniform("reflectionBool", reflectionBool);
-	shaderProgramModelBase->setUniform("onlyReflection", onlyReflection);
-	shaderProgramModelBase->setUniform("ambientReflection", ambientReflection);
-	shaderProgramModelBase->setUniform("refractionBool", refractionBool);
-	shaderProgramModelBase->setUniform("refractionRatio", ratio);
-	if (manLightPos) {
-		shaderProgramModelBase->setUniform("worldLightPosition", vec3(worldLightPosition) + vec3(lightX, lightY, lightZ));
-	}
-	else {
-		shaderProgramModelBase->setUniform("worldLightPosition", vec3(worldLightPosition));
+	bool prepassEnabled = depthPrepass;
+	bool geometryShaderEnabled = geometryShader;
+	bool stateSortingEnabled = true;
+	bool uniformBuffersEnabled = true;
+	bool benchmarkFrameMeasured = false;
+
+	if (m_benchmark != Benchmark::None)
+	{
+		const int phaseLength = benchmarkWarmUpFrames + benchmarkFrames;
+		const int phase = m_benchmarkFrame / phaseLength;
+		const int frame = m_benchmarkFrame % phaseLength;
+
+		if (frame == 0 && phase > 0)
+		{
+			m_benchmarkTimes[phase - 1] = m_modelTimer.meanTime();
+			m_benchmarkCpuTimes[phase - 1] = m_benchmarkCpuTime / benchmarkFrames;
+		}
+
+		if (phase < 2)
+		{
+			// results of the warm-up frames, which may still be from the previous phase, are discarded
+			if (frame == benchmarkWarmUpFrames)
+			{
+				m_modelTimer.reset();
+				m_benchmarkCpuTime = 0.0;
+			}
+
+			benchmarkFrameMeasured = frame >= benchmarkWarmUpFrames;
+
+			if (m_benchmark == Benchmark::DepthPrepass)
+				prepassEnabled = phase == 1;
+			else if (m_benchmark == Benchmark::GeometryShader)
+				geometryShaderEnabled = phase == 1;
+			else if (m_benchmark == Benchmark::StateSorting)
+				stateSortingEnabled = phase == 1;
+			else if (m_benchmark == Benchmark::UniformBuffers)
+				uniformBuffersEnabled = phase == 1;
+			else if (frame == 0)
+				setTriangleStrips(phase == 1);
+
+			m_benchmarkFrame++;
+		}
+		else
+		{
+			const ivec2 size = ivec2(viewer()->viewportSize());
+			const char* feature = "the geometry shader";
+
+			if (m_benchmark == Benchmark::DepthPrepass)
+				feature = "the depth pre-pass";
+			else if (m_benchmark == Benchmark::TriangleStrips)
+				feature = "triangle strips";
+			else if (m_benchmark == Benchmark::StateSorting)
+				feature = "state sorting";
+			else if (m_benchmark == Benchmark::UniformBuffers)
+				feature = "uniform buffers";
+
+			globjects::debug() << "Benchmark at " << size.x << "x" << size.y << ": GPU " << m_benchmarkTimes[0] << " ms without, " << m_benchmarkTimes[1] << " ms with " << feature
+				<< ", CPU " << m_benchmarkCpuTimes[0] << " ms without, " << m_benchmarkCpuTimes[1] << " ms with " << feature;
+
+			if (m_benchmark == Benchmark::TriangleStrips)
+				setTriangleStrips(m_benchmarkTriangleStrips);
+
+			m_benchmark = Benchmark::None;
+		}
 	}
-	
+
+	const bool batched = batchedRendering && m_drawCommands;
+	const bool culledOnGpu = batched && frustumCulling && gpuCulling;
+	const bool occlusionCulledOnGpu = culledOnGpu && occlusionCulling;
+	const bool clustered = clustersAvailable && clusterCulling && !culledOnGpu;
+	const GLenum primitiveMode = viewer()->scene()->model()->primitiveMode();
+	Program* shaderProgramModel = nullptr;
+
+	if (batched)
+		shaderProgramModel = geometryShaderEnabled ? shaderProgram("model-batch-gs") : shaderProgram("model-batch");
+	else if (!uniformBuffersEnabled)
+		shaderProgramModel = shaderProgram("model-base-legacy");
+	else
+		shaderProgramModel = geometryShaderEnabled ? shaderProgram("model-base-gs") : shaderProgram("model-base");
+
 	vec3 centerModel = (viewer()->scene()->model()->maximumBounds() + viewer()->scene()->model()->minimumBounds()) * 0.5f;
 
-	
-	shaderProgramModelBase->use();
+	// how far each group is moved away from the center of the model, the batch vertex shader computes the same
+	m_explosionScales.resize(groups.size());
+
+	// on the GPU, the CPU cost of a frame does not depend on the number of groups
+	for (uint i = 0; i < groups.size() && !culledOnGpu; i++)
+	{
+		// explosion based on camera positon
+		// used log a better effect
+		float c_explode = 0.0f;
+		if(cameraExplosion){
+			c_explode = -log(distance(normalize(vec3(worldCameraPosition.x, worldCameraPosition.y, worldCameraPosition.z)), normalize(groups.at(i).centerMass)));
+			if(c_explode > distance(normalize(vec3(worldCameraPosition.x, worldCameraPosition.y, worldCameraPosition.z)), normalize(groups.at(i).centerMass)) * 3){
+				c_explode = c_explode*5;
+			}
+		}
+
+		m_explosionScales[i] = c_explode + explosion;
+	}
+
+	// pixels per model unit at a distance of one, divided by the largest error in pixels -- a scale in the view
+	// transformation cancels out, as it changes the errors and the distances alike
+	const float lodScale = levelOfDetail && lodsAvailable ? projectionMatrix[1][1] * viewportSize.y * 0.5f / lodError : 0.0f;
 
-	for (uint i = 0; i < groups.size(); i++)
+	if (culledOnGpu)
+	{
+		// the source commands only change with the group selection, the compute shader does the rest
+		if (m_groupEnabledChanged || m_groupVisible.size() != groups.size() || m_culledGroupCount > 0)
+		{
+			m_groupVisible.assign(groups.size(), 1);
+			m_groupLods.assign(groups.size(), 0);
+			m_culledGroupCount = 0;
+			updateDrawCommands(*viewer()->scene()->model(), groupEnabled);
+		}
+	}
+	else
+	{
+		if (m_frustumCuller.groupCount() != groups.size())
+			m_frustumCuller.setGroups(groups);
+
+		if (frustumCulling)
+		{
+			m_frustumCuller.cull(modelViewProjectionMatrix, centerModel, m_explosionScales, m_groupVisible);
+		}
+		else
+		{
+			m_groupVisible.assign(groups.size(), 1);
+		}
+
+		selectLods(groups, vec3(worldCameraPosition), centerModel, lodScale);
+
+		if (clustered)
+			cullClusters(*viewer()->scene()->model(), groupEnabled, modelViewProjectionMatrix, vec3(worldCameraPosition), centerModel, frustumCulling, coneCulling);
+		else
+			m_groupClustered.assign(groups.size(), 0);
+
+		m_culledGroupCount = 0;
+		m_lodTriangleCount = 0;
+		m_fullTriangleCount = 0;
+
+		for (uint i = 0; i < groups.size(); i++)
+		{
+			if (!groupEnabled.at(i))
+				continue;
+
+			if (m_groupVisible[i])
+			{
+				if (m_groupClustered[i])
+				{
+					for (uint r = m_groupRuns[i]; r < m_groupRuns[i + 1]; r++)
+						m_lodTriangleCount += (m_runs[r].y - m_runs[r].x) / 3;
+				}
+				else
+				{
+					m_lodTriangleCount += groups.at(i).lodIndexCount(m_groupLods[i]) / 3;
+				}
+
+				m_fullTriangleCount += groups.at(i).lodIndexCount(0) / 3;
+			}
+			else
+			{
+				m_culledGroupCount++;
+			}
+		}
+
+		if (batched)
+			updateDrawCommands(*viewer()->scene()->model(), groupEnabled);
+
+		if (batched && clustered)
+			updateClusterCommands();
+	}
+
+	m_groupEnabledChanged = false;
+
+	if (!occlusionCulledOnGpu)
+		m_depthPyramidValid = false;
+
+	// the colors of the first visible group's material are used as the initial lighting settings
+	for (uint i = 0; i < groups.size() && setup; i++)
 	{
 		if (groupEnabled.at(i))
 		{
 			const Material& material = materials.at(groups.at(i).materialIndex);
 
-			if (setup) {
-				diffuseColor = vec4(material.diffuse, 1.0f);
-				ambientColor = vec4(material.ambient, 1.0f);
-				specularColor = vec4(material.specular, 1.0f);
-				shine = material.shininess;
-				if (material.diffuseTexture) diffuseTexture = true;
-				if (material.ambientTexture) ambientTexture = true;
-				if (material.specularTexture) specularTexture = true;
-				if (material.normalTexture) normalTexture = true;
-				setup = false;
-			}
+			diffuseColor = vec4(material.diffuse, 1.0f);
+			ambientColor = vec4(material.ambient, 1.0f);
+			specularColor = vec4(material.specular, 1.0f);
+			shine = material.shininess;
+			if (!material.diffuseTexturePath.empty()) diffuseTexture = true;
+			if (!material.ambientTexturePath.empty()) ambientTexture = true;
+			if (!material.specularTexturePath.empty()) specularTexture = true;
+			if (!material.normalTexturePath.empty()) normalTexture = true;
+			setup = false;
+		}
+	}
 
-			// Blin Phong
-			shaderProgramModelBase->setUniform("diffuseColor", diffuseColor);
-			shaderProgramModelBase->setUniform("ambientColor", ambientColor);
-			shaderProgramModelBase->setUniform("specularColor", specularColor);
-			shaderProgramModelBase->setUniform("specularExponent", shine);
+	// all per-frame state goes into one buffer write
+	FrameUniforms frameUniforms;
+	frameUniforms.modelViewProjectionMatrix = modelViewProjectionMatrix;
+	frameUniforms.modelViewMatrix = modelViewMatrix;
+	frameUniforms.viewMatrix = viewMatrix;
+	frameUniforms.modelLightMatrix = modelLightMatrix;
+	frameUniforms.normalMatrix[0] = vec4(normalMatrix[0], 0.0f);
+	frameUniforms.normalMatrix[1] = vec4(normalMatrix[1], 0.0f);
+	frameUniforms.normalMatrix[2] = vec4(normalMatrix[2], 0.0f);
+	frameUniforms.worldCameraPosition = vec3(worldCameraPosition);
+	frameUniforms.explosion = explosion;
 
-			shaderProgramModelBase->setUniform("diffuseIntensity", diffuseIntensity);
-			shaderProgramModelBase->setUniform("ambientIntensity", ambientIntensity);
-			shaderProgramModelBase->setUniform("specularIntensity", specularIntensity);
+	if (manLightPos) {
+		frameUniforms.worldLightPosition = vec3(worldLightPosition) + vec3(lightX, lightY, lightZ);
+	}
+	else {
+		frameUniforms.worldLightPosition = vec3(worldLightPosition);
+	}
 
-			shaderProgramModelBase->setUniform("diffuseTexBool", diffuseTexture);
-			shaderProgramModelBase->setUniform("ambientTexBool", ambientTexture);
-			shaderProgramModelBase->setUniform("specularTexBool", specularTexture);
-			shaderProgramModelBase->setUniform("normalTexBool", normalTexture);
-			shaderProgramModelBase->setUniform("tangentTexBool", tangentTexture);
+	frameUniforms.refractionRatio = ratio;
+	frameUniforms.centerModel = centerModel;
+	frameUniforms.specularExponent = shine;
+	frameUniforms.positionOffset = viewer()->scene()->model()->positionOffset();
+	frameUniforms.positionScale = viewer()->scene()->model()->positionScale();
+	frameUniforms.wireframeLineColor = wireframeLineColor;
+
+	// Blin Phong
+	frameUniforms.ambientColor = ambientColor;
+	frameUniforms.diffuseColor = diffuseColor;
+	frameUniforms.specularColor = specularColor;
+	frameUniforms.viewportSize = viewportSize;
+	frameUniforms.ambientIntensity = ambientIntensity;
+	frameUniforms.diffuseIntensity = diffuseIntensity;
+	frameUniforms.specularIntensity = specularIntensity;
+	frameUniforms.A = A;
+	frameUniforms.k = k;
+
+	frameUniforms.blinnPhong = blinnPhong;
+	frameUniforms.toonShading = toonShading;
+	frameUniforms.procedualBumpMap = procedualBumpMap;
+	frameUniforms.reflectionBool = reflectionBool;
+	frameUniforms.onlyReflection = onlyReflection;
+	frameUniforms.ambientReflection = ambientReflection;
+	frameUniforms.refractionBool = refractionBool;
+	frameUniforms.cameraExplosion = cameraExplosion;
+
+	frameUniforms.diffuseTexBool = diffuseTexture;
+	frameUniforms.ambientTexBool = ambientTexture;
+	frameUniforms.specularTexBool = specularTexture;
+	frameUniforms.normalTexBool = normalTexture;
+	frameUniforms.tangentTexBool = tangentTexture;
+
+	// the depth pre-pass and the wireframe read the uniform buffer in either case
+	m_frameUniforms->setSubData(0, sizeof(FrameUniforms), &frameUniforms);
+
+	if (!uniformBuffersEnabled)
+		setLegacyUniforms(shaderProgramModel, frameUniforms);
+	m_frameUniforms->bindBase(GL_UNIFORM_BUFFER, 0);
+	m_materialData->bindBase(GL_UNIFORM_BUFFER, 1);
+
+	if (m_bindlessSupported)
+		m_materialTextures->bindBase(GL_SHADER_STORAGE_BUFFER, 1);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTexture);
+
+	// textures stay bound until another material needs the unit, the render queue skips binds that change nothing
+	auto bindMaterialTextures = [&](const Material& material)
+	{
+		if (m_bindlessSupported)
+			return;
+
+		if (diffuseTexture)
+			m_renderQueue.bindTexture(6, material.diffuseTexture.get());
+		if (ambientTexture)
+			m_renderQueue.bindTexture(1, material.ambientTexture.get());
+		if (specularTexture)
+			m_renderQueue.bindTexture(2, material.specularTexture.get());
+		if (normalTexture)
+			m_renderQueue.bindTexture(3, material.normalTexture.get());
+
+		m_renderQueue.bindTexture(4, material.tangentTexture.get());
+	};
+
+	m_renderQueue.begin();
+	m_modelTimer.begin();
+
+	// strips end at the largest value of the index type
+	if (viewer()->scene()->model()->triangleStrips())
+		glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+
+	// the main pass only shades the fragments that are left after the depth pre-pass, which needs exactly the same depth
+	auto beginMainPass = [&]()
+	{
+		if (!prepassEnabled)
+			return;
 
-			
-			
-			mat4 trans;
-			mat4 rot;
-
-			// explosion based on camera positon
-			// used log a better effect
-			float c_explode = 0.0f;
-			if(cameraExplosion){
-				c_explode = -log(distance(normalize(vec3(worldCameraPosition.x, worldCameraPosition.y, worldCameraPosition.z)), normalize(groups.at(i).centerMass)));
-				if(c_explode > distance(normalize(vec3(worldCameraPosition.x, worldCameraPosition.y, worldCameraPosition.z)), normalize(groups.at(i).centerMass)) * 3){
-					c_explode = c_explode*5;
-				}
-			} 
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+		glDepthFunc(GL_EQUAL);
+		glDepthMask(GL_FALSE);
+		viewer()->scene()->model()->vertexArray().bind();
+	};
 
-			// Get Direction from center of mass
-			vec3 dir = (groups.at(i).centerMass - centerModel);
-			trans = translate(mat4(1.0f), dir * vec3(c_explode+explosion));
-			
+	auto endMainPass = [&]()
+	{
+		if (!prepassEnabled)
+			return;
 
-			shaderProgramModelBase->setUniform("explosion", explosion);
-			shaderProgramModelBase->setUniform("transformation", trans);
-			shaderProgramModelBase->setUniform("rotation", rot);
+		glDepthFunc(GL_LESS);
+		glDepthMask(GL_TRUE);
+	};
 
+	// the edges are drawn as lines over the shaded triangles, moved slightly towards the camera to pass the depth test
+	auto beginWireframe = [&]()
+	{
+		viewer()->scene()->model()->positionArray().bind();
+		glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+		glEnable(GL_POLYGON_OFFSET_LINE);
+		glPolygonOffset(-1.0f, -1.0f);
+		glDepthFunc(GL_LEQUAL);
+		glDepthMask(GL_FALSE);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	};
 
-			glBindTexture(GL_TEXTURE_CUBE_MAP, skyboxTexture);
+	auto endWireframe = [&]()
+	{
+		glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+		glDisable(GL_POLYGON_OFFSET_LINE);
+		glDepthFunc(GL_LESS);
+		glDepthMask(GL_TRUE);
+		glDisable(GL_BLEND);
+		viewer()->scene()->model()->vertexArray().bind();
+	};
 
-			if (material.diffuseTexture && diffuseTexture)
-			{
-				//diffuseTexture = true;
-				shaderProgramModelBase->setUniform("diffuseTexture", 6);
-				material.diffuseTexture->bindActive(6);
-			}
-			if (material.ambientTexture && ambientTexture)
+	if (batched)
+	{
+		// the explosion offsets are computed in the vertex shader from the group data
+		m_groupData->bindBase(GL_SHADER_STORAGE_BUFFER, 0);
+
+		if (culledOnGpu)
+			cullOnGpu(occlusionCulledOnGpu && m_depthPyramidValid, lodScale);
+
+		const bool compacted = culledOnGpu && m_indirectCountSupported;
+		Buffer* commands = culledOnGpu ? m_culledCommands.get() : clustered ? m_clusterCommands.get() : m_drawCommands.get();
+		const std::vector<DrawBatch>& drawBatchList = clustered ? m_clusterBatches : m_drawBatches;
+
+		commands->bind(GL_DRAW_INDIRECT_BUFFER);
+
+		if (compacted)
+			m_drawCounts->bind(GL_PARAMETER_BUFFER_ARB);
+
+		// one call per texture set, as the textures have to be bound separately, or a single one with bindless textures
+		auto drawBatches = [&](bool bindTextures)
+		{
+			for (uint b = 0; b < drawBatchList.size(); b++)
 			{
-				shaderProgramModelBase->setUniform("ambientTexture", 1);
-				material.ambientTexture->bindActive(1);
+				const DrawBatch& batch = drawBatchList[b];
+				const void* firstCommand = reinterpret_cast<const void*>(sizeof(DrawCommand) * batch.firstCommand);
+
+				if (bindTextures)
+					bindMaterialTextures(materials.at(batch.materialIndex));
 
+				if (compacted)
+					glMultiDrawElementsIndirectCountARB(primitiveMode, batch.indexType, firstCommand, GLintptr(sizeof(uint) * b), GLsizei(batch.commandCount), 0);
+				else
+					glMultiDrawElementsIndirect(primitiveMode, batch.indexType, firstCommand, GLsizei(batch.commandCount), 0);
+
+				m_renderQueue.countDraw();
 			}
-			if (material.specularTexture && specularTexture)
+		};
+
+		if (prepassEnabled)
+		{
+			viewer()->scene()->model()->positionArray().bind();
+			glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+			m_renderQueue.useProgram(shaderProgram("model-depth"));
+			drawBatches(false);
+		}
+
+		beginMainPass();
+		m_renderQueue.useProgram(shaderProgramModel);
+		drawBatches(true);
+		endMainPass();
+
+		if (wireframeEnabled)
+		{
+			beginWireframe();
+			m_renderQueue.useProgram(shaderProgram("model-batch-wireframe"));
+			drawBatches(false);
+			endWireframe();
+		}
+
+		if (occlusionCulledOnGpu)
+		{
+			updateDepthPyramid([&]()
 			{
-				shaderProgramModelBase->setUniform("specularTexture", 2);
-				material.specularTexture->bindActive(2);
-			}
+				viewer()->scene()->model()->positionArray().bind();
+				m_renderQueue.useProgram(shaderProgram("model-depth"));
+				drawBatches(false);
+				viewer()->scene()->model()->vertexArray().bind();
+			});
 
-			if (material.normalTexture && normalTexture) {
-				shaderProgramModelBase->setUniform("normalTexture", 3);
-				material.normalTexture->bindActive(3);
-			}
-			if (material.tangentTexture) {
-				shaderProgramModelBase->setUniform("tangentTexture", 4);
-				material.tangentTexture->bindActive(4);
-			}
+			m_previousModelViewProjection = modelViewProjectionMatrix;
+		}
 
-			viewer()->scene()->model()->vertexArray().drawElements(GL_TRIANGLES, groups.at(i).count(), GL_UNSIGNED_INT, (void*)(sizeof(GLuint)*groups.at(i).startIndex));
+		if (compacted)
+			m_drawCounts->unbind(GL_PARAMETER_BUFFER_ARB);
 
+		commands->unbind(GL_DRAW_INDIRECT_BUFFER);
+		m_groupData->unbind(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+	else
+	{
+		if (occlusionQueries)
+			collectOcclusionQueries(groups.size());
+		else
+			m_groupOccluded.assign(groups.size(), 0);
+
+		m_renderQueue.clear();
+		m_occludedGroupCount = 0;
+
+		for (uint i = 0; i < groups.size(); i++)
+		{
+			if (!groupEnabled.at(i) || !m_groupVisible[i])
+				continue;
+
+			if (m_groupOccluded[i])
+				m_occludedGroupCount++;
+			else
+				m_renderQueue.submit(shaderProgramModel, i, groups.at(i).materialIndex);
+		}
+
+		if (stateSortingEnabled)
+			m_renderQueue.sort();
+
+		auto groupTransformation = [&](uint groupIndex)
+		{
+			// Get Direction from center of mass
+			vec3 dir = (groups.at(groupIndex).centerMass - centerModel);
+			return translate(mat4(1.0f), dir * vec3(m_explosionScales[groupIndex]));
+		};
 
-			if (material.diffuseTexture)
+		// clustered groups are drawn as the index ranges of their remaining clusters, with the vertex array already bound
+		auto drawGroup = [&](VertexArray& vertexArray, uint groupIndex)
+		{
+			const Group& group = groups.at(groupIndex);
+
+			if (m_groupClustered[groupIndex])
 			{
-				material.diffuseTexture->unbind();
+				const uint firstRun = m_groupRuns[groupIndex];
+				const uint runCount = m_groupRuns[groupIndex + 1] - firstRun;
+
+				if (runCount == 0)
+					return;
+
+				glMultiDrawElementsBaseVertex(primitiveMode, &m_runCounts[firstRun], group.indexType(), &m_runOffsets[firstRun], GLsizei(runCount), &m_runBaseVertices[firstRun]);
 			}
-			if (material.ambientTexture)
+			else
 			{
-				material.ambientTexture->unbind();
+				const Model& model = *viewer()->scene()->model();
+				const uint level = m_groupLods[groupIndex];
+				const uint startIndex = group.lodStartIndex(level);
+				const void* offset = reinterpret_cast<const void*>(model.indexOffset(group, startIndex));
+				vertexArray.drawElementsBaseVertex(primitiveMode, model.indexCount(group, startIndex, startIndex + group.lodIndexCount(level)), group.indexType(), offset, GLint(group.baseVertex));
 			}
-			if (material.specularTexture)
+
+			m_renderQueue.countDraw();
+		};
+
+		// the depth pre-pass and the wireframe only need the positions
+		auto drawPositions = [&](Program* program)
+		{
+			m_renderQueue.useProgram(program);
+
+			for (const RenderQueue::Item& item : m_renderQueue.items())
 			{
-				material.specularTexture->unbind();
-			}
-			if (material.normalTexture) {
-				material.normalTexture->unbind();
-			}
-			if (material.tangentTexture) {
-				material.tangentTexture->unbind();
+				m_renderQueue.setUniform("transformation", groupTransformation(item.groupIndex));
+				drawGroup(viewer()->scene()->model()->positionArray(), item.groupIndex);
 			}
+		};
 
+		if (prepassEnabled)
+		{
+			viewer()->scene()->model()->positionArray().bind();
+			glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+			drawPositions(shaderProgram("model-prepass"));
+		}
+
+		beginMainPass();
+
+		for (const RenderQueue::Item& item : m_renderQueue.items())
+		{
+			m_renderQueue.useProgram(item.program);
+			m_renderQueue.setUniform("transformation", groupTransformation(item.groupIndex));
+			m_renderQueue.setUniform("groupMaterialIndex", item.materialIndex);
+
+			bindMaterialTextures(materials.at(item.materialIndex));
+
+			drawGroup(viewer()->scene()->model()->vertexArray(), item.groupIndex);
+		}
+
+		endMainPass();
+
+		if (wireframeEnabled)
+		{
+			beginWireframe();
+			drawPositions(shaderProgram("model-wireframe"));
+			endWireframe();
+		}
+
+		if (occlusionQueries)
+		{
+			// the near plane distance in model space, as the view transformation may contain a scale
+			const float nearDistance = projectionMatrix[3][2] / (projectionMatrix[2][2] - 1.0f);
+			const float nearMargin = 2.0f * nearDistance / length(vec3(modelViewMatrix[0]));
+
+			issueOcclusionQueries(groups, groupEnabled, modelViewProjectionMatrix, centerModel, vec3(worldCameraPosition), nearMargin);
 		}
 	}
-	
-	
-	shaderProgramModelBase->release();
+
+	glDisable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
+
+	m_modelTimer.end();
+	m_renderQueue.end();
 
 	viewer()->scene()->model()->vertexArray().unbind();
 
@@ -466,9 +1113,408 @@ void ModelRenderer::display()
 	// Restore OpenGL state (disabled to to issues with some Intel drivers)
 	// currentState->apply();
 
+	const std::chrono::duration<double, std::milli> cpuTime = std::chrono::steady_clock::now() - startTime;
+	m_cpuFrameTime = m_cpuFrameTime * 0.95 + cpuTime.count() * 0.05;
+
+	if (benchmarkFrameMeasured)
+		m_benchmarkCpuTime += cpuTime.count();
+
+}
+
+
+
+void ModelRenderer::setLegacyUniforms(Program* program, const FrameUniforms& frameUniforms)
+{
+	mat3 normalMatrix;
+
+	for (int i = 0; i < 3; i++)
+		normalMatrix[i] = vec3(frameUniforms.normalMatrix[i]);
+
+	program->setUniform("modelViewProjectionMatrix", frameUniforms.modelViewProjectionMatrix);
+	program->setUniform("modelViewMatrix", frameUniforms.modelViewMatrix);
+	program->setUniform("viewMatrix", frameUniforms.viewMatrix);
+	program->setUniform("modelLightMatrix", frameUniforms.modelLightMatrix);
+	program->setUniform("normalMatrix", normalMatrix);
+	program->setUniform("worldCameraPosition", frameUniforms.worldCameraPosition);
+	program->setUniform("explosion", frameUniforms.explosion);
+	program->setUniform("worldLightPosition", frameUniforms.worldLightPosition);
+	program->setUniform("refractionRatio", frameUniforms.refractionRatio);
+	program->setUniform("centerModel", frameUniforms.centerModel);
+	program->setUniform("specularExponent", frameUniforms.specularExponent);
+	program->setUniform("positionOffset", frameUniforms.positionOffset);
+	program->setUniform("positionScale", frameUniforms.positionScale);
+	program->setUniform("wireframeLineColor", frameUniforms.wireframeLineColor);
+	program->setUniform("ambientColor", frameUniforms.ambientColor);
+	program->setUniform("diffuseColor", frameUniforms.diffuseColor);
+	program->setUniform("specularColor", frameUniforms.specularColor);
+	program->setUniform("viewportSize", frameUniforms.viewportSize);
+	program->setUniform("ambientIntensity", frameUniforms.ambientIntensity);
+	program->setUniform("diffuseIntensity", frameUniforms.diffuseIntensity);
+	program->setUniform("specularIntensity", frameUniforms.specularIntensity);
+	program->setUniform("A", frameUniforms.A);
+	program->setUniform("k", frameUniforms.k);
+	program->setUniform("blinnPhong", frameUniforms.blinnPhong != 0);
+	program->setUniform("toonShading", frameUniforms.toonShading != 0);
+	program->setUniform("procedualBumpMap", frameUniforms.procedualBumpMap != 0);
+	program->setUniform("reflectionBool", frameUniforms.reflectionBool != 0);
+	program->setUniform("onlyReflection", frameUniforms.onlyReflection != 0);
+	program->setUniform("ambientReflection", frameUniforms.ambientReflection != 0);
+	program->setUniform("refractionBool", frameUniforms.refractionBool != 0);
+	program->setUniform("cameraExplosion", frameUniforms.cameraExplosion != 0);
+	program->setUniform("diffuseTexBool", frameUniforms.diffuseTexBool != 0);
+	program->setUniform("ambientTexBool", frameUniforms.ambientTexBool != 0);
+	program->setUniform("specularTexBool", frameUniforms.specularTexBool != 0);
+	program->setUniform("normalTexBool", frameUniforms.normalTexBool != 0);
+	program->setUniform("tangentTexBool", frameUniforms.tangentTexBool != 0);
+}
+
+void ModelRenderer::updateMaterialData(const std::vector<Material>& materials)
+{
+	if (materials.size() > maximumMaterialCount && !m_materialDataValid)
+		globjects::debug() << "The model has more than " << maximumMaterialCount << " materials, the remaining ones sample all enabled textures.";
+
+	std::vector<MaterialData> materialData(std::min(materials.size(), maximumMaterialCount));
+
+	for (std::size_t i = 0; i < materialData.size(); i++)
+	{
+		const Material& material = materials[i];
+		uint textureMask = 0;
+
+		if (material.diffuseTexture)
+			textureMask |= MaterialData::DiffuseTexture;
+		if (material.ambientTexture)
+			textureMask |= MaterialData::AmbientTexture;
+		if (material.specularTexture)
+			textureMask |= MaterialData::SpecularTexture;
+		if (material.normalTexture)
+			textureMask |= MaterialData::NormalTexture;
+		if (material.tangentTexture)
+			textureMask |= MaterialData::TangentTexture;
+
+		materialData[i].textureMask = textureMask;
+	}
+
+	if (!materialData.empty())
+		m_materialData->setSubData(0, sizeof(MaterialData) * materialData.size(), materialData.data());
+
+	if (m_bindlessSupported)
+	{
+		std::vector<MaterialTextures> materialTextures(materials.size());
+
+		auto textureHandle = [](const std::shared_ptr<Texture>& texture) -> GLuint64
+		{
+			if (!texture)
+				return 0;
+
+			TextureHandle handle = texture->textureHandle();
+
+			if (!handle.isResident())
+				handle.makeResident();
+
+			return handle.handle();
+		};
+
+		// same order as the texture slots in model-base-fs.glsl
+		for (std::size_t i = 0; i < materials.size(); i++)
+		{
+			const Material& material = materials[i];
+			materialTextures[i].handles[0] = textureHandle(material.diffuseTexture);
+			materialTextures[i].handles[1] = textureHandle(material.ambientTexture);
+			materialTextures[i].handles[2] = textureHandle(material.specularTexture);
+			materialTextures[i].handles[3] = textureHandle(material.normalTexture);
+			materialTextures[i].handles[4] = textureHandle(material.tangentTexture);
+		}
+
+		if (!materialTextures.empty())
+			m_materialTextures->setData(materialTextures, GL_DYNAMIC_DRAW);
+	}
+
+	m_renderQueue.setMaterials(materials);
+	m_materialDataValid = true;
+}
+
+void ModelRenderer::createDrawCommands(const Model& model)
+{
+	const std::vector<Group>& groups = model.groups();
+
+	// groups sharing a texture set end up next to each other, and within it the ones sharing a material
+	std::vector<uint> order = m_renderQueue.sortGroups(groups);
+
+	// a call draws indices of one type, so the groups of each texture set are split by it
+	std::stable_sort(order.begin(), order.end(), [&](uint a, uint b)
+	{
+		const uint rankA = m_bindlessSupported ? 0 : m_renderQueue.textureSetRank(groups[a].materialIndex);
+		const uint rankB = m_bindlessSupported ? 0 : m_renderQueue.textureSetRank(groups[b].materialIndex);
+		return std::make_pair(rankA, !groups[a].shortIndices) < std::make_pair(rankB, !groups[b].shortIndices);
+	});
+
+	std::vector<DrawCommand>& commands = m_commands;
+	commands.resize(groups.size());
+	std::vector<GroupData> groupData(groups.size());
+	std::vector<LodData> lodData;
+	m_groupCommands.resize(groups.size());
+	m_commandGroups = order;
+	m_drawBatches.clear();
+
+	for (uint c = 0; c < order.size(); c++)
+	{
+		const Group& group = groups[order[c]];
+
+		commands[c].count = model.indexCount(group, group.startIndex, group.endIndex);
+		commands[c].instanceCount = 1;
+		commands[c].firstIndex = uint(model.indexOffset(group, group.startIndex) / group.indexSize());
+		commands[c].baseVertex = group.baseVertex;
+		commands[c].baseInstance = c;
+
+		m_groupCommands[order[c]] = c;
+
+		// the shaders read the material index per command, so only the textures split batches
+		const bool newBatch = m_drawBatches.empty() || m_drawBatches.back().indexType != group.indexType() || (!m_bindlessSupported && m_renderQueue.textureSetRank(m_drawBatches.back().materialIndex) != m_renderQueue.textureSetRank(group.materialIndex));
+
+		if (newBatch)
+			m_drawBatches.push_back({ group.materialIndex, c, 0, group.indexType() });
+
+		m_drawBatches.back().commandCount++;
+
+		groupData[c].centerMass = vec4(group.centerMass, 1.0f);
+		groupData[c].minBounds = vec4(group.minBounds, 1.0f);
+		groupData[c].maxBounds = vec4(group.maxBounds, 1.0f);
+		groupData[c].materialIndex = group.materialIndex;
+		groupData[c].batchIndex = uint(m_drawBatches.size() - 1);
+		groupData[c].batchFirstCommand = m_drawBatches.back().firstCommand;
+		groupData[c].lodCount = uint(group.lods.size() + 1);
+		groupData[c].firstLod = uint(lodData.size());
+
+		for (uint l = 0; l <= group.lods.size(); l++)
+		{
+			const uint startIndex = group.lodStartIndex(l);
+			lodData.push_back({ uint(model.indexOffset(group, startIndex) / group.indexSize()), model.indexCount(group, startIndex, startIndex + group.lodIndexCount(l)), l > 0 ? group.lods[l - 1].error : 0.0f });
+		}
+	}
+
+	m_drawCommands = std::make_unique<Buffer>();
+	m_drawCommands->setStorage(commands, GL_DYNAMIC_STORAGE_BIT);
+
+	m_groupData = std::make_unique<Buffer>();
+	m_groupData->setStorage(groupData, GL_NONE_BIT);
+
+	m_lodData = std::make_unique<Buffer>();
+	m_lodData->setStorage(lodData, GL_NONE_BIT);
+
+	// only written by the culling compute shader
+	m_culledCommands = std::make_unique<Buffer>();
+	m_culledCommands->setStorage(sizeof(DrawCommand) * commands.size(), nullptr, GL_NONE_BIT);
+
+	m_drawCounts = std::make_unique<Buffer>();
+	m_drawCounts->setStorage(sizeof(uint) * m_drawBatches.size(), nullptr, GL_NONE_BIT);
+
+	// with cluster culling, each group needs at most one command per cluster
+	std::size_t clusterCommandCount = 0;
+	bool clustersAvailable = false;
+
+	for (const Group& group : groups)
+	{
+		clusterCommandCount += std::max<std::size_t>(group.clusterCount, 1);
+		clustersAvailable = clustersAvailable || group.clusterCount > 0;
+	}
+
+	if (clustersAvailable)
+	{
+		m_clusterCommands = std::make_unique<Buffer>();
+		m_clusterCommands->setStorage(sizeof(DrawCommand) * clusterCommandCount, nullptr, GL_DYNAMIC_STORAGE_BIT);
+		m_clusterCommandData.reserve(clusterCommandCount);
+	}
+
+	globjects::debug() << "Created " << commands.size() << " draw commands in " << m_drawBatches.size() << " batches";
+}
+
+void ModelRenderer::updateDrawCommands(const Model& model, const std::vector<bool>& groupEnabled)
+{
+	const std::vector<Group>& groups = model.groups();
+	std::size_t firstChanged = m_commands.size();
+	std::size_t lastChanged = 0;
+
+	for (std::size_t i = 0; i < m_groupCommands.size(); i++)
+	{
+		const uint c = m_groupCommands[i];
+		const uint instanceCount = (groupEnabled.at(i) && m_groupVisible.at(i)) ? 1 : 0;
+		const uint firstIndex = uint(model.indexOffset(groups[i], groups[i].lodStartIndex(m_groupLods.at(i))) / groups[i].indexSize());
+		const uint count = model.indexCount(groups[i], groups[i].lodStartIndex(m_groupLods.at(i)), groups[i].lodStartIndex(m_groupLods.at(i)) + groups[i].lodIndexCount(m_groupLods.at(i)));
+
+		if (m_commands[c].instanceCount != instanceCount || m_commands[c].firstIndex != firstIndex || m_commands[c].count != count)
+		{
+			m_commands[c].instanceCount = instanceCount;
+			m_commands[c].firstIndex = firstIndex;
+			m_commands[c].count = count;
+			firstChanged = std::min<std::size_t>(firstChanged, c);
+			lastChanged = std::max<std::size_t>(lastChanged, c);
+		}
+	}
+
+	// a camera movement usually changes a few runs of commands, so only the range spanning them is written
+	if (firstChanged <= lastChanged)
+		m_drawCommands->setSubData(sizeof(DrawCommand) * firstChanged, sizeof(DrawCommand) * (lastChanged - firstChanged + 1), &m_commands[firstChanged]);
+}
+
+void ModelRenderer::selectLods(const std::vector<Group>& groups, const vec3& cameraPosition, const vec3& centerModel, float lodScale)
+{
+	m_groupLods.assign(groups.size(), 0);
+
+	if (lodScale <= 0.0f)
+		return;
+
+	for (std::size_t i = 0; i < groups.size(); i++)
+	{
+		const Group& group = groups[i];
+
+		if (group.lods.empty())
+			continue;
+
+		// the box moves with the explosion, as in the culling
+		const vec3 center = (group.maxBounds + group.minBounds) * 0.5f + (group.centerMass - centerModel) * m_explosionScales[i];
+		const vec3 extent = (group.maxBounds - group.minBounds) * 0.5f;
+		const float distance = length(max(abs(cameraPosition - center) - extent, vec3(0.0f)));
+
+		// the errors increase with the level
+		for (uint l = 0; l < group.lods.size() && group.lods[l].error * lodScale <= distance; l++)
+			m_groupLods[i] = l + 1;
+	}
+}
+
+void ModelRenderer::cullClusters(const Model& model, const std::vector<bool>& groupEnabled, const mat4& modelViewProjection, const vec3& cameraPosition, const vec3& centerModel, bool frustumCulling, bool coneCulling)
+{
+	const std::vector<Group>& groups = model.groups();
+	const std::vector<Cluster>& clusters = model.clusters();
+
+	if (m_clusterCuller.groupCount() != clusters.size())
+		m_clusterCuller.setClusters(groups, clusters);
+
+	// the clusters move with the explosion of their group
+	m_clusterScales.resize(clusters.size());
+
+	for (std::size_t i = 0; i < groups.size(); i++)
+		std::fill_n(m_clusterScales.begin() + groups[i].firstCluster, groups[i].clusterCount, m_explosionScales[i]);
+
+	if (frustumCulling)
+		m_clusterCuller.cull(modelViewProjection, centerModel, m_clusterScales, m_clusterVisible);
+	else
+		m_clusterVisible.assign(clusters.size(), 1);
+
+	m_groupClustered.assign(groups.size(), 0);
+	m_groupRuns.resize(groups.size() + 1);
+	m_runs.clear();
+	m_culledClusterCount = 0;
+
+	for (std::size_t i = 0; i < groups.size(); i++)
+	{
+		const Group& group = groups[i];
+		m_groupRuns[i] = uint(m_runs.size());
+
+		// the clusters only partition the full group
+		if (!groupEnabled.at(i) || !m_groupVisible[i] || m_groupLods[i] > 0 || group.clusterCount == 0)
+			continue;
+
+		m_groupClustered[i] = 1;
+
+		for (uint c = group.firstCluster; c < group.firstCluster + group.clusterCount; c++)
+		{
+			const Cluster& cluster = clusters[c];
+			bool visible = m_clusterVisible[c] != 0;
+
+			// the cluster faces away if the camera lies within the cone opposite its normals, which is widened by the
+			// bounding sphere of the box
+			if (visible && coneCulling)
+			{
+				const vec3 center = (cluster.maxBounds + cluster.minBounds) * 0.5f + (group.centerMass - centerModel) * m_clusterScales[c];
+				const float radius = length(cluster.maxBounds - cluster.minBounds) * 0.5f;
+				const vec3 direction = center - cameraPosition;
+
+				visible = dot(direction, cluster.coneAxis) < cluster.coneCutoff * length(direction) + radius;
+			}
+
+			if (!visible)
+			{
+				m_culledClusterCount++;
+				continue;
+			}
+
+			// clusters are contiguous in the index buffer, so adjacent remaining ones are drawn as a single range
+			if (m_runs.size() > m_groupRuns[i] && m_runs.back().y == cluster.startIndex)
+				m_runs.back().y = cluster.endIndex;
+			else
+				m_runs.push_back(uvec2(cluster.startIndex, cluster.endIndex));
+		}
+	}
+
+	m_groupRuns[groups.size()] = uint(m_runs.size());
+
+	// the ranges in the index buffer differ from those in the list for strips
+	m_runCounts.resize(m_runs.size());
+	m_runOffsets.resize(m_runs.size());
+	m_runBaseVertices.resize(m_runs.size());
+
+	for (std::size_t i = 0; i < groups.size(); i++)
+	{
+		for (uint r = m_groupRuns[i]; r < m_groupRuns[i + 1]; r++)
+		{
+			m_runCounts[r] = GLsizei(model.indexCount(groups[i], m_runs[r].x, m_runs[r].y));
+			m_runOffsets[r] = reinterpret_cast<const void*>(model.indexOffset(groups[i], m_runs[r].x));
+			m_runBaseVertices[r] = GLint(groups[i].baseVertex);
+		}
+	}
 }
 
+void ModelRenderer::setTriangleStrips(bool triangleStrips)
+{
+	Model& model = *viewer()->scene()->model();
+	model.setTriangleStrips(triangleStrips);
+
+	if (m_multiDrawSupported)
+		createDrawCommands(model);
 
+	m_groupEnabledChanged = true;
+}
+
+void ModelRenderer::updateClusterCommands()
+{
+	m_clusterCommandData.clear();
+	m_clusterBatches.clear();
+
+	for (const DrawBatch& batch : m_drawBatches)
+	{
+		DrawBatch clusterBatch = { batch.materialIndex, uint(m_clusterCommandData.size()), 0, batch.indexType };
+
+		for (uint c = batch.firstCommand; c < batch.firstCommand + batch.commandCount; c++)
+		{
+			const uint groupIndex = m_commandGroups[c];
+
+			if (!m_groupClustered[groupIndex])
+			{
+				if (m_commands[c].instanceCount > 0)
+					m_clusterCommandData.push_back(m_commands[c]);
+
+				continue;
+			}
+
+			// the base instance still selects the data of the group's command
+			const uint indexSize = batch.indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+
+			for (uint r = m_groupRuns[groupIndex]; r < m_groupRuns[groupIndex + 1]; r++)
+			{
+				const uint firstIndex = uint(reinterpret_cast<std::uintptr_t>(m_runOffsets[r]) / indexSize);
+				m_clusterCommandData.push_back({ uint(m_runCounts[r]), 1, firstIndex, m_commands[c].baseVertex, c });
+			}
+		}
+
+		clusterBatch.commandCount = uint(m_clusterCommandData.size()) - clusterBatch.firstCommand;
+
+		if (clusterBatch.commandCount > 0)
+			m_clusterBatches.push_back(clusterBatch);
+	}
+
+	if (!m_clusterCommandData.empty())
+		m_clusterCommands->setSubData(0, sizeof(DrawCommand) * m_clusterCommandData.size(), m_clusterCommandData.data());
+}
 
 vec3 minity::ModelRenderer::catmullRom(float t, vec3 p0, vec3 p1, vec3 p2, vec3 p3) {
 	float t2 = pow(t, 2);
@@ -492,7 +1538,172 @@ quat minity::ModelRenderer::catmullRom(float t, quat p0, quat p1, quat p2, quat
 		) * 0.5f;
 }
 
+void ModelRenderer::cullOnGpu(bool occlusionCulling, float lodScale)
+{
+	auto shaderProgramCull = shaderProgram("model-cull");
+
+	if (m_indirectCountSupported)
+		m_drawCounts->clearData(GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
 
+	shaderProgramCull->setUniform("commandCount", uint(m_commands.size()));
+	shaderProgramCull->setUniform("compactCommands", m_indirectCountSupported);
+	shaderProgramCull->setUniform("occlusionCulling", occlusionCulling);
+	shaderProgramCull->setUniform("lodScale", lodScale);
+
+	if (occlusionCulling)
+	{
+		shaderProgramCull->setUniform("depthPyramidSize", vec2(m_depthPyramidSize));
+		shaderProgramCull->setUniform("previousModelViewProjectionMatrix", m_previousModelViewProjection);
+		m_depthPyramid->bindActive(5);
+	}
 
+	m_drawCommands->bindBase(GL_SHADER_STORAGE_BUFFER, 2);
+	m_culledCommands->bindBase(GL_SHADER_STORAGE_BUFFER, 3);
+	m_drawCounts->bindBase(GL_SHADER_STORAGE_BUFFER, 4);
+	m_lodData->bindBase(GL_SHADER_STORAGE_BUFFER, 5);
 
+	shaderProgramCull->use();
+	glDispatchCompute(GLuint((m_commands.size() + 63) / 64), 1, 1);
+	shaderProgramCull->release();
 
+	// the commands and counts are consumed by the following indirect draws
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+	if (occlusionCulling)
+		m_depthPyramid->unbindActive(5);
+}
+
+void ModelRenderer::updateDepthPyramid(const std::function<void()>& drawDepth)
+{
+	const ivec2 size = ivec2(viewer()->viewportSize());
+
+	if (size.x <= 0 || size.y <= 0)
+		return;
+
+	if (size != m_depthPyramidSize)
+	{
+		m_depthPyramidSize = size;
+		m_depthPyramidLevels = int(std::floor(std::log2(float(std::max(size.x, size.y))))) + 1;
+
+		m_depthTexture = Texture::create(GL_TEXTURE_2D);
+		m_depthTexture->setParameter(GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		m_depthTexture->setParameter(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		m_depthTexture->storage2D(1, GL_DEPTH_COMPONENT32F, size);
+
+		m_depthFramebuffer = Framebuffer::create();
+		m_depthFramebuffer->attachTexture(GL_DEPTH_ATTACHMENT, m_depthTexture.get());
+		m_depthFramebuffer->setDrawBuffer(GL_NONE);
+
+		// sampled at the level whose texels are about as large as the screen rectangle of a box
+		m_depthPyramid = Texture::create(GL_TEXTURE_2D);
+		m_depthPyramid->setParameter(GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+		m_depthPyramid->setParameter(GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		m_depthPyramid->setParameter(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		m_depthPyramid->setParameter(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		m_depthPyramid->storage2D(m_depthPyramidLevels, GL_R32F, size);
+	}
+
+	// the depth of the drawn groups at full resolution, which keeps the pyramid conservative at silhouettes
+	m_depthFramebuffer->bind();
+	glClear(GL_DEPTH_BUFFER_BIT);
+	drawDepth();
+	m_depthFramebuffer->unbind();
+
+	auto shaderProgramPyramid = shaderProgram("model-depth-pyramid");
+	shaderProgramPyramid->use();
+	m_depthTexture->bindActive(5);
+
+	for (int level = 0; level < m_depthPyramidLevels; level++)
+	{
+		const ivec2 levelSize = max(size >> level, ivec2(1));
+
+		shaderProgramPyramid->setUniform("firstLevel", level == 0);
+		m_depthPyramid->bindImageTexture(0, std::max(level - 1, 0), GL_FALSE, 0, GL_READ_ONLY, GL_R32F);
+		m_depthPyramid->bindImageTexture(1, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+		glDispatchCompute(GLuint((levelSize.x + 7) / 8), GLuint((levelSize.y + 7) / 8), 1);
+		glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+	}
+
+	m_depthTexture->unbindActive(5);
+	shaderProgramPyramid->release();
+
+	m_depthPyramidValid = true;
+}
+
+void ModelRenderer::collectOcclusionQueries(std::size_t groupCount)
+{
+	if (m_occlusionQueries.size() != groupCount)
+	{
+		m_occlusionQueries.clear();
+		m_occlusionQueries.resize(groupCount);
+		m_queryPending.assign(groupCount, 0);
+		m_groupOccluded.assign(groupCount, 0);
+	}
+
+	for (std::size_t i = 0; i < groupCount; i++)
+	{
+		if (m_queryPending[i] && m_occlusionQueries[i]->resultAvailable())
+		{
+			const GLuint anySamplesPassed = m_occlusionQueries[i]->get(GL_QUERY_RESULT);
+			m_groupOccluded[i] = anySamplesPassed ? 0 : 1;
+			m_queryPending[i] = 0;
+		}
+	}
+}
+
+void ModelRenderer::issueOcclusionQueries(const std::vector<Group>& groups, const std::vector<bool>& groupEnabled, const mat4& modelViewProjection, const vec3& centerModel, const vec3& cameraPosition, float nearMargin)
+{
+	auto shaderProgramOcclusion = shaderProgram("model-occlusion");
+
+	// the proxies only test the depth buffer, and pass at the surfaces of flat groups lying on their box
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_FALSE);
+	glDepthFunc(GL_LEQUAL);
+
+	m_box.bind();
+	m_renderQueue.useProgram(shaderProgramOcclusion);
+
+	for (std::size_t i = 0; i < groups.size(); i++)
+	{
+		// groups that left the frustum are drawn when they return, until a new result arrives
+		if (!groupEnabled.at(i) || !m_groupVisible[i])
+		{
+			m_groupOccluded[i] = 0;
+			continue;
+		}
+
+		// a query whose result is still in flight is not restarted, which would discard it
+		if (m_queryPending[i])
+			continue;
+
+		const Group& group = groups[i];
+		const vec3 center = (group.maxBounds + group.minBounds) * 0.5f + (group.centerMass - centerModel) * m_explosionScales[i];
+		const vec3 extent = (group.maxBounds - group.minBounds) * 0.5f;
+
+		if (all(lessThanEqual(abs(cameraPosition - center), extent + vec3(nearMargin))))
+		{
+			m_groupOccluded[i] = 0;
+			continue;
+		}
+
+		if (!m_occlusionQueries[i])
+			m_occlusionQueries[i] = Query::create();
+
+		// slightly enlarged, so that the box does not lie exactly on the faces of the group
+		const mat4 boxTransform = translate(mat4(1.0f), center) * scale(mat4(1.0f), extent * 1.001f + vec3(1e-6f));
+		m_renderQueue.setUniform("modelViewProjectionMatrix", modelViewProjection * boxTransform);
+
+		m_occlusionQueries[i]->begin(GL_ANY_SAMPLES_PASSED);
+		m_box.drawTriangles();
+		m_occlusionQueries[i]->end(GL_ANY_SAMPLES_PASSED);
+
+		m_queryPending[i] = 1;
+	}
+
+	m_box.unbind();
+
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LESS);
+}
@@ -1,6 +1,11 @@
 #pragma once
 #include "Renderer.h"
 #include "Viewer.h"
+#include "RenderQueue.h"
+#include "FrustumCuller.h"
+#include "BoxGeometry.h"
+#include "GpuTimer.h"
+#include <functional>
 #include <memory>
 
 #include <glm/glm.hpp>
@@ -19,11 +24,16 @@
 #include <globjects/base/File.h>
 #include <globjects/TextureHandle.h>
 #include <globjects/NamedString.h>
+#include <globjects/Query.h>
 #include <globjects/base/StaticStringSource.h>
 
 namespace minity
 {
 	class Viewer;
+	class Model;
+	struct Group;
+	struct Cluster;
+	struct Material;
 
 	class ModelRenderer : public Renderer
 	{
@@ -33,8 +43,259 @@ namespace minity
 		glm::vec3 catmullRom(float t, glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, glm::vec3 p3);
 		glm::quat catmullRom(float t, glm::quat p0, glm::quat p1, glm::quat p2, glm::quat p3);
 	private:
+		// per-frame state of the model shaders, std140 layout of frameBlock in model-blocks.glsl
+		struct FrameUniforms
+		{
+			glm::mat4 modelViewProjectionMatrix;
+			glm::mat4 modelViewMatrix;
+			glm::mat4 viewMatrix;
+			glm::mat4 modelLightMatrix;
+			// the columns of a mat3 are padded to four components
+			glm::vec4 normalMatrix[3];
+			glm::vec3 worldCameraPosition;
+			float explosion;
+			glm::vec3 worldLightPosition;
+			float refractionRatio;
+			glm::vec3 centerModel;
+			float specularExponent;
+			glm::vec3 positionOffset;
+			float padding0;
+			glm::vec3 positionScale;
+			float padding1;
+			glm::vec4 wireframeLineColor;
+			glm::vec4 ambientColor;
+			glm::vec4 diffuseColor;
+			glm::vec4 specularColor;
+			glm::vec2 viewportSize;
+			float ambientIntensity;
+			float diffuseIntensity;
+			float specularIntensity;
+			float A;
+			float k;
+			glm::uint blinnPhong;
+			glm::uint toonShading;
+			glm::uint procedualBumpMap;
+			glm::uint reflectionBool;
+			glm::uint onlyReflection;
+			glm::uint ambientReflection;
+			glm::uint refractionBool;
+			glm::uint cameraExplosion;
+			glm::uint diffuseTexBool;
+			glm::uint ambientTexBool;
+			glm::uint specularTexBool;
+			glm::uint normalTexBool;
+			glm::uint tangentTexBool;
+		};
+
+		// per-material state, std140 layout of materialBlock in model-blocks.glsl
+		struct MaterialData
+		{
+			enum TextureBit : glm::uint
+			{
+				DiffuseTexture = 1,
+				AmbientTexture = 2,
+				SpecularTexture = 4,
+				NormalTexture = 8,
+				TangentTexture = 16
+			};
+
+			glm::uint textureMask;
+			glm::uint padding[3];
+		};
+
+		// bindless handles of the textures of a material, std430 layout of materialTextureBuffer in model-textures-bindless-fs.glsl
+		struct MaterialTextures
+		{
+			gl::GLuint64 handles[5];
+		};
+
+		static const std::size_t maximumMaterialCount = 1024;
+
+		// writes the texture masks (and bindless handles) of the materials, called whenever their textures change
+		void updateMaterialData(const std::vector<Material>& materials);
+
+		// sets the per-frame state uniform by uniform on a program built with LEGACY_UNIFORMS, as before the uniform buffer
+		static void setLegacyUniforms(globjects::Program* program, const FrameUniforms& frameUniforms);
+
+		// layout of GL_DRAW_INDIRECT_BUFFER entries for glMultiDrawElementsIndirect
+		struct DrawCommand
+		{
+			glm::uint count;
+			glm::uint instanceCount;
+			glm::uint firstIndex;
+			glm::uint baseVertex;
+			glm::uint baseInstance;
+		};
+
+		// per-command group data read by the batch vertex shader through the base instance and by the culling
+		// compute shader, std430 layout of groupBuffer in model-groups.glsl
+		struct GroupData
+		{
+			glm::vec4 centerMass;
+			glm::vec4 minBounds;
+			glm::vec4 maxBounds;
+			glm::uint materialIndex;
+			glm::uint batchIndex;
+			glm::uint batchFirstCommand;
+			glm::uint lodCount;
+			glm::uint firstLod;
+			glm::uint padding[3];
+		};
+
+		// index ranges of the levels of detail of all commands, the first one of each command is the full group, std430
+		// layout of lodBuffer in model-cull-cs.glsl
+		struct LodData
+		{
+			glm::uint firstIndex;
+			glm::uint count;
+			float error;
+		};
+
+		// consecutive commands of groups sharing a texture set and index type, which are drawn with a single call -- the
+		// textures are bound from the material of the first command, and with bindless textures there is only one batch
+		// per index type
+		struct DrawBatch
+		{
+			glm::uint materialIndex;
+			glm::uint firstCommand;
+			glm::uint commandCount;
+			gl::GLenum indexType;
+		};
+
+		// builds one command per group, sorted by texture set, index type and material, in the indirect and group buffers
+		void createDrawCommands(const Model& model);
+		// sets the instance counts of the commands to zero for groups that are disabled or culled and the index ranges
+		// to the selected levels of detail, and uploads the changes
+		void updateDrawCommands(const Model& model, const std::vector<bool>& groupEnabled);
+
+		// selects for each group the coarsest level of detail whose error, multiplied by lodScale, is at most the distance
+		// of the camera to the group's box -- a scale of zero selects the full groups
+		void selectLods(const std::vector<Group>& groups, const glm::vec3& cameraPosition, const glm::vec3& centerModel, float lodScale);
+
+		// tests the clusters of the drawn groups at full detail against the frustum, unless frustumCulling is off, and
+		// optionally against their normal cones, and collects the remaining ones as index ranges per group, merging
+		// adjacent clusters -- other groups are still drawn as a whole
+		void cullClusters(const Model& model, const std::vector<bool>& groupEnabled, const glm::mat4& modelViewProjection, const glm::vec3& cameraPosition, const glm::vec3& centerModel, bool frustumCulling, bool coneCulling);
+		// replaces the commands of the clustered groups by one command per index range, and uploads the result
+		void updateClusterCommands();
+
+		// encodes the indices of the model as strips or lists, and rebuilds the draw commands for them
+		void setTriangleStrips(bool triangleStrips);
+
+		// tests the commands against the frustum and optionally the depth pyramid in a compute shader, which writes the
+		// commands to draw and, if they are compacted, their number per batch, and selects their levels of detail like
+		// selectLods() -- nothing is read back to the CPU
+		void cullOnGpu(bool occlusionCulling, float lodScale);
+		// renders the depth of the drawn commands and reduces it to a pyramid of maximum depths for the next frame
+		void updateDepthPyramid(const std::function<void()>& drawDepth);
+
+		// reads the results of earlier occlusion queries that are available, without waiting for the others
+		void collectOcclusionQueries(std::size_t groupCount);
+		// draws the bounding boxes of the enabled groups in the frustum as query proxies against the depth of the drawn
+		// groups, whose results decide which groups are drawn in the next frames -- groups whose box is closer to the
+		// camera than nearMargin are never tested, as the near plane could cut away their proxy
+		void issueOcclusionQueries(const std::vector<Group>& groups, const std::vector<bool>& groupEnabled, const glm::mat4& modelViewProjection, const glm::vec3& centerModel, const glm::vec3& cameraPosition, float nearMargin);
+
 		std::unique_ptr<globjects::VertexArray> m_lightArray = std::make_unique<globjects::VertexArray>();
 		std::unique_ptr<globjects::Buffer> m_lightVertices = std::make_unique<globjects::Buffer>();
+
+		std::unique_ptr<globjects::Buffer> m_frameUniforms = std::make_unique<globjects::Buffer>();
+		std::unique_ptr<globjects::Buffer> m_materialData = std::make_unique<globjects::Buffer>();
+		bool m_materialDataValid = false;
+
+		// material textures are accessed through bindless handles if supported, otherwise they are bound per material
+		bool m_bindlessSupported = false;
+		std::unique_ptr<globjects::Buffer> m_materialTextures;
+
+		// draw order and bound state of the model draws, with the bind and uniform counts of the last frame
+		RenderQueue m_renderQueue;
+
+		// CPU time of display(), averaged over recent frames
+		double m_cpuFrameTime = 0.0;
+
+		// GPU time of the model passes -- a benchmark measures it and the CPU time of display() without and then with one
+		// feature of the pipeline, each after a number of warm-up frames
+		enum class Benchmark
+		{
+			None,
+			DepthPrepass,
+			GeometryShader,
+			TriangleStrips,
+			StateSorting,
+			UniformBuffers
+		};
+
+		GpuTimer m_modelTimer;
+		static const int benchmarkWarmUpFrames = 100;
+		static const int benchmarkFrames = 500;
+		Benchmark m_benchmark = Benchmark::None;
+		int m_benchmarkFrame = 0;
+		double m_benchmarkTimes[2] = {};
+		double m_benchmarkCpuTimes[2] = {};
+		// sum of the CPU times of the measured frames of the current phase
+		double m_benchmarkCpuTime = 0.0;
+		// encoding of the model before a benchmark of the triangle strips, which is restored afterwards
+		bool m_benchmarkTriangleStrips = false;
+
+		bool m_multiDrawSupported = false;
+		std::unique_ptr<globjects::Buffer> m_drawCommands;
+		std::unique_ptr<globjects::Buffer> m_groupData;
+		std::unique_ptr<globjects::Buffer> m_lodData;
+		std::vector<DrawBatch> m_drawBatches;
+		std::vector<glm::uint> m_groupCommands;
+		std::vector<DrawCommand> m_commands;
+
+		// with GL_ARB_indirect_parameters, culled commands are removed and the draw counts are taken from a buffer
+		bool m_indirectCountSupported = false;
+		bool m_groupEnabledChanged = true;
+		std::unique_ptr<globjects::Buffer> m_culledCommands;
+		std::unique_ptr<globjects::Buffer> m_drawCounts;
+
+		// maximum depth pyramid of the previous frame for occlusion culling
+		std::unique_ptr<globjects::Framebuffer> m_depthFramebuffer;
+		std::unique_ptr<globjects::Texture> m_depthTexture;
+		std::unique_ptr<globjects::Texture> m_depthPyramid;
+		glm::ivec2 m_depthPyramidSize = glm::ivec2(0);
+		int m_depthPyramidLevels = 0;
+		bool m_depthPyramidValid = false;
+		glm::mat4 m_previousModelViewProjection = glm::mat4(1.0f);
+
+		// explosion scale and frustum visibility of each group in the current frame
+		FrustumCuller m_frustumCuller;
+		std::vector<float> m_explosionScales;
+		std::vector<unsigned char> m_groupVisible;
+		std::size_t m_culledGroupCount = 0;
+
+		// selected level of detail of each group, with the triangles of the drawn groups at those levels and in full
+		std::vector<glm::uint> m_groupLods;
+		std::size_t m_lodTriangleCount = 0;
+		std::size_t m_fullTriangleCount = 0;
+
+		// frustum visibility of the clusters, and the ranges of the remaining clusters of the clustered groups in the list
+		// and in the index buffer, the ranges of group i being m_groupRuns[i] to m_groupRuns[i + 1]
+		FrustumCuller m_clusterCuller;
+		std::vector<float> m_clusterScales;
+		std::vector<unsigned char> m_clusterVisible;
+		std::size_t m_culledClusterCount = 0;
+		std::vector<unsigned char> m_groupClustered;
+		std::vector<glm::uint> m_groupRuns;
+		std::vector<glm::uvec2> m_runs;
+		std::vector<gl::GLsizei> m_runCounts;
+		std::vector<const void*> m_runOffsets;
+		std::vector<gl::GLint> m_runBaseVertices;
+
+		// commands of the batched path with the clustered groups split into their index ranges, in batches like m_drawBatches
+		std::unique_ptr<globjects::Buffer> m_clusterCommands;
+		std::vector<DrawCommand> m_clusterCommandData;
+		std::vector<DrawBatch> m_clusterBatches;
+		std::vector<glm::uint> m_commandGroups;
+
+		// occlusion queries of the per-group path, whose results are used one or more frames later to avoid stalls
+		BoxGeometry m_box;
+		std::vector< std::unique_ptr<globjects::Query> > m_occlusionQueries;
+		std::vector<unsigned char> m_queryPending;
+		std::vector<unsigned char> m_groupOccluded;
+		std::size_t m_occludedGroupCount = 0;
 	};
 
 }
\ No newline at end of file
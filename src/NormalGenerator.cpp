@@ -0,0 +1,141 @@
+#include "NormalGenerator.h"
+
+#include <algorithm>
+
+using namespace minity;
+using namespace glm;
+
+namespace
+{
+	const uint unassigned = 0xffffffffu;
+
+	// number of elements below which splitting the work is not worth the overhead
+	const std::size_t minimumRangeSize = 16384;
+}
+
+NormalGenerator::NormalGenerator(const std::vector<vec3>& positions, NormalWeighting weighting, ThreadPool& pool) : m_positions(positions), m_weighting(weighting), m_pool(pool), m_vertexIndices(positions.size(), unassigned)
+{
+
+}
+
+void NormalGenerator::generate(const std::vector<uint>& positionIndices, std::vector<vec3>& normals, std::vector<uint>& normalIndices)
+{
+	const std::size_t faceCount = positionIndices.size() / 3;
+	const std::size_t cornerCount = faceCount * 3;
+
+	// assign consecutive vertex indices in order of first use and count the corners of each vertex
+	std::vector<uint> vertexPositions;
+	std::vector<uint> cornerVertices(cornerCount);
+	std::vector<uint> offsets(1, 0);
+
+	for (std::size_t c = 0; c < cornerCount; c++)
+	{
+		uint & vertex = m_vertexIndices[positionIndices[c]];
+
+		if (vertex == unassigned)
+		{
+			vertex = uint(vertexPositions.size());
+			vertexPositions.push_back(positionIndices[c]);
+			offsets.push_back(0);
+		}
+
+		cornerVertices[c] = vertex;
+		offsets[vertex + 1]++;
+	}
+
+	const std::size_t vertexCount = vertexPositions.size();
+
+	for (std::size_t v = 0; v < vertexCount; v++)
+		offsets[v + 1] += offsets[v];
+
+	// the corners of each vertex end up in ascending order, so the sums below are independent of the thread count
+	std::vector<uint> corners(cornerCount);
+	std::vector<uint> cursors(offsets.begin(), offsets.end() - 1);
+
+	for (std::size_t c = 0; c < cornerCount; c++)
+		corners[cursors[cornerVertices[c]]++] = uint(c);
+
+	std::vector<uint>().swap(cursors);
+
+	// face normals, and corner weights for angle weighting
+	std::vector<vec3> faceNormals(faceCount);
+	std::vector<float> cornerWeights(m_weighting == NormalWeighting::Angle ? cornerCount : 0);
+
+	m_pool.parallelForRange(faceCount, minimumRangeSize, [&](std::size_t begin, std::size_t end)
+	{
+		for (std::size_t f = begin; f < end; f++)
+		{
+			const vec3 & p0 = m_positions[positionIndices[f * 3 + 0]];
+			const vec3 & p1 = m_positions[positionIndices[f * 3 + 1]];
+			const vec3 & p2 = m_positions[positionIndices[f * 3 + 2]];
+
+			faceNormals[f] = faceNormal(p0, p1, p2, m_weighting);
+
+			if (m_weighting == NormalWeighting::Angle)
+			{
+				cornerWeights[f * 3 + 0] = cornerAngle(p0, p1, p2);
+				cornerWeights[f * 3 + 1] = cornerAngle(p1, p2, p0);
+				cornerWeights[f * 3 + 2] = cornerAngle(p2, p0, p1);
+			}
+		}
+	});
+
+	// gather the normals of the adjacent faces of each vertex
+	const std::size_t normalBase = normals.size();
+	normals.resize(normalBase + vertexCount);
+
+	m_pool.parallelForRange(vertexCount, minimumRangeSize, [&](std::size_t begin, std::size_t end)
+	{
+		for (std::size_t v = begin; v < end; v++)
+		{
+			vec3 n(0.0f);
+
+			for (uint i = offsets[v]; i < offsets[v + 1]; i++)
+			{
+				const uint c = corners[i];
+
+				if (m_weighting == NormalWeighting::Angle)
+					n += faceNormals[c / 3] * cornerWeights[c];
+				else
+					n += faceNormals[c / 3];
+			}
+
+			normals[normalBase + v] = n != vec3(0.0f) ? normalize(n) : n;
+		}
+	});
+
+	normalIndices.resize(positionIndices.size());
+
+	m_pool.parallelForRange(cornerCount, minimumRangeSize, [&](std::size_t begin, std::size_t end)
+	{
+		for (std::size_t c = begin; c < end; c++)
+			normalIndices[c] = uint(normalBase) + cornerVertices[c];
+	});
+
+	for (auto p : vertexPositions)
+		m_vertexIndices[p] = unassigned;
+}
+
+vec3 NormalGenerator::faceNormal(const vec3& p0, const vec3& p1, const vec3& p2, NormalWeighting weighting)
+{
+	const vec3 a(p2 - p1);
+	const vec3 b(p0 - p1);
+	const vec3 n = cross(a, b);
+
+	// degenerate triangles do not contribute
+	if (weighting == NormalWeighting::Area || n == vec3(0.0f))
+		return n;
+
+	return normalize(n);
+}
+
+float NormalGenerator::cornerAngle(const vec3& p, const vec3& a, const vec3& b)
+{
+	const float la = length(a - p);
+	const float lb = length(b - p);
+
+	if (la == 0.0f || lb == 0.0f)
+		return 0.0f;
+
+	return acos(clamp(dot(a - p, b - p) / (la * lb), -1.0f, 1.0f));
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Model.h"
+#include "ThreadPool.h"
+
+#include <vector>
+
+namespace minity
+{
+	// Computes smooth vertex normals for triangle lists without normals. Each vertex gathers the normals of its
+	// adjacent triangles through a compressed sparse row (CSR) vertex-to-corner table, so that the accumulation
+	// needs no scattered writes and can run in parallel.
+	class NormalGenerator
+	{
+	public:
+		NormalGenerator(const std::vector<glm::vec3>& positions, NormalWeighting weighting, ThreadPool& pool);
+
+		// appends one normal per distinct position index of the triangles to normals and stores the index
+		// of the normal of every corner in normalIndices -- normals are not shared between calls
+		void generate(const std::vector<glm::uint>& positionIndices, std::vector<glm::vec3>& normals, std::vector<glm::uint>& normalIndices);
+
+		// normal of a triangle, with a length proportional to its area for area weighting, unit length otherwise, and zero if it is degenerate
+		static glm::vec3 faceNormal(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, NormalWeighting weighting);
+
+		// angle between the edges from p to a and from p to b
+		static float cornerAngle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b);
+
+	private:
+		const std::vector<glm::vec3>& m_positions;
+		NormalWeighting m_weighting;
+		ThreadPool& m_pool;
+
+		// maps position indices to the vertices of the current call, reset after each call
+		std::vector<glm::uint> m_vertexIndices;
+	};
+
+}
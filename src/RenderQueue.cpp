@@ -0,0 +1,140 @@
+#include "RenderQueue.h"
+#include "Model.h"
+
+#include <map>
+#include <numeric>
+#include <tuple>
+
+using namespace minity;
+using namespace gl;
+using namespace glm;
+using namespace globjects;
+
+void RenderQueue::setMaterials(const std::vector<Material>& materials)
+{
+	using TextureSet = std::tuple<std::string, std::string, std::string, std::string, std::string>;
+	std::map<TextureSet, uint> textureSets;
+
+	for (const Material& material : materials)
+		textureSets.emplace(TextureSet(material.diffuseTexturePath, material.ambientTexturePath, material.specularTexturePath, material.normalTexturePath, material.tangentTexturePath), 0);
+
+	uint rank = 0;
+
+	for (auto& t : textureSets)
+		t.second = rank++;
+
+	m_textureSetRanks.resize(materials.size());
+
+	for (std::size_t i = 0; i < materials.size(); i++)
+	{
+		const Material& material = materials[i];
+		m_textureSetRanks[i] = textureSets.at(TextureSet(material.diffuseTexturePath, material.ambientTexturePath, material.specularTexturePath, material.normalTexturePath, material.tangentTexturePath));
+	}
+}
+
+uint RenderQueue::textureSetRank(uint materialIndex) const
+{
+	if (materialIndex < m_textureSetRanks.size())
+		return m_textureSetRanks[materialIndex];
+
+	return uint(m_textureSetRanks.size());
+}
+
+std::vector<uint> RenderQueue::sortGroups(const std::vector<Group>& groups) const
+{
+	std::vector<uint> order(groups.size());
+	std::iota(order.begin(), order.end(), 0);
+
+	std::stable_sort(order.begin(), order.end(), [&](uint a, uint b)
+	{
+		const uint materialA = groups[a].materialIndex;
+		const uint materialB = groups[b].materialIndex;
+		return std::make_pair(textureSetRank(materialA), materialA) < std::make_pair(textureSetRank(materialB), materialB);
+	});
+
+	return order;
+}
+
+void RenderQueue::clear()
+{
+	m_items.clear();
+}
+
+void RenderQueue::submit(Program* program, uint groupIndex, uint materialIndex)
+{
+	m_items.push_back({ program, materialIndex, groupIndex });
+}
+
+void RenderQueue::sort()
+{
+	// the group index keeps the file order within a material, which makes the order deterministic
+	std::sort(m_items.begin(), m_items.end(), [&](const Item& a, const Item& b)
+	{
+		return std::make_tuple(a.program, textureSetRank(a.materialIndex), a.materialIndex, a.groupIndex) < std::make_tuple(b.program, textureSetRank(b.materialIndex), b.materialIndex, b.groupIndex);
+	});
+}
+
+const std::vector<RenderQueue::Item>& RenderQueue::items() const
+{
+	return m_items;
+}
+
+void RenderQueue::begin()
+{
+	m_program = nullptr;
+	m_textures.fill(nullptr);
+	m_uniformValues.clear();
+	m_statistics = Statistics();
+}
+
+void RenderQueue::end()
+{
+	if (m_program)
+		m_program->release();
+
+	for (uint unit = 0; unit < textureUnitCount; unit++)
+	{
+		if (m_textures[unit])
+			m_textures[unit]->unbindActive(unit);
+	}
+
+	m_program = nullptr;
+	m_textures.fill(nullptr);
+}
+
+void RenderQueue::useProgram(Program* program)
+{
+	if (program == m_program)
+		return;
+
+	program->use();
+	m_program = program;
+	m_uniformValues.clear();
+	m_statistics.programBinds++;
+}
+
+void RenderQueue::bindTexture(uint unit, Texture* texture)
+{
+	if (!texture)
+		return;
+
+	if (m_textures.at(unit) == texture)
+	{
+		m_statistics.skippedTextureBinds++;
+		return;
+	}
+
+	texture->bindActive(unit);
+	m_textures[unit] = texture;
+	m_statistics.textureBinds++;
+}
+
+void RenderQueue::countDraw()
+{
+	m_statistics.drawCalls++;
+}
+
+const RenderQueue::Statistics& RenderQueue::statistics() const
+{
+	return m_statistics;
+}
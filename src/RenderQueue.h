@@ -0,0 +1,101 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <globjects/Program.h>
+#include <globjects/Texture.h>
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace minity
+{
+	struct Group;
+	struct Material;
+
+	// Orders the group draws of a frame by program, texture set and material, and tracks the bound program,
+	// textures and uniform values so that binds and uniform writes that would not change anything are skipped.
+	class RenderQueue
+	{
+	public:
+		// counts of the current frame, or of the last one between frames
+		struct Statistics
+		{
+			glm::uint drawCalls = 0;
+			glm::uint programBinds = 0;
+			glm::uint textureBinds = 0;
+			glm::uint uniformWrites = 0;
+			glm::uint skippedTextureBinds = 0;
+			glm::uint skippedUniformWrites = 0;
+		};
+
+		struct Item
+		{
+			globjects::Program* program;
+			glm::uint materialIndex;
+			glm::uint groupIndex;
+		};
+
+		static const glm::uint textureUnitCount = 8;
+
+		// ranks the materials by their texture files, so that materials sharing all textures get the same rank
+		// -- the file names are known before the textures are loaded, so the order does not change while loading
+		void setMaterials(const std::vector<Material>& materials);
+
+		// rank of the texture set of a material, materials beyond the ones set last share the highest rank
+		glm::uint textureSetRank(glm::uint materialIndex) const;
+
+		// group indices ordered by texture set and material, groups of the same material keep their order
+		std::vector<glm::uint> sortGroups(const std::vector<Group>& groups) const;
+
+		void clear();
+		void submit(globjects::Program* program, glm::uint groupIndex, glm::uint materialIndex);
+		void sort();
+		const std::vector<Item>& items() const;
+
+		// forgets the tracked state and starts counting a new frame
+		void begin();
+		// releases the program and unbinds the textures bound through the queue
+		void end();
+
+		void useProgram(globjects::Program* program);
+		void bindTexture(glm::uint unit, globjects::Texture* texture);
+		void countDraw();
+
+		// writes a uniform of the current program unless it already has the value
+		template <typename T>
+		void setUniform(const std::string& name, const T& value);
+
+		const Statistics& statistics() const;
+
+	private:
+		std::vector<glm::uint> m_textureSetRanks;
+		std::vector<Item> m_items;
+
+		globjects::Program* m_program = nullptr;
+		std::array<globjects::Texture*, textureUnitCount> m_textures{};
+		std::unordered_map< std::string, std::vector<unsigned char> > m_uniformValues;
+
+		Statistics m_statistics;
+	};
+
+	template <typename T>
+	void RenderQueue::setUniform(const std::string& name, const T& value)
+	{
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+		std::vector<unsigned char>& cachedValue = m_uniformValues[name];
+
+		if (cachedValue.size() == sizeof(T) && std::equal(cachedValue.begin(), cachedValue.end(), bytes))
+		{
+			m_statistics.skippedUniformWrites++;
+			return;
+		}
+
+		cachedValue.assign(bytes, bytes + sizeof(T));
+		m_program->setUniform(name, value);
+		m_statistics.uniformWrites++;
+	}
+
+}
@@ -44,7 +44,7 @@ void Renderer::reloadShaders()
 	}
 }
 
-bool Renderer::createShaderProgram(const std::string & name, std::initializer_list< std::pair<GLenum, std::string> > shaders, std::initializer_list < std::string> shaderIncludes)
+bool Renderer::createShaderProgram(const std::string & name, std::initializer_list< std::pair<GLenum, std::string> > shaders, std::initializer_list < std::string> shaderIncludes, std::initializer_list< std::pair<std::string, std::string> > replacements)
 {
 	globjects::debug() << "Creating shader program " << name << " ...";
 
@@ -69,6 +69,10 @@ bool Renderer::createShaderProgram(const std::string & name, std::initializer_li
 			
 		auto file = Shader::sourceFromFile(i.second);
 		auto source = Shader::applyGlobalReplacements(file.get());
+
+		for (auto & r : replacements)
+			source->replace(r.first, r.second);
+
 		auto shader = Shader::create(i.first, source.get());
 	
 		program.m_program->attach(shader.get());
@@ -23,6 +23,7 @@
 #include <globjects/TextureHandle.h>
 #include <globjects/NamedString.h>
 #include <globjects/base/StaticStringSource.h>
+#include <globjects/base/StringTemplate.h>
 
 namespace minity
 {
@@ -48,7 +49,8 @@ namespace minity
 		virtual void reloadShaders();
 		virtual void display() = 0;
 
-		bool createShaderProgram(const std::string & name, std::initializer_list< std::pair<gl::GLenum, std::string> > shaders, std::initializer_list < std::string> shaderIncludes = {});
+		// the replacements are applied to the source of every shader, e.g., to add a define before an include
+		bool createShaderProgram(const std::string & name, std::initializer_list< std::pair<gl::GLenum, std::string> > shaders, std::initializer_list < std::string> shaderIncludes = {}, std::initializer_list< std::pair<std::string, std::string> > replacements = {});
 		globjects::Program* shaderProgram(const std::string & name);
 
 	private:
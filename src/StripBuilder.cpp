@@ -0,0 +1,135 @@
+#include "StripBuilder.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+using namespace minity;
+using namespace glm;
+
+std::vector<uint> StripBuilder::build(const std::vector<Group>& groups, const std::vector<Cluster>& clusters, const uint* indices, std::size_t indexCount, std::vector<uvec2>& positions)
+{
+	std::vector<uvec2> ranges;
+
+	for (const Group& group : groups)
+	{
+		if (group.clusterCount > 0)
+		{
+			for (uint c = group.firstCluster; c < group.firstCluster + group.clusterCount; c++)
+				ranges.push_back(uvec2(clusters[c].startIndex, clusters[c].endIndex));
+		}
+		else
+		{
+			ranges.push_back(uvec2(group.startIndex, group.endIndex));
+		}
+
+		for (const GroupLod& lod : group.lods)
+			ranges.push_back(uvec2(lod.startIndex, lod.endIndex));
+	}
+
+	// the strips keep the order of the list, so that the 16 bit indices of IndexPacker stay in front
+	std::sort(ranges.begin(), ranges.end(), [](const uvec2& a, const uvec2& b) { return a.x < b.x; });
+
+	std::vector<uint> strips;
+	strips.reserve(indexCount);
+	positions.clear();
+
+	for (const uvec2& range : ranges)
+	{
+		positions.push_back(uvec2(range.x, uint(strips.size())));
+		stripify(indices + range.x, range.y - range.x, strips);
+		positions.push_back(uvec2(range.y, uint(strips.size())));
+	}
+
+	// the end of a range is usually the start of the next one
+	positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+
+	return strips;
+}
+
+void StripBuilder::stripify(const uint* indices, std::size_t indexCount, std::vector<uint>& strips)
+{
+	const std::size_t triangleCount = indexCount / 3;
+
+	// the corners of all triangles by the directed edge from them to the next corner, the neighbor across an edge (a, b)
+	// with the same winding contains the edge (b, a)
+	std::vector< std::pair<std::uint64_t, uint> > edges(triangleCount * 3);
+
+	for (std::size_t c = 0; c < edges.size(); c++)
+	{
+		const std::size_t next = c - c % 3 + (c + 1) % 3;
+		edges[c] = { std::uint64_t(indices[c]) << 32 | indices[next], uint(c) };
+	}
+
+	std::sort(edges.begin(), edges.end());
+
+	std::vector<unsigned char> emitted(triangleCount, 0);
+
+	// the corner of the first remaining triangle in list order with the edge (a, b), whose third vertex is the corner
+	// before it
+	auto findNeighbor = [&](uint a, uint b, uint& corner)
+	{
+		const std::uint64_t key = std::uint64_t(a) << 32 | b;
+		auto edge = std::lower_bound(edges.begin(), edges.end(), std::make_pair(key, uint(0)));
+
+		for (; edge != edges.end() && edge->first == key; ++edge)
+		{
+			if (!emitted[edge->second / 3])
+			{
+				corner = edge->second;
+				return true;
+			}
+		}
+
+		return false;
+	};
+
+	auto thirdVertex = [&](uint corner)
+	{
+		return indices[corner - corner % 3 + (corner + 2) % 3];
+	};
+
+	for (std::size_t t = 0; t < triangleCount; t++)
+	{
+		if (emitted[t])
+			continue;
+
+		emitted[t] = 1;
+
+		// the strip starts with the rotation of the triangle that has a neighbor across its last edge
+		const uint* triangle = indices + t * 3;
+		uint rotation = 0;
+		uint corner = 0;
+
+		for (uint r = 0; r < 3; r++)
+		{
+			if (findNeighbor(triangle[(r + 2) % 3], triangle[(r + 1) % 3], corner))
+			{
+				rotation = r;
+				break;
+			}
+		}
+
+		uint x = triangle[(rotation + 1) % 3];
+		uint y = triangle[(rotation + 2) % 3];
+		strips.push_back(triangle[rotation]);
+		strips.push_back(x);
+		strips.push_back(y);
+
+		// odd triangles of a strip are drawn as (y, x, z), even ones as (x, y, z)
+		for (std::size_t k = 1;; k++)
+		{
+			if (!(k % 2 == 1 ? findNeighbor(y, x, corner) : findNeighbor(x, y, corner)))
+				break;
+
+			emitted[corner / 3] = 1;
+
+			const uint z = thirdVertex(corner);
+			strips.push_back(z);
+			x = y;
+			y = z;
+		}
+
+		strips.push_back(restartIndex);
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "Model.h"
+
+#include <vector>
+
+namespace minity
+{
+	// Converts triangle lists into triangle strips separated by the primitive restart index. A strip is continued
+	// greedily with the first remaining triangle in list order across its last edge, so the triangles keep their
+	// winding and roughly their order -- a list ordered for the vertex cache stays mostly so.
+	class StripBuilder
+	{
+	public:
+		// ends each strip, the largest 32 bit value that GL_PRIMITIVE_RESTART_FIXED_INDEX restarts at
+		static constexpr glm::uint restartIndex = 0xFFFFFFFF;
+
+		// strips of all groups, their levels of detail and clusters, each of which is stripified on its own so that it
+		// can still be drawn separately -- positions maps the start and end of each of these ranges in the list to the
+		// corresponding position in the strips, sorted by list position
+		static std::vector<glm::uint> build(const std::vector<Group>& groups, const std::vector<Cluster>& clusters, const glm::uint* indices, std::size_t indexCount, std::vector<glm::uvec2>& positions);
+
+		// appends the strips of one triangle list, each followed by the restart index
+		static void stripify(const glm::uint* indices, std::size_t indexCount, std::vector<glm::uint>& strips);
+	};
+
+}
@@ -0,0 +1,181 @@
+#include "TangentGenerator.h"
+#include "NormalGenerator.h"
+
+#include <cmath>
+#include <utility>
+
+using namespace minity;
+using namespace glm;
+
+namespace
+{
+	// number of elements below which splitting the work is not worth the overhead
+	const std::size_t minimumRangeSize = 16384;
+
+	// removes the component along the normal, returns zero if nothing is left
+	vec3 projectToTangentPlane(const vec3& v, const vec3& normal)
+	{
+		const vec3 projected = v - normal * dot(normal, v);
+		const float l = length(projected);
+		return l > 1e-20f ? projected / l : vec3(0.0f);
+	}
+
+	vec3 perpendicular(const vec3& normal)
+	{
+		if (normal == vec3(0.0f))
+			return vec3(1.0f, 0.0f, 0.0f);
+
+		const vec3 axis = std::abs(normal.x) < 0.9f ? vec3(1.0f, 0.0f, 0.0f) : vec3(0.0f, 1.0f, 0.0f);
+		return normalize(cross(normal, axis));
+	}
+
+	// twice the signed area of a triangle in texture space, negative if its texture coordinates are mirrored
+	float textureDeterminant(const Vertex& v0, const Vertex& v1, const Vertex& v2)
+	{
+		const vec2 deltaUV1 = v1.texcoord - v0.texcoord;
+		const vec2 deltaUV2 = v2.texcoord - v0.texcoord;
+		return deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y;
+	}
+}
+
+void TangentGenerator::generate(std::vector<uint>& indices, std::vector<Vertex>& vertices, ThreadPool& pool)
+{
+	const std::size_t faceCount = indices.size() / 3;
+	const std::size_t cornerCount = faceCount * 3;
+	const std::size_t vertexCount = vertices.size();
+
+	// the corners of each vertex in ascending order, so the sums below are independent of the thread count
+	std::vector<uint> offsets(vertexCount + 1, 0);
+
+	for (std::size_t c = 0; c < cornerCount; c++)
+		offsets[indices[c] + 1]++;
+
+	for (std::size_t v = 0; v < vertexCount; v++)
+		offsets[v + 1] += offsets[v];
+
+	std::vector<uint> corners(cornerCount);
+	std::vector<uint> cursors(offsets.begin(), offsets.end() - 1);
+
+	for (std::size_t c = 0; c < cornerCount; c++)
+		corners[cursors[indices[c]]++] = uint(c);
+
+	std::vector<uint>().swap(cursors);
+
+	// face tangents and bitangents, whether the texture coordinates of a face are mirrored, and the corner angles
+	// that weight the tangents
+	std::vector< std::pair<vec3, vec3> > faces(faceCount);
+	std::vector<unsigned char> mirrored(faceCount);
+	std::vector<float> cornerAngles(cornerCount);
+
+	pool.parallelForRange(faceCount, minimumRangeSize, [&](std::size_t begin, std::size_t end)
+	{
+		for (std::size_t f = begin; f < end; f++)
+		{
+			const Vertex& v0 = vertices[indices[f * 3 + 0]];
+			const Vertex& v1 = vertices[indices[f * 3 + 1]];
+			const Vertex& v2 = vertices[indices[f * 3 + 2]];
+
+			faces[f] = faceTangents(v0, v1, v2);
+			mirrored[f] = faces[f].first != vec3(0.0f) && textureDeterminant(v0, v1, v2) < 0.0f;
+			cornerAngles[f * 3 + 0] = NormalGenerator::cornerAngle(v0.position, v1.position, v2.position);
+			cornerAngles[f * 3 + 1] = NormalGenerator::cornerAngle(v1.position, v2.position, v0.position);
+			cornerAngles[f * 3 + 2] = NormalGenerator::cornerAngle(v2.position, v0.position, v1.position);
+		}
+	});
+
+	// like MikkTSpace, vertices where faces with mirrored and unmirrored texture coordinates meet (e.g., on the seam of a
+	// mirrored texture) are split, and the copy gets the mirrored faces -- otherwise their bitangents would cancel out
+	const uint unsplit = 0xffffffffu;
+	std::vector<uint> copies(vertexCount, unsplit);
+
+	for (std::size_t v = 0; v < vertexCount; v++)
+	{
+		bool unmirroredFace = false;
+		bool mirroredFace = false;
+
+		for (uint i = offsets[v]; i < offsets[v + 1]; i++)
+		{
+			const uint f = corners[i] / 3;
+
+			if (faces[f].first == vec3(0.0f))
+				continue;
+
+			if (mirrored[f])
+				mirroredFace = true;
+			else
+				unmirroredFace = true;
+		}
+
+		if (unmirroredFace && mirroredFace)
+		{
+			copies[v] = uint(vertices.size());
+			vertices.push_back(vertices[v]);
+		}
+	}
+
+	// gather the tangents of the adjacent faces of each vertex, separately for the mirrored ones of a split vertex
+	pool.parallelForRange(vertexCount, minimumRangeSize, [&](std::size_t begin, std::size_t end)
+	{
+		for (std::size_t v = begin; v < end; v++)
+		{
+			const bool split = copies[v] != unsplit;
+
+			for (int side = 0; side < (split ? 2 : 1); side++)
+			{
+				Vertex& vertex = vertices[side == 0 ? v : copies[v]];
+				vec3 tangentSum(0.0f);
+				vec3 bitangentSum(0.0f);
+
+				for (uint i = offsets[v]; i < offsets[v + 1]; i++)
+				{
+					const uint c = corners[i];
+					const std::pair<vec3, vec3>& face = faces[c / 3];
+
+					if (face.first == vec3(0.0f) || (split && mirrored[c / 3] != side))
+						continue;
+
+					tangentSum += projectToTangentPlane(face.first, vertex.normal) * cornerAngles[c];
+					bitangentSum += projectToTangentPlane(face.second, vertex.normal) * cornerAngles[c];
+				}
+
+				const vec3 normal = vertex.normal != vec3(0.0f) ? normalize(vertex.normal) : vertex.normal;
+				vec3 tangent = projectToTangentPlane(tangentSum, normal);
+
+				if (tangent == vec3(0.0f))
+					tangent = perpendicular(normal);
+
+				// mirrored texture coordinates flip the bitangent
+				const float sign = dot(cross(normal, tangent), bitangentSum) < 0.0f ? -1.0f : 1.0f;
+				vertex.tangent = vec4(tangent, sign);
+			}
+		}
+	});
+
+	// the mirrored faces of split vertices use the copies
+	pool.parallelForRange(cornerCount, minimumRangeSize, [&](std::size_t begin, std::size_t end)
+	{
+		for (std::size_t c = begin; c < end; c++)
+		{
+			if (copies[indices[c]] != unsplit && mirrored[c / 3])
+				indices[c] = copies[indices[c]];
+		}
+	});
+}
+
+std::pair<vec3, vec3> TangentGenerator::faceTangents(const Vertex& v0, const Vertex& v1, const Vertex& v2)
+{
+	const vec3 edge1 = v1.position - v0.position;
+	const vec3 edge2 = v2.position - v0.position;
+	const vec2 deltaUV1 = v1.texcoord - v0.texcoord;
+	const vec2 deltaUV2 = v2.texcoord - v0.texcoord;
+	const float determinant = deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y;
+
+	if (std::abs(determinant) < 1e-20f)
+		return { vec3(0.0f), vec3(0.0f) };
+
+	const float f = 1.0f / determinant;
+	const vec3 tangent = (edge1 * deltaUV2.y - edge2 * deltaUV1.y) * f;
+	const vec3 bitangent = (edge2 * deltaUV1.x - edge1 * deltaUV2.x) * f;
+
+	return { tangent, bitangent };
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Model.h"
+#include "ThreadPool.h"
+
+#include <utility>
+#include <vector>
+
+namespace minity
+{
+	// Computes per-vertex tangents of triangle lists from their texture coordinates, following the conventions of
+	// MikkTSpace: the tangents of the adjacent triangles are projected into the tangent plane of the vertex normal
+	// and weighted by the angle of the triangle at the vertex, and the bitangent is sign * cross(normal, tangent)
+	// with the sign in the w component. Like NormalGenerator, each vertex gathers its triangles through a vertex-to-corner
+	// table, so that the accumulation runs in parallel and in the same order as a serial one.
+	class TangentGenerator
+	{
+	public:
+		// sets the tangent of every vertex -- vertices without usable texture coordinates get an arbitrary unit
+		// vector perpendicular to their normal, so that the shaders never normalize a zero vector, and vertices shared
+		// by faces with mirrored and unmirrored texture coordinates are split into two, appended copies being used by
+		// the mirrored faces
+		static void generate(std::vector<glm::uint>& indices, std::vector<Vertex>& vertices, ThreadPool& pool);
+
+		// unnormalized tangent and bitangent of a triangle, zero if its texture coordinates are degenerate
+		static std::pair<glm::vec3, glm::vec3> faceTangents(const Vertex& v0, const Vertex& v1, const Vertex& v2);
+	};
+
+}
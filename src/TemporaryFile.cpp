@@ -0,0 +1,84 @@
+#include "TemporaryFile.h"
+
+#include <atomic>
+#include <filesystem>
+#include <random>
+
+using namespace minity;
+
+TemporaryFile::TemporaryFile(const std::string& directory)
+{
+	static std::atomic<unsigned int> counter(0);
+	std::random_device random;
+
+	// the random part avoids collisions with other instances of the program writing to the same directory
+	for (int attempt = 0; attempt < 16 && !m_stream.is_open(); attempt++)
+	{
+		std::filesystem::path path = directory.empty() ? std::filesystem::temp_directory_path() : std::filesystem::path(directory);
+		path.append("minity-" + std::to_string(random()) + "-" + std::to_string(counter++) + ".tmp");
+
+		std::error_code error;
+
+		if (std::filesystem::exists(path, error))
+			continue;
+
+		m_filename = path.string();
+		m_stream.open(m_filename, std::ios::binary | std::ios::trunc);
+	}
+}
+
+TemporaryFile::~TemporaryFile()
+{
+	m_mapping.close();
+
+	if (m_stream.is_open())
+		m_stream.close();
+
+	if (!m_filename.empty())
+	{
+		std::error_code error;
+		std::filesystem::remove(m_filename, error);
+	}
+}
+
+bool TemporaryFile::isOpen() const
+{
+	return m_stream.is_open() || m_mapping.isOpen();
+}
+
+bool TemporaryFile::good() const
+{
+	return m_mapping.isOpen() || (m_stream.is_open() && m_stream.good());
+}
+
+void TemporaryFile::write(const void* data, std::size_t size)
+{
+	m_stream.write(static_cast<const char*>(data), std::streamsize(size));
+	m_size += size;
+}
+
+std::uint64_t TemporaryFile::size() const
+{
+	return m_size;
+}
+
+bool TemporaryFile::map(bool sequential)
+{
+	if (m_mapping.isOpen())
+		return true;
+
+	if (!m_stream.is_open())
+		return false;
+
+	m_stream.close();
+
+	if (m_stream.fail())
+		return false;
+
+	return m_mapping.open(m_filename, sequential);
+}
+
+const char* TemporaryFile::data() const
+{
+	return m_mapping.data();
+}
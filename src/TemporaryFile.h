@@ -0,0 +1,50 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace minity
+{
+	// Binary file that intermediate data is written to in order to keep it out of memory. The file is
+	// written sequentially, then mapped for reading, and deleted when the object is destroyed.
+	class TemporaryFile
+	{
+	public:
+		// creates a file with a unique name in the given directory
+		TemporaryFile(const std::string& directory);
+		~TemporaryFile();
+
+		TemporaryFile(const TemporaryFile&) = delete;
+		TemporaryFile& operator=(const TemporaryFile&) = delete;
+
+		bool isOpen() const;
+		bool good() const;
+
+		void write(const void* data, std::size_t size);
+
+		template <class T>
+		void write(const std::vector<T>& elements)
+		{
+			write(elements.data(), elements.size() * sizeof(T));
+		}
+
+		// number of bytes written so far
+		std::uint64_t size() const;
+
+		// finishes writing and maps the file, after which no more data can be written
+		bool map(bool sequential = true);
+
+		const char* data() const;
+
+	private:
+		std::string m_filename;
+		std::ofstream m_stream;
+		MappedFile m_mapping;
+		std::uint64_t m_size = 0;
+	};
+
+}
@@ -0,0 +1,162 @@
+#include "TextureCache.h"
+#include "MappedFile.h"
+#include "FileUtility.h"
+
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+
+using namespace minity;
+
+namespace
+{
+	const char magic[8] = { 'T','C','A','C','H','E','\r','\n' };
+
+	struct Header
+	{
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t format;
+		std::uint32_t compressed;
+		std::uint32_t channels;
+		std::uint32_t levelCount;
+		std::uint32_t reserved;
+
+		// the image file the cache was created from
+		std::uint64_t sourceSize;
+		std::int64_t sourceTime;
+		std::uint64_t sourceHash;
+	};
+
+	struct LevelHeader
+	{
+		std::uint32_t width;
+		std::uint32_t height;
+		std::uint64_t size;
+	};
+}
+
+std::string TextureCache::cacheFilename(const std::string& filename)
+{
+	return filename + ".tcache";
+}
+
+bool TextureCache::read(const std::string& filename, bool compressed, TextureImage& image)
+{
+	MappedFile file(cacheFilename(filename));
+
+	if (!file.isOpen() || file.size() < sizeof(Header))
+		return false;
+
+	Header header;
+	memcpy(&header, file.data(), sizeof(header));
+
+	if (memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version || header.compressed != std::uint32_t(compressed))
+		return false;
+
+	if (header.format > std::uint32_t(TextureImage::Format::BC3) || header.channels < 1 || header.channels > 4 || header.levelCount == 0 || header.levelCount > 32)
+		return false;
+
+	std::error_code error;
+	const std::uint64_t size = std::filesystem::file_size(filename, error);
+
+	if (error || size != header.sourceSize)
+		return false;
+
+	if (FileUtility::fileTime(filename) != header.sourceTime)
+	{
+		MappedFile source(filename);
+
+		if (!source.isOpen() || FileUtility::hash(source.data(), source.size()) != header.sourceHash)
+			return false;
+	}
+
+	TextureImage result;
+	result.format = TextureImage::Format(header.format);
+	result.channels = int(header.channels);
+	result.levels.resize(header.levelCount);
+
+	const char* data = file.data() + sizeof(Header) + header.levelCount * sizeof(LevelHeader);
+
+	if (std::size_t(data - file.data()) > file.size())
+		return false;
+
+	for (std::uint32_t i = 0; i < header.levelCount; i++)
+	{
+		LevelHeader levelHeader;
+		memcpy(&levelHeader, file.data() + sizeof(Header) + i * sizeof(LevelHeader), sizeof(levelHeader));
+
+		const std::uint64_t expectedSize = result.format == TextureImage::Format::Uncompressed ?
+			std::uint64_t(levelHeader.width) * levelHeader.height * header.channels :
+			TextureImage::compressedSize(result.format, int(levelHeader.width), int(levelHeader.height));
+
+		if (levelHeader.size != expectedSize || levelHeader.size > std::uint64_t(file.end() - data))
+			return false;
+
+		TextureImage::Level & level = result.levels[i];
+		level.width = int(levelHeader.width);
+		level.height = int(levelHeader.height);
+		level.data.assign(data, data + levelHeader.size);
+		data += levelHeader.size;
+	}
+
+	image = std::move(result);
+	return true;
+}
+
+bool TextureCache::write(const std::string& filename, bool compressed, const TextureImage& image)
+{
+	MappedFile source(filename);
+
+	if (!source.isOpen())
+		return false;
+
+	Header header = {};
+	memcpy(header.magic, magic, sizeof(magic));
+	header.version = version;
+	header.format = std::uint32_t(image.format);
+	header.compressed = std::uint32_t(compressed);
+	header.channels = std::uint32_t(image.channels);
+	header.levelCount = std::uint32_t(image.levels.size());
+	header.sourceSize = source.size();
+	header.sourceTime = FileUtility::fileTime(filename);
+	header.sourceHash = FileUtility::hash(source.data(), source.size());
+
+	// write to a temporary file first, so that an interrupted write never leaves a truncated cache behind
+	const std::string temporaryFilename = cacheFilename(filename) + ".tmp";
+	std::ofstream os(temporaryFilename, std::ios::binary | std::ios::trunc);
+
+	if (!os.is_open())
+		return false;
+
+	os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	for (auto & l : image.levels)
+	{
+		LevelHeader levelHeader = { std::uint32_t(l.width), std::uint32_t(l.height), std::uint64_t(l.data.size()) };
+		os.write(reinterpret_cast<const char*>(&levelHeader), sizeof(levelHeader));
+	}
+
+	for (auto & l : image.levels)
+		os.write(reinterpret_cast<const char*>(l.data.data()), std::streamsize(l.data.size()));
+
+	os.close();
+
+	std::error_code error;
+
+	if (!os.good())
+	{
+		std::filesystem::remove(temporaryFilename, error);
+		return false;
+	}
+
+	std::filesystem::rename(temporaryFilename, cacheFilename(filename), error);
+
+	if (error)
+	{
+		std::filesystem::remove(temporaryFilename, error);
+		return false;
+	}
+
+	return true;
+}
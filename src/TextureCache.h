@@ -0,0 +1,23 @@
+#pragma once
+
+#include "TextureImage.h"
+
+#include <cstdint>
+#include <string>
+
+namespace minity
+{
+	// Binary cache of a decoded image with its complete mip chain, stored next to the image file (e.g., diffuse.png.tcache)
+	class TextureCache
+	{
+	public:
+		static const std::uint32_t version = 1;
+
+		static std::string cacheFilename(const std::string& filename);
+
+		// filename is the name of the image file -- reads the cached image if it was written with the same compression setting and the image file is unchanged
+		static bool read(const std::string& filename, bool compressed, TextureImage& image);
+		static bool write(const std::string& filename, bool compressed, const TextureImage& image);
+	};
+
+}
@@ -0,0 +1,317 @@
+#include "TextureImage.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+
+using namespace minity;
+
+namespace
+{
+	typedef std::array<int, 4> Color;
+
+	// source texels and weights of one axis of a mip level, two texels of half weight for even sizes and three texels
+	// weighted by their overlap with the target texel for odd sizes
+	struct MipTaps
+	{
+		int count;
+		std::array<int, 3> index;
+		std::array<float, 3> weight;
+	};
+
+	std::vector<MipTaps> mipTaps(int sourceSize, int size)
+	{
+		std::vector<MipTaps> taps(size);
+
+		for (int i = 0; i < size; i++)
+		{
+			MipTaps & t = taps[i];
+
+			if (sourceSize == 1)
+			{
+				t = MipTaps{ 1, { 0, 0, 0 }, { 1.0f, 0.0f, 0.0f } };
+			}
+			else if (sourceSize % 2 == 0)
+			{
+				t = MipTaps{ 2, { i * 2, i * 2 + 1, 0 }, { 0.5f, 0.5f, 0.0f } };
+			}
+			else
+			{
+				const float s = float(sourceSize);
+				t = MipTaps{ 3, { i * 2, i * 2 + 1, i * 2 + 2 }, { float(size - i) / s, float(size) / s, float(i + 1) / s } };
+			}
+		}
+
+		return taps;
+	}
+
+	std::uint16_t packColor565(const Color & c)
+	{
+		return std::uint16_t(((c[0] * 31 + 127) / 255) << 11 | ((c[1] * 63 + 127) / 255) << 5 | ((c[2] * 31 + 127) / 255));
+	}
+
+	Color unpackColor565(std::uint16_t c)
+	{
+		const int r = (c >> 11) & 31;
+		const int g = (c >> 5) & 63;
+		const int b = c & 31;
+		return Color{ (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2), 255 };
+	}
+
+	int colorDistance(const Color & a, const Color & b)
+	{
+		const int dr = a[0] - b[0];
+		const int dg = a[1] - b[1];
+		const int db = a[2] - b[2];
+		return dr * dr + dg * dg + db * db;
+	}
+
+	// reads a 4x4 block as RGBA, replicating the last row and column at the borders of the image
+	std::array<Color, 16> readBlock(const TextureImage::Level & level, int channels, int blockX, int blockY)
+	{
+		std::array<Color, 16> block;
+
+		for (int y = 0; y < 4; y++)
+		{
+			for (int x = 0; x < 4; x++)
+			{
+				const int px = std::min(blockX * 4 + x, level.width - 1);
+				const int py = std::min(blockY * 4 + y, level.height - 1);
+				const unsigned char* p = &level.data[(std::size_t(py) * level.width + px) * channels];
+
+				block[y * 4 + x] = Color{ p[0], p[1], p[2], channels == 4 ? p[3] : 255 };
+			}
+		}
+
+		return block;
+	}
+
+	// bounding box endpoints inset by 1/16 of the range, which reduces the error compared to the plain extremes
+	void encodeColorBlock(const std::array<Color, 16> & block, unsigned char* output)
+	{
+		Color minimum{ 255, 255, 255, 255 };
+		Color maximum{ 0, 0, 0, 0 };
+
+		for (const Color & c : block)
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				minimum[i] = std::min(minimum[i], c[i]);
+				maximum[i] = std::max(maximum[i], c[i]);
+			}
+		}
+
+		for (int i = 0; i < 3; i++)
+		{
+			const int inset = (maximum[i] - minimum[i]) / 16;
+			minimum[i] += inset;
+			maximum[i] -= inset;
+		}
+
+		// the endpoints span the diagonal of the box in direction of the channel with the largest range,
+		// so channels that decrease along it swap their minimum and maximum
+		int axis = 0;
+
+		for (int i = 1; i < 3; i++)
+		{
+			if (maximum[i] - minimum[i] > maximum[axis] - minimum[axis])
+				axis = i;
+		}
+
+		Color mean{ 0, 0, 0, 0 };
+
+		for (const Color & c : block)
+		{
+			for (int i = 0; i < 3; i++)
+				mean[i] += c[i];
+		}
+
+		for (int i = 0; i < 3; i++)
+		{
+			int covariance = 0;
+
+			for (const Color & c : block)
+				covariance += (c[i] * 16 - mean[i]) * (c[axis] * 16 - mean[axis]);
+
+			if (covariance < 0)
+				std::swap(minimum[i], maximum[i]);
+		}
+
+		std::uint16_t color0 = packColor565(maximum);
+		std::uint16_t color1 = packColor565(minimum);
+
+		// color0 > color1 selects the four color mode
+		if (color0 < color1)
+			std::swap(color0, color1);
+
+		std::uint32_t indices = 0;
+
+		if (color0 != color1)
+		{
+			const Color c0 = unpackColor565(color0);
+			const Color c1 = unpackColor565(color1);
+			Color palette[4] = { c0, c1, c0, c1 };
+
+			for (int i = 0; i < 3; i++)
+			{
+				palette[2][i] = (2 * c0[i] + c1[i]) / 3;
+				palette[3][i] = (c0[i] + 2 * c1[i]) / 3;
+			}
+
+			for (int p = 0; p < 16; p++)
+			{
+				int best = 0;
+				int bestDistance = colorDistance(block[p], palette[0]);
+
+				for (int j = 1; j < 4; j++)
+				{
+					const int distance = colorDistance(block[p], palette[j]);
+
+					if (distance < bestDistance)
+					{
+						best = j;
+						bestDistance = distance;
+					}
+				}
+
+				indices |= std::uint32_t(best) << (p * 2);
+			}
+		}
+
+		output[0] = static_cast<unsigned char>(color0 & 0xff);
+		output[1] = static_cast<unsigned char>(color0 >> 8);
+		output[2] = static_cast<unsigned char>(color1 & 0xff);
+		output[3] = static_cast<unsigned char>(color1 >> 8);
+
+		for (int i = 0; i < 4; i++)
+			output[4 + i] = static_cast<unsigned char>(indices >> (i * 8));
+	}
+
+	void encodeAlphaBlock(const std::array<Color, 16> & block, unsigned char* output)
+	{
+		int minimum = 255;
+		int maximum = 0;
+
+		for (const Color & c : block)
+		{
+			minimum = std::min(minimum, c[3]);
+			maximum = std::max(maximum, c[3]);
+		}
+
+		// alpha0 > alpha1 selects the mode with six interpolated values
+		int palette[8] = { maximum, minimum };
+
+		for (int i = 1; i < 7; i++)
+			palette[i + 1] = ((7 - i) * maximum + i * minimum) / 7;
+
+		std::uint64_t indices = 0;
+
+		if (maximum != minimum)
+		{
+			for (int p = 0; p < 16; p++)
+			{
+				int best = 0;
+
+				for (int j = 1; j < 8; j++)
+				{
+					if (std::abs(block[p][3] - palette[j]) < std::abs(block[p][3] - palette[best]))
+						best = j;
+				}
+
+				indices |= std::uint64_t(best) << (p * 3);
+			}
+		}
+
+		output[0] = static_cast<unsigned char>(maximum);
+		output[1] = static_cast<unsigned char>(minimum);
+
+		for (int i = 0; i < 6; i++)
+			output[2 + i] = static_cast<unsigned char>(indices >> (i * 8));
+	}
+}
+
+void TextureImage::generateMipmaps()
+{
+	if (format != Format::Uncompressed || levels.size() != 1)
+		return;
+
+	while (levels.back().width > 1 || levels.back().height > 1)
+	{
+		const Level & source = levels.back();
+		Level level;
+		level.width = std::max(1, source.width / 2);
+		level.height = std::max(1, source.height / 2);
+		level.data.resize(std::size_t(level.width) * level.height * channels);
+
+		const std::vector<MipTaps> columns = mipTaps(source.width, level.width);
+		const std::vector<MipTaps> rows = mipTaps(source.height, level.height);
+
+		for (int y = 0; y < level.height; y++)
+		{
+			const MipTaps & row = rows[y];
+
+			for (int x = 0; x < level.width; x++)
+			{
+				const MipTaps & column = columns[x];
+
+				for (int c = 0; c < channels; c++)
+				{
+					float sum = 0.0f;
+
+					for (int j = 0; j < row.count; j++)
+					{
+						for (int i = 0; i < column.count; i++)
+							sum += row.weight[j] * column.weight[i] * source.data[(std::size_t(row.index[j]) * source.width + column.index[i]) * channels + c];
+					}
+
+					level.data[(std::size_t(y) * level.width + x) * channels + c] = static_cast<unsigned char>(std::min(255.0f, sum + 0.5f));
+				}
+			}
+		}
+
+		levels.push_back(std::move(level));
+	}
+}
+
+void TextureImage::compress()
+{
+	if (format != Format::Uncompressed || (channels != 3 && channels != 4))
+		return;
+
+	const Format compressedFormat = channels == 4 ? Format::BC3 : Format::BC1;
+
+	for (Level & level : levels)
+	{
+		const int blocksX = (level.width + 3) / 4;
+		const int blocksY = (level.height + 3) / 4;
+		std::vector<unsigned char> data(compressedSize(compressedFormat, level.width, level.height));
+		unsigned char* output = data.data();
+
+		for (int by = 0; by < blocksY; by++)
+		{
+			for (int bx = 0; bx < blocksX; bx++)
+			{
+				const std::array<Color, 16> block = readBlock(level, channels, bx, by);
+
+				if (compressedFormat == Format::BC3)
+				{
+					encodeAlphaBlock(block, output);
+					output += 8;
+				}
+
+				encodeColorBlock(block, output);
+				output += 8;
+			}
+		}
+
+		level.data.swap(data);
+	}
+
+	format = compressedFormat;
+}
+
+std::size_t TextureImage::compressedSize(Format format, int width, int height)
+{
+	const std::size_t blockCount = std::size_t((width + 3) / 4) * std::size_t((height + 3) / 4);
+	return blockCount * (format == Format::BC3 ? 16 : 8);
+}
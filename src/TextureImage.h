@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace minity
+{
+	// Decoded image with its mip chain, either with 1-4 uncompressed 8-bit channels or block compressed
+	struct TextureImage
+	{
+		enum class Format : std::uint32_t
+		{
+			Uncompressed,
+			BC1,
+			BC3
+		};
+
+		struct Level
+		{
+			int width = 0;
+			int height = 0;
+			std::vector<unsigned char> data;
+		};
+
+		Format format = Format::Uncompressed;
+		int channels = 0;
+		std::vector<Level> levels;
+
+		// appends all mip levels down to 1x1 to an uncompressed image with a single level, using a box filter that
+		// spans three texels along odd dimensions, so that the last row and column contribute as well
+		void generateMipmaps();
+
+		// compresses all levels of an uncompressed image, with BC1 for RGB and BC3 for RGBA images -- images with one or two channels are left unchanged
+		void compress();
+
+		static std::size_t compressedSize(Format format, int width, int height);
+	};
+
+}
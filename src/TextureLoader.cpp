@@ -0,0 +1,232 @@
+#include "TextureLoader.h"
+#include "TextureCache.h"
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <globjects/globjects.h>
+#include <globjects/logging.h>
+#include <glbinding-aux/ContextInfo.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+using namespace minity;
+using namespace gl;
+using namespace glm;
+using namespace globjects;
+
+TextureLoader::TextureLoader(unsigned int threadCount) : m_pool(threadCount)
+{
+
+}
+
+TextureLoader::~TextureLoader()
+{
+	// images that have not been decoded yet are skipped
+	m_cancelled = true;
+}
+
+void TextureLoader::request(const std::string& filename, bool useCache, bool compress)
+{
+	if (m_textures.find(filename) != m_textures.end() || m_pending.find(filename) != m_pending.end())
+		return;
+
+	// without S3TC, the textures are decoded, cached and uploaded uncompressed
+	compress = compress && compressionSupported();
+
+	m_pending[filename] = m_pool.enqueue([this, filename, useCache, compress]() { return decode(filename, useCache, compress); });
+}
+
+std::size_t TextureLoader::upload(std::size_t maximumCount)
+{
+	std::size_t count = 0;
+
+	for (auto i = m_pending.begin(); i != m_pending.end() && count < maximumCount;)
+	{
+		if (i->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			i++;
+			continue;
+		}
+
+		std::unique_ptr<TextureImage> image = i->second.get();
+
+		if (image)
+		{
+			std::cout << "Loaded " << i->first << std::endl;
+			m_textures[i->first] = createTexture(*image);
+		}
+		else
+		{
+			globjects::debug() << "Could not load texture " << i->first << "!";
+			m_textures[i->first] = nullptr;
+		}
+
+		i = m_pending.erase(i);
+		count++;
+	}
+
+	return count;
+}
+
+std::shared_ptr<Texture> TextureLoader::texture(const std::string& filename) const
+{
+	auto i = m_textures.find(filename);
+
+	if (i == m_textures.end())
+		return nullptr;
+
+	return i->second;
+}
+
+std::size_t TextureLoader::pendingCount() const
+{
+	return m_pending.size();
+}
+
+std::size_t TextureLoader::textureCount() const
+{
+	std::size_t count = 0;
+
+	for (auto & t : m_textures)
+	{
+		if (t.second)
+			count++;
+	}
+
+	return count;
+}
+
+double TextureLoader::decodeTime() const
+{
+	return double(m_decodeMicroseconds) / 1000.0;
+}
+
+std::uint64_t TextureLoader::bytesRead() const
+{
+	return m_bytesRead;
+}
+
+std::unique_ptr<TextureImage> TextureLoader::decode(const std::string& filename, bool useCache, bool compress)
+{
+	if (m_cancelled)
+		return nullptr;
+
+	const auto startTime = std::chrono::steady_clock::now();
+
+	auto addStatistics = [&](const std::string& readFilename)
+	{
+		std::error_code error;
+		const std::uintmax_t size = std::filesystem::file_size(readFilename, error);
+
+		if (!error)
+			m_bytesRead += size;
+
+		m_decodeMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count();
+	};
+
+	auto image = std::make_unique<TextureImage>();
+
+	if (useCache && TextureCache::read(filename, compress, *image))
+	{
+		addStatistics(TextureCache::cacheFilename(filename));
+		return image;
+	}
+
+	int width, height, channels;
+
+	// the global flag is not thread-safe, and the skybox is loaded without flipping
+	stbi_set_flip_vertically_on_load_thread(true);
+	unsigned char* data = stbi_load(filename.c_str(), &width, &height, &channels, 0);
+
+	if (!data)
+	{
+		addStatistics(filename);
+		return nullptr;
+	}
+
+	image->channels = channels;
+	image->levels.resize(1);
+	image->levels[0].width = width;
+	image->levels[0].height = height;
+	image->levels[0].data.assign(data, data + std::size_t(width) * height * channels);
+	stbi_image_free(data);
+
+	image->generateMipmaps();
+
+	if (compress)
+		image->compress();
+
+	if (useCache && !TextureCache::write(filename, compress, *image))
+		globjects::debug() << "Could not write texture cache for " << filename << "!";
+
+	addStatistics(filename);
+	return image;
+}
+
+bool TextureLoader::compressionSupported()
+{
+	static const bool supported = []()
+	{
+		const auto extensions = glbinding::aux::ContextInfo::extensions();
+		const bool s3tc = extensions.find(GLextension::GL_EXT_texture_compression_s3tc) != extensions.end();
+
+		if (!s3tc)
+			globjects::debug() << "GL_EXT_texture_compression_s3tc is not supported, textures are not compressed.";
+
+		return s3tc;
+	}();
+
+	return supported;
+}
+
+std::unique_ptr<Texture> TextureLoader::createTexture(const TextureImage& image)
+{
+	auto texture = Texture::create(GL_TEXTURE_2D);
+	texture->setParameter(GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	texture->setParameter(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	texture->setParameter(GL_TEXTURE_WRAP_S, GL_REPEAT);
+	texture->setParameter(GL_TEXTURE_WRAP_T, GL_REPEAT);
+	texture->setParameter(GL_TEXTURE_MAX_LEVEL, GLint(image.levels.size() - 1));
+
+	GLenum format = GL_RGBA;
+
+	switch (image.channels)
+	{
+	case 1:
+		format = GL_RED;
+		break;
+
+	case 2:
+		format = GL_RG;
+		break;
+
+	case 3:
+		format = GL_RGB;
+		break;
+
+	case 4:
+		format = GL_RGBA;
+		break;
+	}
+
+	// rows of the smaller mip levels are not aligned to four bytes
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	for (std::size_t i = 0; i < image.levels.size(); i++)
+	{
+		const TextureImage::Level & level = image.levels[i];
+
+		if (image.format == TextureImage::Format::BC1)
+			texture->compressedImage2D(GLint(i), GL_COMPRESSED_RGB_S3TC_DXT1_EXT, ivec2(level.width, level.height), 0, GLsizei(level.data.size()), level.data.data());
+		else if (image.format == TextureImage::Format::BC3)
+			texture->compressedImage2D(GLint(i), GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, ivec2(level.width, level.height), 0, GLsizei(level.data.size()), level.data.data());
+		else
+			texture->image2D(GLint(i), format, ivec2(level.width, level.height), 0, format, GL_UNSIGNED_BYTE, level.data.data());
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	return texture;
+}
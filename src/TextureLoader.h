@@ -0,0 +1,62 @@
+#pragma once
+
+#include "ThreadPool.h"
+#include "TextureImage.h"
+
+#include <globjects/Texture.h>
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace minity
+{
+	// Decodes image files on a thread pool and turns them into textures. Every file is decoded only once,
+	// and the textures are shared between all materials referencing the same file.
+	class TextureLoader
+	{
+	public:
+		TextureLoader(unsigned int threadCount = 0);
+		~TextureLoader();
+
+		// starts decoding the image file in the background, unless it has been requested before -- with useCache, the
+		// decoded mip chain is read from or written to a texture cache next to the file, block compressed if requested and
+		// supported -- must be called on the GL thread
+		void request(const std::string& filename, bool useCache = true, bool compress = false);
+
+		// uploads up to maximumCount decoded images, which limits the stall per frame -- must be called on the GL thread
+		std::size_t upload(std::size_t maximumCount = 4);
+
+		// returns the texture of the file, or an empty pointer if it is still being decoded or could not be loaded
+		std::shared_ptr<globjects::Texture> texture(const std::string& filename) const;
+
+		std::size_t pendingCount() const;
+
+		// number of textures that have been uploaded successfully
+		std::size_t textureCount() const;
+
+		// decoding time summed over all threads, and bytes read from image or cache files
+		double decodeTime() const;
+		std::uint64_t bytesRead() const;
+
+	private:
+		std::unique_ptr<TextureImage> decode(const std::string& filename, bool useCache, bool compress);
+		static std::unique_ptr<globjects::Texture> createTexture(const TextureImage& image);
+
+		// whether the context supports S3TC, checked on the first call
+		static bool compressionSupported();
+
+		std::unordered_map< std::string, std::future< std::unique_ptr<TextureImage> > > m_pending;
+		std::unordered_map< std::string, std::shared_ptr<globjects::Texture> > m_textures;
+		std::atomic<bool> m_cancelled{ false };
+		std::atomic<std::uint64_t> m_decodeMicroseconds{ 0 };
+		std::atomic<std::uint64_t> m_bytesRead{ 0 };
+
+		// declared last, so that the workers are joined before the other members are destroyed
+		ThreadPool m_pool;
+	};
+
+}
@@ -0,0 +1,96 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+using namespace minity;
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+	if (threadCount == 0)
+		threadCount = hardwareThreads();
+
+	m_workers.reserve(threadCount);
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		m_workers.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+
+	m_condition.notify_all();
+
+	for (auto& w : m_workers)
+		w.join();
+}
+
+unsigned int ThreadPool::size() const
+{
+	return static_cast<unsigned int>(m_workers.size());
+}
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)>& function)
+{
+	if (count == 1 || m_workers.empty())
+	{
+		for (std::size_t i = 0; i < count; i++)
+			function(i);
+
+		return;
+	}
+
+	std::vector< std::future<void> > results;
+	results.reserve(count);
+
+	for (std::size_t i = 0; i < count; i++)
+		results.push_back(enqueue([&function, i]() { function(i); }));
+
+	// get() rethrows exceptions thrown by any of the calls
+	for (auto& r : results)
+		r.get();
+}
+
+void ThreadPool::parallelForRange(std::size_t count, std::size_t minimumRangeSize, const std::function<void(std::size_t, std::size_t)>& function)
+{
+	if (count == 0)
+		return;
+
+	// a few ranges per worker even out differences in the cost per element
+	const std::size_t maximumRangeCount = std::max(std::size_t(1), m_workers.size() * 4);
+	const std::size_t rangeCount = std::min(maximumRangeCount, std::max(std::size_t(1), count / std::max(std::size_t(1), minimumRangeSize)));
+
+	parallelFor(rangeCount, [&](std::size_t i)
+	{
+		function(count * i / rangeCount, count * (i + 1) / rangeCount);
+	});
+}
+
+unsigned int ThreadPool::hardwareThreads()
+{
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void ThreadPool::work()
+{
+	for (;;)
+	{
+		std::function<void()> task;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+
+			if (m_stopping && m_tasks.empty())
+				return;
+
+			task = std::move(m_tasks.front());
+			m_tasks.pop();
+		}
+
+		task();
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+namespace minity
+{
+	// Fixed-size pool of worker threads used for parallel loading tasks
+	class ThreadPool
+	{
+	public:
+		// a thread count of zero uses all available hardware threads
+		ThreadPool(unsigned int threadCount = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		unsigned int size() const;
+
+		template <class F>
+		std::future< std::invoke_result_t<F> > enqueue(F&& function)
+		{
+			using Result = std::invoke_result_t<F>;
+
+			auto task = std::make_shared< std::packaged_task<Result()> >(std::forward<F>(function));
+			std::future<Result> result = task->get_future();
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_tasks.emplace([task]() { (*task)(); });
+			}
+
+			m_condition.notify_one();
+			return result;
+		}
+
+		// runs function(i) for all i in [0,count) on the pool and blocks until all calls have finished
+		void parallelFor(std::size_t count, const std::function<void(std::size_t)>& function);
+
+		// splits [0,count) into contiguous ranges of at least minimumRangeSize elements and runs function(begin,end) for each of them
+		void parallelForRange(std::size_t count, std::size_t minimumRangeSize, const std::function<void(std::size_t, std::size_t)>& function);
+
+		static unsigned int hardwareThreads();
+
+	private:
+		void work();
+
+		std::vector<std::thread> m_workers;
+		std::queue< std::function<void()> > m_tasks;
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		bool m_stopping = false;
+	};
+
+}
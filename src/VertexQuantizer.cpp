@@ -0,0 +1,79 @@
+#include "VertexQuantizer.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace minity;
+using namespace glm;
+
+namespace
+{
+	float angleDegrees(const vec3& a, const vec3& b)
+	{
+		const float la = length(a);
+		const float lb = length(b);
+
+		if (la == 0.0f || lb == 0.0f)
+			return 0.0f;
+
+		return degrees(acos(clamp(dot(a, b) / (la * lb), -1.0f, 1.0f)));
+	}
+}
+
+VertexQuantizer::VertexQuantizer(const vec3& minimumBounds, const vec3& maximumBounds) : m_offset(minimumBounds), m_scale(maximumBounds - minimumBounds)
+{
+	// flat models keep their position on the degenerate axis in the offset
+	for (int i = 0; i < 3; i++)
+	{
+		if (!(m_scale[i] > 0.0f))
+			m_scale[i] = 1.0f;
+	}
+}
+
+vec3 VertexQuantizer::positionOffset() const
+{
+	return m_offset;
+}
+
+vec3 VertexQuantizer::positionScale() const
+{
+	return m_scale;
+}
+
+std::array<std::uint16_t, 4> VertexQuantizer::packPosition(const vec3& position) const
+{
+	const vec3 normalized = clamp((position - m_offset) / m_scale, 0.0f, 1.0f);
+	return { std::uint16_t(std::lround(normalized.x * 65535.0f)), std::uint16_t(std::lround(normalized.y * 65535.0f)), std::uint16_t(std::lround(normalized.z * 65535.0f)), 0 };
+}
+
+std::vector<PackedVertex> VertexQuantizer::pack(const Vertex* vertices, std::size_t vertexCount, QuantizationError& error) const
+{
+	std::vector<PackedVertex> packed(vertexCount);
+	error = QuantizationError();
+
+	for (std::size_t i = 0; i < vertexCount; i++)
+	{
+		const Vertex& v = vertices[i];
+		PackedVertex& p = packed[i];
+
+		p.position = packPosition(v.position);
+		const vec3 decodedPosition = m_offset + vec3(p.position[0], p.position[1], p.position[2]) / 65535.0f * m_scale;
+
+		const vec3 normal = v.normal != vec3(0.0f) ? normalize(v.normal) : v.normal;
+		p.normal = packSnorm3x10_1x2(vec4(normal, 0.0f));
+		p.tangent = packSnorm3x10_1x2(v.tangent);
+		p.texcoord = packHalf2x16(v.texcoord);
+
+		const vec3 positionDifference = abs(decodedPosition - v.position);
+		const vec2 texCoordDifference = abs(unpackHalf2x16(p.texcoord) - v.texcoord);
+
+		error.position = std::max(error.position, std::max(positionDifference.x, std::max(positionDifference.y, positionDifference.z)));
+		error.direction = std::max(error.direction, angleDegrees(vec3(unpackSnorm3x10_1x2(p.normal)), normal));
+		error.direction = std::max(error.direction, angleDegrees(vec3(unpackSnorm3x10_1x2(p.tangent)), vec3(v.tangent)));
+		error.texCoord = std::max(error.texCoord, std::max(texCoordDifference.x, texCoordDifference.y));
+	}
+
+	return packed;
+}
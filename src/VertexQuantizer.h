@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Model.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace minity
+{
+	// 20 byte version of Vertex, decoded by the vertex attribute formats set up in Model::load and by
+	// decodePosition() in model-blocks.glsl
+	struct PackedVertex
+	{
+		// unsigned normalized, relative to the bounds of the model, the fourth component is unused
+		std::array<std::uint16_t, 4> position;
+		// signed normalized GL_INT_2_10_10_10_REV, the tangent with the sign of the bitangent in w
+		glm::uint normal;
+		glm::uint tangent;
+		// two half floats
+		glm::uint texcoord;
+	};
+
+	// largest differences between the packed and the original vertices
+	struct QuantizationError
+	{
+		// in model units
+		float position = 0.0f;
+		// angle in degrees of normals and tangents
+		float direction = 0.0f;
+		float texCoord = 0.0f;
+	};
+
+	// Packs vertices into the compact format and measures the error introduced by it
+	class VertexQuantizer
+	{
+	public:
+		// positions are stored as offset + normalized position * scale, with the offset and scale of the bounds
+		VertexQuantizer(const glm::vec3& minimumBounds, const glm::vec3& maximumBounds);
+
+		glm::vec3 positionOffset() const;
+		glm::vec3 positionScale() const;
+
+		std::array<std::uint16_t, 4> packPosition(const glm::vec3& position) const;
+		std::vector<PackedVertex> pack(const Vertex* vertices, std::size_t vertexCount, QuantizationError& error) const;
+
+	private:
+		glm::vec3 m_offset;
+		glm::vec3 m_scale;
+	};
+
+}
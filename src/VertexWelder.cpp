@@ -0,0 +1,162 @@
+#include "VertexWelder.h"
+
+#include <cmath>
+#include <unordered_map>
+
+using namespace minity;
+using namespace glm;
+
+VertexWelder::VertexWelder(std::size_t expectedCount)
+{
+	std::size_t capacity = 16;
+
+	// keep the load factor at or below one half
+	while (capacity < expectedCount * 2)
+		capacity *= 2;
+
+	rehash(capacity);
+}
+
+std::pair<uint, bool> VertexWelder::insert(uint positionIndex, uint normalIndex, uint texCoordIndex)
+{
+	if ((m_size + 1) * 2 > m_slots.size())
+		rehash(m_slots.size() * 2);
+
+	std::size_t i = std::size_t(hash(positionIndex, normalIndex, texCoordIndex)) & m_mask;
+
+	for (;;)
+	{
+		Slot & slot = m_slots[i];
+
+		if (slot.vertexIndex == emptySlot)
+		{
+			slot.positionIndex = positionIndex;
+			slot.normalIndex = normalIndex;
+			slot.texCoordIndex = texCoordIndex;
+			slot.vertexIndex = uint(m_size++);
+			return std::make_pair(slot.vertexIndex, true);
+		}
+
+		if (slot.positionIndex == positionIndex && slot.normalIndex == normalIndex && slot.texCoordIndex == texCoordIndex)
+			return std::make_pair(slot.vertexIndex, false);
+
+		i = (i + 1) & m_mask;
+	}
+}
+
+std::size_t VertexWelder::size() const
+{
+	return m_size;
+}
+
+std::vector<uint> VertexWelder::weldPositions(const std::vector<vec3>& positions, float epsilon)
+{
+	std::vector<uint> positionMap(positions.size());
+
+	for (std::size_t i = 0; i < positions.size(); i++)
+		positionMap[i] = uint(i);
+
+	if (epsilon <= 0.0f)
+		return positionMap;
+
+	// representatives are kept in per-cell lists; since the cell size equals epsilon, all candidates lie in the 27 surrounding cells
+	auto cellKey = [](const ivec3 & cell)
+	{
+		return (std::uint64_t(std::uint32_t(cell.x) & 0x1fffff) << 42) | (std::uint64_t(std::uint32_t(cell.y) & 0x1fffff) << 21) | std::uint64_t(std::uint32_t(cell.z) & 0x1fffff);
+	};
+
+	// cells are computed in double precision and clamped to the 21 bits of the key, so that large coordinates or a tiny
+	// epsilon do not overflow -- clamping keeps neighbors in neighboring cells, the outermost ones just get crowded
+	auto cellCoordinate = [epsilon](float coordinate)
+	{
+		const double limit = double(1 << 20) - 1.0;
+		double cell = std::floor(double(coordinate) / double(epsilon));
+
+		// also catches NaN
+		if (!(cell >= -limit))
+			cell = -limit;
+		else if (cell > limit)
+			cell = limit;
+
+		return int(cell);
+	};
+
+	const float epsilonSquared = epsilon * epsilon;
+	std::unordered_map<std::uint64_t, uint> cellHeads;
+	std::vector<uint> next(positions.size(), emptySlot);
+
+	cellHeads.reserve(positions.size());
+
+	for (std::size_t i = 1; i < positions.size(); i++)
+	{
+		const vec3 & p = positions[i];
+		const ivec3 cell = ivec3(cellCoordinate(p.x), cellCoordinate(p.y), cellCoordinate(p.z));
+		uint representative = emptySlot;
+
+		for (int z = -1; z <= 1 && representative == emptySlot; z++)
+		{
+			for (int y = -1; y <= 1 && representative == emptySlot; y++)
+			{
+				for (int x = -1; x <= 1 && representative == emptySlot; x++)
+				{
+					auto head = cellHeads.find(cellKey(cell + ivec3(x, y, z)));
+
+					if (head == cellHeads.end())
+						continue;
+
+					for (uint j = head->second; j != emptySlot; j = next[j])
+					{
+						const vec3 d = positions[j] - p;
+
+						if (dot(d, d) <= epsilonSquared)
+						{
+							representative = j;
+							break;
+						}
+					}
+				}
+			}
+		}
+
+		if (representative != emptySlot)
+		{
+			positionMap[i] = representative;
+		}
+		else
+		{
+			auto head = cellHeads.emplace(cellKey(cell), emptySlot).first;
+			next[i] = head->second;
+			head->second = uint(i);
+		}
+	}
+
+	return positionMap;
+}
+
+std::uint64_t VertexWelder::hash(uint positionIndex, uint normalIndex, uint texCoordIndex)
+{
+	std::uint64_t h = (std::uint64_t(positionIndex) << 32 | normalIndex) * 0x9E3779B97F4A7C15ull;
+	h ^= (h >> 32) ^ (std::uint64_t(texCoordIndex) * 0xC2B2AE3D27D4EB4Full);
+	h *= 0x94D049BB133111EBull;
+	return h ^ (h >> 29);
+}
+
+void VertexWelder::rehash(std::size_t capacity)
+{
+	std::vector<Slot> slots(capacity, Slot{ 0, 0, 0, emptySlot });
+	slots.swap(m_slots);
+	m_mask = capacity - 1;
+
+	for (const Slot & slot : slots)
+	{
+		if (slot.vertexIndex == emptySlot)
+			continue;
+
+		std::size_t i = std::size_t(hash(slot.positionIndex, slot.normalIndex, slot.texCoordIndex)) & m_mask;
+
+		while (m_slots[i].vertexIndex != emptySlot)
+			i = (i + 1) & m_mask;
+
+		m_slots[i] = slot;
+	}
+}
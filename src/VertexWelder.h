@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace minity
+{
+	// Assigns consecutive vertex indices to unique (position, normal, texture coordinate) index tuples,
+	// using an open-addressing hash table with linear probing
+	class VertexWelder
+	{
+	public:
+		VertexWelder(std::size_t expectedCount = 0);
+
+		// returns the vertex index of the tuple and whether the tuple was new
+		std::pair<glm::uint, bool> insert(glm::uint positionIndex, glm::uint normalIndex, glm::uint texCoordIndex);
+		std::size_t size() const;
+
+		// maps every position to an earlier, not itself welded position that lies within epsilon of it (or to itself),
+		// using a uniform grid with a cell size of epsilon -- if there are several, the first one found when scanning the
+		// surrounding cells is used, which is not necessarily the closest or earliest; index 0 is the OBJ placeholder and is kept as is
+		static std::vector<glm::uint> weldPositions(const std::vector<glm::vec3>& positions, float epsilon);
+
+	private:
+		struct Slot
+		{
+			glm::uint positionIndex;
+			glm::uint normalIndex;
+			glm::uint texCoordIndex;
+			glm::uint vertexIndex;
+		};
+
+		static const glm::uint emptySlot = 0xffffffffu;
+
+		static std::uint64_t hash(glm::uint positionIndex, glm::uint normalIndex, glm::uint texCoordIndex);
+		void rehash(std::size_t capacity);
+
+		std::vector<Slot> m_slots;
+		std::size_t m_mask = 0;
+		std::size_t m_size = 0;
+	};
+
+}
@@ -1,4 +1,9 @@
 #include <iostream>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
 
 #include <glbinding/Version.h>
 #include <glbinding/Binding.h>
@@ -41,6 +46,33 @@ void error_callback(int errnum, const char * errmsg)
 }
 
 
+// parses the value of an integer option, which must not be negative or larger than the maximum
+bool parseUnsigned(const std::string & text, std::uint64_t maximum, std::uint64_t & value)
+{
+	const char * end = text.data() + text.size();
+	std::uint64_t result = 0;
+	const auto [last, error] = std::from_chars(text.data(), end, result);
+
+	if (error != std::errc() || last != end || result > maximum)
+		return false;
+
+	value = result;
+	return true;
+}
+
+// parses the value of a distance option, which must be a finite number that is not negative
+bool parseDistance(const std::string & text, float & value)
+{
+	char * end = nullptr;
+	const float result = std::strtof(text.c_str(), &end);
+
+	if (text.empty() || end != text.c_str() + text.size() || !std::isfinite(result) || result < 0.0f)
+		return false;
+
+	value = result;
+	return true;
+}
+
 unsigned int loadCubemap(std::vector<std::string> faces)
 {
 	unsigned int textureID;
@@ -118,10 +150,74 @@ int main(int argc, char *argv[])
 		<< "OpenGL Renderer: " << glbinding::aux::ContextInfo::renderer() << std::endl;
 
 	std::string fileName = "./dat/bunny.obj";
+	bool fileNameGiven = false;
+	LoadOptions loadOptions;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument(argv[i]);
+
+		if (argument.rfind("--threads=", 0) == 0)
+		{
+			std::uint64_t threadCount = 0;
 
-	if (argc > 1)
-		fileName = std::string(argv[1]);
-	else
+			if (parseUnsigned(argument.substr(10), 1024, threadCount))
+				loadOptions.threadCount = unsigned(threadCount);
+			else
+				globjects::critical() << "Invalid thread count " << argument.substr(10) << ", expected a number from 0 to 1024 - using the default.";
+		}
+		else if (argument.rfind("--weld=", 0) == 0)
+		{
+			if (!parseDistance(argument.substr(7), loadOptions.weldEpsilon))
+				globjects::critical() << "Invalid weld distance " << argument.substr(7) << ", expected a number that is not negative - using the default.";
+		}
+		else if (argument == "--normals=area")
+			loadOptions.normalWeighting = NormalWeighting::Area;
+		else if (argument == "--normals=angle")
+			loadOptions.normalWeighting = NormalWeighting::Angle;
+		else if (argument == "--pack-vertices")
+			loadOptions.packVertices = true;
+		else if (argument == "--short-indices")
+			loadOptions.shortIndices = true;
+		else if (argument == "--strips")
+			loadOptions.triangleStrips = true;
+		else if (argument == "--optimize-mesh")
+			loadOptions.optimizeVertexCache = true;
+		else if (argument == "--optimize-mesh=overdraw")
+		{
+			loadOptions.optimizeVertexCache = true;
+			loadOptions.reduceOverdraw = true;
+		}
+		else if (argument == "--clusters")
+			loadOptions.buildClusters = true;
+		else if (argument == "--lod")
+			loadOptions.generateLods = true;
+		else if (argument == "--compress-textures")
+			loadOptions.compressTextures = true;
+		else if (argument == "--no-cache")
+			loadOptions.useCache = false;
+		else if (argument.rfind("--memory-budget=", 0) == 0)
+		{
+			// the budget is given in MiB
+			std::uint64_t memoryBudget = 0;
+
+			if (parseUnsigned(argument.substr(16), std::numeric_limits<std::size_t>::max() >> 20, memoryBudget))
+				loadOptions.memoryBudget = std::size_t(memoryBudget) << 20;
+			else
+				globjects::critical() << "Invalid memory budget " << argument.substr(16) << ", expected a size in MiB - using the default.";
+		}
+		else if (argument == "--report")
+			loadOptions.report = true;
+		else if (argument.rfind("--report=", 0) == 0)
+			loadOptions.reportFilename = argument.substr(9);
+		else
+		{
+			fileName = argument;
+			fileNameGiven = true;
+		}
+	}
+
+	if (!fileNameGiven)
 	{
 		const char *filterExtensions[] = { "*.obj" };
 		const char *openfileName = tinyfd_openFileDialog("Open File", "./", 1, filterExtensions, "Wavefront Files (*.obj)", 0);
@@ -140,8 +236,12 @@ int main(int argc, char *argv[])
 	};
 
 	auto scene = std::make_unique<Scene>();
-	scene->model()->load(fileName);
-	scene->skybox()->load(".\\res\\skyboxtex\\cube.obj");
+	scene->model()->load(fileName, loadOptions);
+
+	// the skybox only honors the cache setting, the other options are meant for the model
+	LoadOptions skyboxOptions;
+	skyboxOptions.useCache = loadOptions.useCache;
+	scene->skybox()->load(".\\res\\skyboxtex\\cube.obj", skyboxOptions);
 	scene->skyboxTexture = loadCubemap(faces);
 	auto viewer = std::make_unique<Viewer>(window, scene.get());
 